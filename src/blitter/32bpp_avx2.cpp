@@ -0,0 +1,30 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.cpp Implementation of the AVX2 32 bpp blitters. */
+
+#include "../stdafx.h"
+
+#ifdef WITH_AVX2
+
+#include "32bpp_avx2.hpp"
+
+#define SSE_VERSION 3
+#define SSE_AVX2
+#define SSE_TARGET "avx2"
+#define SSE_BLITTER Blitter_32bppAVX2
+#define SSE_ANIM_BLITTER Blitter_32bppAVX2_Anim
+#include "32bpp_sse_func.hpp"
+
+/** Instantiation of the AVX2 32bpp blitter factory. */
+static FBlitter_32bppAVX2 iFBlitter_32bppAVX2;
+/** Instantiation of the AVX2 32bpp with animation blitter factory. */
+static FBlitter_32bppAVX2_Anim iFBlitter_32bppAVX2_Anim;
+
+#endif /* WITH_AVX2 */
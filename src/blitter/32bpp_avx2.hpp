@@ -0,0 +1,55 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_avx2.hpp AVX2 32 bpp blitters. */
+
+#ifndef BLITTER_32BPP_AVX2_HPP
+#define BLITTER_32BPP_AVX2_HPP
+
+#ifdef WITH_AVX2
+
+#include "32bpp_ssse3.hpp"
+
+/** The optimised 32 bpp blitter drawing with AVX2 instructions (without palette animation). */
+class Blitter_32bppAVX2 : public Blitter_32bppSSSE3 {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-avx2"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter (without palette animation). */
+class FBlitter_32bppAVX2: public BlitterFactory<FBlitter_32bppAVX2> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-avx2"; }
+	/* virtual */ const char *GetDescription() { return "32bpp AVX2 Blitter (no palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2(); }
+	bool IsUsable() { return HasCPUAVX2(); }
+};
+
+/** The 32 bpp blitter with palette animation drawing with AVX2 instructions. */
+class Blitter_32bppAVX2_Anim : public Blitter_32bppSSSE3_Anim {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-avx2-anim"; }
+};
+
+/** Factory for the AVX2 32 bpp blitter with animation. */
+class FBlitter_32bppAVX2_Anim: public BlitterFactory<FBlitter_32bppAVX2_Anim> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-avx2-anim"; }
+	/* virtual */ const char *GetDescription() { return "32bpp AVX2 Animation Blitter (palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppAVX2_Anim(); }
+	bool IsUsable() { return HasCPUAVX2(); }
+};
+
+#endif /* WITH_AVX2 */
+
+#endif /* BLITTER_32BPP_AVX2_HPP */
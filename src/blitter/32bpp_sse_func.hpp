@@ -0,0 +1,604 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file 32bpp_sse_func.hpp Drawing of sprites with SSE instructions for the SSE blitters.
+ *
+ * This file is the body of the source file of every SSE blitter; each of them
+ * builds its own copy of the functions for its instruction set. Before
+ * including it define:
+ * - SSE_VERSION: 2 for SSE2, 3 for SSSE3 and AVX2;
+ * - SSE_AVX2: only for AVX2, which handles eight pixels at once;
+ * - SSE_TARGET: the matching GCC target;
+ * - SSE_BLITTER and SSE_ANIM_BLITTER: the classes of the blitters without
+ *   and with palette animation, whose Draw functions are defined here.
+ * All functions compute exactly what the functions of Blitter_32bppBase
+ * compute for a single pixel.
+ */
+
+#ifndef BLITTER_32BPP_SSE_FUNC_HPP
+#define BLITTER_32BPP_SSE_FUNC_HPP
+
+#if !defined(SSE_VERSION) || !defined(SSE_TARGET) || !defined(SSE_BLITTER) || !defined(SSE_ANIM_BLITTER)
+	#error "Define SSE_VERSION, SSE_TARGET, SSE_BLITTER and SSE_ANIM_BLITTER before including 32bpp_sse_func.hpp"
+#endif
+
+#include "32bpp_optimized.hpp"
+#include <emmintrin.h>
+#if SSE_VERSION >= 3
+	#include <tmmintrin.h>
+#endif
+#ifdef SSE_AVX2
+	#include <immintrin.h>
+#endif
+
+/**
+ * Get the alpha of two pixels, spread over all their channels.
+ * @param px    Four pixels.
+ * @param px_16 The same pixels with 16 bits per channel; the low or high two pixels.
+ * @param high  Whether to get the alpha of the high two pixels, instead of the low two.
+ * @return The alpha of each of the two pixels in all its four 16 bits channels.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m128i AlphaSSE(__m128i px, __m128i px_16, bool high)
+{
+#if SSE_VERSION >= 3
+	(void)px_16;
+	/* Byte 3 is the alpha of the first pixel; -128 clears the high byte of each channel */
+	return high ?
+			_mm_shuffle_epi8(px, _mm_set_epi8(-128, 15, -128, 15, -128, 15, -128, 15, -128, 11, -128, 11, -128, 11, -128, 11)) :
+			_mm_shuffle_epi8(px, _mm_set_epi8(-128, 7, -128, 7, -128, 7, -128, 7, -128, 3, -128, 3, -128, 3, -128, 3));
+#else
+	(void)px;
+	(void)high;
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(px_16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+#endif
+}
+
+/**
+ * Blend two pixels with 16 bits per channel over two pixels of the screen.
+ * @param src   The pixels to draw.
+ * @param alpha Their alpha, from 1 to 254, in every channel.
+ * @param dst   The pixels on the screen.
+ * @return The blended channels; alpha is undefined.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m128i BlendHalfSSE(__m128i src, __m128i alpha, __m128i dst)
+{
+	/* ComposeColourRGBANoCheck divides (src - dst) * alpha as unsigned value, so it rounds down. That is
+	 * (src * alpha + dst * (256 - alpha)) / 256, which is at most 255 * 256 and so fits in 16 bits. */
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, _mm_sub_epi16(_mm_set1_epi16(256), alpha)));
+	return _mm_srli_epi16(sum, 8);
+}
+
+/**
+ * Blend up to four pixels over the pixels of the screen, like Blitter_32bppBase::ComposeColourRGBANoCheck.
+ * @param src The pixels to draw, with an alpha from 1 to 254.
+ * @param dst The pixels on the screen.
+ * @return The blended pixels.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m128i BlendSSE(__m128i src, __m128i dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i src_lo = _mm_unpacklo_epi8(src, zero);
+	__m128i src_hi = _mm_unpackhi_epi8(src, zero);
+
+	__m128i lo = BlendHalfSSE(src_lo, AlphaSSE(src, src_lo, false), _mm_unpacklo_epi8(dst, zero));
+	__m128i hi = BlendHalfSSE(src_hi, AlphaSSE(src, src_hi, true),  _mm_unpackhi_epi8(dst, zero));
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xFF000000));
+}
+
+/**
+ * Darken up to four pixels of the screen by 3/4, like Blitter_32bppBase::MakeTransparent(colour, 3, 4).
+ * @param dst The pixels on the screen.
+ * @return The darkened pixels.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m128i DarkenSSE(__m128i dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i three = _mm_set1_epi16(3);
+
+	__m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), three), 2);
+	__m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), three), 2);
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xFF000000));
+}
+
+/**
+ * Darken up to four pixels of the screen by the alpha of the sprite, like
+ * Blitter_32bppBase::MakeTransparent(colour, 1024 - alpha, 1024).
+ * @param src The pixels of the sprite, for their alpha.
+ * @param dst The pixels on the screen.
+ * @return The darkened pixels.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m128i DarkenAlphaSSE(__m128i src, __m128i dst)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(1024);
+
+	/* (c * 64) * (1024 - a) / 65536 is exactly c * (1024 - a) / 1024, without overflowing 16 bits */
+	__m128i lo = _mm_sub_epi16(full, AlphaSSE(src, _mm_unpacklo_epi8(src, zero), false));
+	__m128i hi = _mm_sub_epi16(full, AlphaSSE(src, _mm_unpackhi_epi8(src, zero), true));
+	lo = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpacklo_epi8(dst, zero), 6), lo);
+	hi = _mm_mulhi_epu16(_mm_slli_epi16(_mm_unpackhi_epi8(dst, zero), 6), hi);
+	return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0xFF000000));
+}
+
+/**
+ * Find the pixels that need no lookup in the palette.
+ * @tparam mode Blitter mode; #BM_COLOUR_REMAP looks up all remapped pixels, #BM_NORMAL only those of an animated colour.
+ * @param m The 'm' channel of up to eight pixels, one in each 16 bits value; zero for missing pixels.
+ * @return Two bits for each pixel, which are set when it needs no lookup.
+ */
+template <BlitterMode mode>
+static inline GNU_TARGET(SSE_TARGET) uint GetPlainPixelsSSE(__m128i m)
+{
+	if (mode == BM_COLOUR_REMAP) return _mm_movemask_epi8(_mm_cmpeq_epi16(m, _mm_setzero_si128()));
+
+	__m128i index = _mm_and_si128(m, _mm_set1_epi16(0xFF));
+	return ~_mm_movemask_epi8(_mm_cmpgt_epi16(index, _mm_set1_epi16(PALETTE_ANIM_START - 1))) & 0xFFFF;
+}
+
+/** Four pixels at once, in an SSE register. */
+struct SSEPixels4 {
+	typedef __m128i Vector;      ///< Register with the pixels.
+	static const uint COUNT = 4; ///< Number of pixels.
+
+	/** Load the pixels. @param p The first pixel. @return The pixels. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Load(const Colour *p) { return _mm_loadu_si128((const __m128i *)p); }
+	/** Store the pixels. @param p The first pixel. @param px The pixels. */
+	static inline GNU_TARGET(SSE_TARGET) void Store(Colour *p, Vector px) { _mm_storeu_si128((__m128i *)p, px); }
+	/** Load the 'm' channel of the pixels. @param n The 'm' channel of the first pixel. @return The channels, in the low 16 bits values. */
+	static inline GNU_TARGET(SSE_TARGET) __m128i LoadMap(const uint16 *n) { return _mm_loadl_epi64((const __m128i *)n); }
+	/** Store the 'm' channel of the pixels. @param n The 'm' channel of the first pixel. @param m The channels, as returned by #LoadMap. */
+	static inline GNU_TARGET(SSE_TARGET) void StoreMap(uint16 *n, __m128i m) { _mm_storel_epi64((__m128i *)n, m); }
+
+	/** See #BlendSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Blend(Vector src, Vector dst) { return BlendSSE(src, dst); }
+	/** See #DarkenSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Darken(Vector dst) { return DarkenSSE(dst); }
+	/** See #DarkenAlphaSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector DarkenAlpha(Vector src, Vector dst) { return DarkenAlphaSSE(src, dst); }
+};
+
+#ifdef SSE_AVX2
+/**
+ * Get the alpha of four pixels, spread over all their channels.
+ * The 256 bits instructions work on two halves of four pixels each.
+ * @param px   Eight pixels.
+ * @param high Whether to get the alpha of the high two pixels of each half, instead of the low two.
+ * @return The alpha of each of the four pixels in all its four 16 bits channels.
+ */
+static inline GNU_TARGET(SSE_TARGET) __m256i AlphaAVX2(__m256i px, bool high)
+{
+	return high ?
+			_mm256_shuffle_epi8(px, _mm256_set_epi8(-128, 15, -128, 15, -128, 15, -128, 15, -128, 11, -128, 11, -128, 11, -128, 11,
+			                                        -128, 15, -128, 15, -128, 15, -128, 15, -128, 11, -128, 11, -128, 11, -128, 11)) :
+			_mm256_shuffle_epi8(px, _mm256_set_epi8(-128, 7, -128, 7, -128, 7, -128, 7, -128, 3, -128, 3, -128, 3, -128, 3,
+			                                        -128, 7, -128, 7, -128, 7, -128, 7, -128, 3, -128, 3, -128, 3, -128, 3));
+}
+
+/** Eight pixels at once, in an AVX register. */
+struct SSEPixels8 {
+	typedef __m256i Vector;      ///< Register with the pixels.
+	static const uint COUNT = 8; ///< Number of pixels.
+
+	/** Load the pixels. @param p The first pixel. @return The pixels. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Load(const Colour *p) { return _mm256_loadu_si256((const __m256i *)p); }
+	/** Store the pixels. @param p The first pixel. @param px The pixels. */
+	static inline GNU_TARGET(SSE_TARGET) void Store(Colour *p, Vector px) { _mm256_storeu_si256((__m256i *)p, px); }
+	/** Load the 'm' channel of the pixels. @param n The 'm' channel of the first pixel. @return The channels. */
+	static inline GNU_TARGET(SSE_TARGET) __m128i LoadMap(const uint16 *n) { return _mm_loadu_si128((const __m128i *)n); }
+	/** Store the 'm' channel of the pixels. @param n The 'm' channel of the first pixel. @param m The channels, as returned by #LoadMap. */
+	static inline GNU_TARGET(SSE_TARGET) void StoreMap(uint16 *n, __m128i m) { _mm_storeu_si128((__m128i *)n, m); }
+
+	/** See #BlendSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Blend(Vector src, Vector dst)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i full = _mm256_set1_epi16(256);
+
+		__m256i alpha = AlphaAVX2(src, false);
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(src, zero), alpha), _mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), _mm256_sub_epi16(full, alpha)));
+		alpha = AlphaAVX2(src, true);
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(src, zero), alpha), _mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), _mm256_sub_epi16(full, alpha)));
+		return _mm256_or_si256(_mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)), _mm256_set1_epi32(0xFF000000));
+	}
+
+	/** See #DarkenSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector Darken(Vector dst)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i three = _mm256_set1_epi16(3);
+
+		__m256i lo = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), three), 2);
+		__m256i hi = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), three), 2);
+		return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(0xFF000000));
+	}
+
+	/** See #DarkenAlphaSSE. */
+	static inline GNU_TARGET(SSE_TARGET) Vector DarkenAlpha(Vector src, Vector dst)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i full = _mm256_set1_epi16(1024);
+
+		__m256i lo = _mm256_mulhi_epu16(_mm256_slli_epi16(_mm256_unpacklo_epi8(dst, zero), 6), _mm256_sub_epi16(full, AlphaAVX2(src, false)));
+		__m256i hi = _mm256_mulhi_epu16(_mm256_slli_epi16(_mm256_unpackhi_epi8(dst, zero), 6), _mm256_sub_epi16(full, AlphaAVX2(src, true)));
+		return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(0xFF000000));
+	}
+};
+#endif /* SSE_AVX2 */
+
+/**
+ * Draw a group of pixels of a run that need no lookup in the palette.
+ * @tparam P           The group of pixels, #SSEPixels4 or #SSEPixels8.
+ * @tparam mode        Blitter mode, #BM_NORMAL or #BM_COLOUR_REMAP.
+ * @tparam animated    Whether to keep the animation buffer up to date.
+ * @tparam translucent Whether the pixels are blended, instead of opaque.
+ * @param dst    The pixels on the screen; moved past the group.
+ * @param src_px The pixels of the sprite; moved past the group.
+ * @param src_n  The 'm' channel of the pixels of the sprite; moved past the group.
+ * @param anim   The animation buffer, when \a animated; moved past the group.
+ * @param m      The 'm' channel of the group, in the low 16 bits values.
+ */
+template <class P, BlitterMode mode, bool animated, bool translucent>
+static inline GNU_TARGET(SSE_TARGET) void DrawGroupSSE(Colour *&dst, const Colour *&src_px, const uint16 *&src_n, uint16 *&anim, __m128i m)
+{
+	typename P::Vector px = P::Load(src_px);
+	P::Store(dst, translucent ? P::Blend(px, P::Load(dst)) : px);
+	if (animated) {
+		/* Only the opaque pixels of the normal mode keep their colour for the palette animation */
+		P::StoreMap(anim, mode == BM_NORMAL && !translucent ? m : _mm_setzero_si128());
+		anim += P::COUNT;
+	}
+	dst += P::COUNT;
+	src_px += P::COUNT;
+	src_n += P::COUNT;
+}
+
+/**
+ * Draw the next pixels of a run at once, when none of them needs a lookup in the palette.
+ * @tparam mode        Blitter mode, #BM_NORMAL or #BM_COLOUR_REMAP.
+ * @tparam animated    Whether to keep the animation buffer up to date.
+ * @tparam translucent Whether the pixels are blended, instead of opaque.
+ * @param dst    The pixels on the screen; moved past the drawn pixels.
+ * @param src_px The pixels of the sprite; moved past the drawn pixels.
+ * @param src_n  The 'm' channel of the pixels of the sprite; moved past the drawn pixels.
+ * @param anim   The animation buffer, when \a animated; moved past the drawn pixels.
+ * @param n      The number of pixels left in the run; lowered by the drawn pixels.
+ * @return True when pixels are drawn.
+ */
+template <BlitterMode mode, bool animated, bool translucent>
+static inline GNU_TARGET(SSE_TARGET) bool DrawPixelsSSE(Colour *&dst, const Colour *&src_px, const uint16 *&src_n, uint16 *&anim, uint &n)
+{
+#ifdef SSE_AVX2
+	if (n >= SSEPixels8::COUNT) {
+		/* When not all eight pixels can be drawn at once, the first four still might */
+		__m128i m = SSEPixels8::LoadMap(src_n);
+		uint plain = GetPlainPixelsSSE<mode>(m);
+		if (plain == 0xFFFF) {
+			DrawGroupSSE<SSEPixels8, mode, animated, translucent>(dst, src_px, src_n, anim, m);
+			n -= SSEPixels8::COUNT;
+			return true;
+		}
+		if ((plain & 0xFF) != 0xFF) return false;
+		DrawGroupSSE<SSEPixels4, mode, animated, translucent>(dst, src_px, src_n, anim, m);
+		n -= SSEPixels4::COUNT;
+		return true;
+	}
+#endif
+	if (n < SSEPixels4::COUNT) return false;
+
+	__m128i m = SSEPixels4::LoadMap(src_n);
+	if (GetPlainPixelsSSE<mode>(m) != 0xFFFF) return false;
+	DrawGroupSSE<SSEPixels4, mode, animated, translucent>(dst, src_px, src_n, anim, m);
+	n -= SSEPixels4::COUNT;
+	return true;
+}
+
+/**
+ * Draw the pixels of a run in groups, for as long as a whole group is left.
+ * @tparam P           The group of pixels, #SSEPixels4 or #SSEPixels8.
+ * @tparam mode        Blitter mode, #BM_NORMAL or #BM_TRANSPARENT.
+ * @tparam translucent Whether the pixels are blended, instead of opaque.
+ * @param dst    The pixels on the screen; moved past the drawn pixels.
+ * @param src_px The pixels of the sprite; moved past the drawn pixels.
+ * @param n      The number of pixels left in the run; lowered by the drawn pixels.
+ */
+template <class P, BlitterMode mode, bool translucent>
+static inline GNU_TARGET(SSE_TARGET) void DrawGroupsSSE(Colour *&dst, const Colour *&src_px, uint &n)
+{
+	for (; n >= P::COUNT; n -= P::COUNT) {
+		if (mode == BM_TRANSPARENT) {
+			P::Store(dst, translucent ? P::DarkenAlpha(P::Load(src_px), P::Load(dst)) : P::Darken(P::Load(dst)));
+		} else {
+			P::Store(dst, translucent ? P::Blend(P::Load(src_px), P::Load(dst)) : P::Load(src_px));
+		}
+		dst += P::COUNT;
+		src_px += P::COUNT;
+	}
+}
+
+/**
+ * Draw the pixels of a run that need no lookup in the palette, as long as at
+ * least four of them are left.
+ * @tparam mode        Blitter mode, #BM_NORMAL or #BM_TRANSPARENT.
+ * @tparam translucent Whether the pixels are blended, instead of opaque.
+ * @param dst    The pixels on the screen; moved past the drawn pixels.
+ * @param src_px The pixels of the sprite; moved past the drawn pixels.
+ * @param n      The number of pixels left in the run; lowered by the drawn pixels.
+ */
+template <BlitterMode mode, bool translucent>
+static inline GNU_TARGET(SSE_TARGET) void DrawRunSSE(Colour *&dst, const Colour *&src_px, uint &n)
+{
+#ifdef SSE_AVX2
+	DrawGroupsSSE<SSEPixels8, mode, translucent>(dst, src_px, n);
+#endif
+	DrawGroupsSSE<SSEPixels4, mode, translucent>(dst, src_px, n);
+}
+
+/**
+ * Draw a sprite of the 32bpp-optimized format with SSE instructions.
+ * It walks the sprite exactly like Blitter_32bppOptimized::Draw and
+ * Blitter_32bppAnim::Draw, but handles four pixels of a run at once where
+ * the pixels need no lookup in the palette.
+ *
+ * @tparam mode     Blitter mode.
+ * @tparam animated Whether to keep the animation buffer up to date.
+ * @param bp         Further blitting parameters.
+ * @param zoom       Zoom level at which we are drawing.
+ * @param palette    The palette to look up remapped colours in.
+ * @param anim       The animation buffer at the top left pixel that is drawn, when \a animated.
+ * @param anim_pitch The width of the animation buffer, when \a animated.
+ */
+template <BlitterMode mode, bool animated>
+static GNU_TARGET(SSE_TARGET) void Draw32bppSSE(const Blitter::BlitterParams *bp, ZoomLevel zoom, const Colour *palette, uint16 *anim, int anim_pitch)
+{
+	typedef Blitter_32bppBase Base;
+	const Blitter_32bppOptimized::SpriteData *src = (const Blitter_32bppOptimized::SpriteData *)bp->sprite;
+
+	const Colour *src_px = (const Colour *)(src->data + src->offset[zoom][0]);
+	const uint16 *src_n  = (const uint16 *)(src->data + src->offset[zoom][1]);
+
+	for (uint i = bp->skip_top; i != 0; i--) {
+		src_px = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_n  = (const uint16 *)((const byte *)src_n  + *(const uint32 *)src_n);
+	}
+
+	Colour *dst = (Colour *)bp->dst + bp->top * bp->pitch + bp->left;
+
+	const byte *remap = bp->remap; // store so we don't have to access it via bp everytime
+
+	for (int y = 0; y < bp->height; y++) {
+		Colour *dst_ln = dst + bp->pitch;
+		uint16 *anim_ln = animated ? anim + anim_pitch : NULL;
+
+		const Colour *src_px_ln = (const Colour *)((const byte *)src_px + *(const uint32 *)src_px);
+		src_px++;
+
+		const uint16 *src_n_ln = (const uint16 *)((const byte *)src_n + *(const uint32 *)src_n);
+		src_n += 2;
+
+		Colour *dst_end = dst + bp->skip_left;
+
+		uint n;
+
+		while (dst < dst_end) {
+			n = *src_n++;
+
+			if (src_px->a == 0) {
+				dst += n;
+				src_px ++;
+				src_n++;
+
+				if (animated && dst > dst_end) anim += dst - dst_end;
+			} else {
+				if (dst + n > dst_end) {
+					uint d = dst_end - dst;
+					src_px += d;
+					src_n += d;
+
+					dst = dst_end - bp->skip_left;
+					dst_end = dst + bp->width;
+
+					n = min<uint>(n - d, (uint)bp->width);
+					goto draw;
+				}
+				dst += n;
+				src_px += n;
+				src_n += n;
+			}
+		}
+
+		dst -= bp->skip_left;
+		dst_end -= bp->skip_left;
+
+		dst_end += bp->width;
+
+		while (dst < dst_end) {
+			n = min<uint>(*src_n++, (uint)(dst_end - dst));
+
+			if (src_px->a == 0) {
+				if (animated) anim += n;
+				dst += n;
+				src_px++;
+				src_n++;
+				continue;
+			}
+
+			draw:;
+
+			switch (mode) {
+				case BM_COLOUR_REMAP:
+					if (src_px->a == 255) {
+						while (n != 0) {
+							if (DrawPixelsSSE<BM_COLOUR_REMAP, animated, false>(dst, src_px, src_n, anim, n)) continue;
+
+							uint m = *src_n;
+							/* In case the m-channel is zero, do not remap this pixel in any way */
+							if (m == 0) {
+								*dst = src_px->data;
+								if (animated) *anim = 0;
+							} else {
+								uint r = remap[GB(m, 0, 8)];
+								if (animated) *anim = r | (m & 0xFF00);
+								if (r != 0) *dst = Base::AdjustBrightness(palette[r], GB(m, 8, 8));
+							}
+							if (animated) anim++;
+							dst++;
+							src_px++;
+							src_n++;
+							n--;
+						}
+					} else {
+						while (n != 0) {
+							if (DrawPixelsSSE<BM_COLOUR_REMAP, animated, true>(dst, src_px, src_n, anim, n)) continue;
+
+							uint m = *src_n;
+							if (m == 0) {
+								*dst = Base::ComposeColourRGBANoCheck(src_px->r, src_px->g, src_px->b, src_px->a, *dst);
+							} else {
+								uint r = remap[GB(m, 0, 8)];
+								if (r != 0) *dst = Base::ComposeColourPANoCheck(Base::AdjustBrightness(palette[r], GB(m, 8, 8)), src_px->a, *dst);
+							}
+							if (animated) *anim++ = 0;
+							dst++;
+							src_px++;
+							src_n++;
+							n--;
+						}
+					}
+					break;
+
+				case BM_TRANSPARENT:
+					/* TODO -- We make an assumption here that the remap in fact is transparency, not some colour.
+					 *  This is never a problem with the code we produce, but newgrfs can make it fail... or at least:
+					 *  we produce a result the newgrf maker didn't expect ;) */
+
+					/* Make the current colour a bit more black, so it looks like this image is transparent */
+					src_n += n;
+					if (animated) {
+						for (uint i = 0; i < n; i++) anim[i] = 0;
+						anim += n;
+					}
+					if (src_px->a == 255) {
+						DrawRunSSE<BM_TRANSPARENT, false>(dst, src_px, n);
+						for (; n != 0; n--) {
+							dst->data = _mm_cvtsi128_si32(DarkenSSE(_mm_cvtsi32_si128(dst->data)));
+							dst++;
+							src_px++;
+						}
+					} else {
+						DrawRunSSE<BM_TRANSPARENT, true>(dst, src_px, n);
+						for (; n != 0; n--) {
+							dst->data = _mm_cvtsi128_si32(DarkenAlphaSSE(_mm_cvtsi32_si128(src_px->data), _mm_cvtsi32_si128(dst->data)));
+							dst++;
+							src_px++;
+						}
+					}
+					break;
+
+				default:
+					if (!animated) {
+						src_n += n;
+						if (src_px->a == 255) {
+							DrawRunSSE<BM_NORMAL, false>(dst, src_px, n);
+							for (; n != 0; n--) *dst++ = *src_px++;
+						} else {
+							DrawRunSSE<BM_NORMAL, true>(dst, src_px, n);
+							for (; n != 0; n--) {
+								dst->data = _mm_cvtsi128_si32(BlendSSE(_mm_cvtsi32_si128(src_px->data), _mm_cvtsi32_si128(dst->data)));
+								dst++;
+								src_px++;
+							}
+						}
+					} else if (src_px->a == 255) {
+						while (n != 0) {
+							if (DrawPixelsSSE<BM_NORMAL, animated, false>(dst, src_px, src_n, anim, n)) continue;
+
+							/* Above PALETTE_ANIM_START is palette animation */
+							uint m = GB(*src_n, 0, 8);
+							*anim++ = *src_n;
+							*dst++ = (m >= PALETTE_ANIM_START) ? Base::AdjustBrightness(palette[m], GB(*src_n, 8, 8)) : src_px->data;
+							src_px++;
+							src_n++;
+							n--;
+						}
+					} else {
+						while (n != 0) {
+							if (DrawPixelsSSE<BM_NORMAL, animated, true>(dst, src_px, src_n, anim, n)) continue;
+
+							uint m = GB(*src_n, 0, 8);
+							*anim++ = 0;
+							if (m >= PALETTE_ANIM_START) {
+								*dst = Base::ComposeColourPANoCheck(Base::AdjustBrightness(palette[m], GB(*src_n, 8, 8)), src_px->a, *dst);
+							} else {
+								*dst = Base::ComposeColourRGBANoCheck(src_px->r, src_px->g, src_px->b, src_px->a, *dst);
+							}
+							dst++;
+							src_px++;
+							src_n++;
+							n--;
+						}
+					}
+					break;
+			}
+		}
+
+		if (animated) anim = anim_ln;
+		dst = dst_ln;
+		src_px = src_px_ln;
+		src_n  = src_n_ln;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer. Calls adequate templated function.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void SSE_BLITTER::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	switch (mode) {
+		default: NOT_REACHED();
+		case BM_NORMAL:       Draw32bppSSE<BM_NORMAL,       false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+		case BM_COLOUR_REMAP: Draw32bppSSE<BM_COLOUR_REMAP, false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+		case BM_TRANSPARENT:  Draw32bppSSE<BM_TRANSPARENT,  false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+	}
+}
+
+/**
+ * Draws a sprite to a (screen) buffer, and keeps the animation buffer up to date.
+ *
+ * @param bp further blitting parameters
+ * @param mode blitter mode
+ * @param zoom zoom level at which we are drawing
+ */
+void SSE_ANIM_BLITTER::Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom)
+{
+	if (_screen_disable_anim) {
+		/* This means our output is not to the screen, so we can't be doing any animation stuff, so draw like the blitter without animation */
+		switch (mode) {
+			default: NOT_REACHED();
+			case BM_NORMAL:       Draw32bppSSE<BM_NORMAL,       false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+			case BM_COLOUR_REMAP: Draw32bppSSE<BM_COLOUR_REMAP, false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+			case BM_TRANSPARENT:  Draw32bppSSE<BM_TRANSPARENT,  false>(bp, zoom, _cur_palette.palette, NULL, 0); return;
+		}
+	}
+
+	uint16 *anim = this->anim_buf + ((uint32 *)bp->dst - (uint32 *)_screen.dst_ptr) + bp->top * this->anim_buf_width + bp->left;
+
+	switch (mode) {
+		default: NOT_REACHED();
+		case BM_NORMAL:       Draw32bppSSE<BM_NORMAL,       true>(bp, zoom, this->palette.palette, anim, this->anim_buf_width); return;
+		case BM_COLOUR_REMAP: Draw32bppSSE<BM_COLOUR_REMAP, true>(bp, zoom, this->palette.palette, anim, this->anim_buf_width); return;
+		case BM_TRANSPARENT:  Draw32bppSSE<BM_TRANSPARENT,  true>(bp, zoom, this->palette.palette, anim, this->anim_buf_width); return;
+	}
+}
+
+#endif /* BLITTER_32BPP_SSE_FUNC_HPP */
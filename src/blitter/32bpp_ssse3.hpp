@@ -0,0 +1,55 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file 32bpp_ssse3.hpp SSSE3 32 bpp blitters. */
+
+#ifndef BLITTER_32BPP_SSSE3_HPP
+#define BLITTER_32BPP_SSSE3_HPP
+
+#ifdef WITH_SSE
+
+#include "32bpp_sse2.hpp"
+
+/** The optimised 32 bpp blitter drawing with SSSE3 instructions (without palette animation). */
+class Blitter_32bppSSSE3 : public Blitter_32bppSSE2 {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-ssse3"; }
+};
+
+/** Factory for the SSSE3 32 bpp blitter (without palette animation). */
+class FBlitter_32bppSSSE3: public BlitterFactory<FBlitter_32bppSSSE3> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-ssse3"; }
+	/* virtual */ const char *GetDescription() { return "32bpp SSSE3 Blitter (no palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppSSSE3(); }
+	bool IsUsable() { return HasCPUSSSE3(); }
+};
+
+/** The 32 bpp blitter with palette animation drawing with SSSE3 instructions. */
+class Blitter_32bppSSSE3_Anim : public Blitter_32bppSSE2_Anim {
+public:
+	/* virtual */ void Draw(Blitter::BlitterParams *bp, BlitterMode mode, ZoomLevel zoom);
+
+	/* virtual */ const char *GetName() { return "32bpp-ssse3-anim"; }
+};
+
+/** Factory for the SSSE3 32 bpp blitter with animation. */
+class FBlitter_32bppSSSE3_Anim: public BlitterFactory<FBlitter_32bppSSSE3_Anim> {
+public:
+	/* virtual */ const char *GetName() { return "32bpp-ssse3-anim"; }
+	/* virtual */ const char *GetDescription() { return "32bpp SSSE3 Animation Blitter (palette animation)"; }
+	/* virtual */ Blitter *CreateInstance() { return new Blitter_32bppSSSE3_Anim(); }
+	bool IsUsable() { return HasCPUSSSE3(); }
+};
+
+#endif /* WITH_SSE */
+
+#endif /* BLITTER_32BPP_SSSE3_HPP */
@@ -121,6 +121,20 @@ public:
 		return NULL;
 	}
 
+	/**
+	 * Select the fastest 32bpp blitter with palette animation that can be used on this computer.
+	 * @return The blitter, or NULL when there is none.
+	 * @post Sets the blitter so GetCurrentBlitter() returns it too.
+	 */
+	static Blitter *Select32bppAnimBlitter()
+	{
+		static const char * const names[] = { "32bpp-avx2-anim", "32bpp-ssse3-anim", "32bpp-sse2-anim", "32bpp-anim" };
+		for (uint i = 0; i < lengthof(names); i++) {
+			if (GetBlitters().count(names[i]) != 0) return SelectBlitter(names[i]);
+		}
+		return NULL;
+	}
+
 	/**
 	 * Get the current active blitter (always set by calling SelectBlitter).
 	 */
@@ -165,12 +179,22 @@ public:
 template <class T>
 class BlitterFactory: public BlitterFactoryBase {
 public:
-	BlitterFactory() { this->RegisterBlitter(((T *)this)->GetName()); }
+	BlitterFactory()
+	{
+		if (((T *)this)->IsUsable()) this->RegisterBlitter(((T *)this)->GetName());
+	}
 
 	/**
 	 * Get the long, human readable, name for the Blitter-class.
 	 */
 	const char *GetName();
+
+	/**
+	 * Whether the blitter can be used on this computer; blitters that cannot
+	 * are not registered, e.g. when the CPU lacks the instructions they need.
+	 * @return True when the blitter can be used.
+	 */
+	bool IsUsable() { return true; }
 };
 
 extern char *_ini_blitter;
@@ -109,6 +109,7 @@ static inline int GetBridgePixelHeight(TileIndex tile)
 static inline void ClearSingleBridgeMiddle(TileIndex t, Axis a)
 {
 	assert(MayHaveBridgeAbove(t));
+	NotifyTileChange(t);
 	ClrBit(_m[t].m6, 6 + a);
 }
 
@@ -132,6 +133,7 @@ static inline void ClearBridgeMiddle(TileIndex t)
 static inline void SetBridgeMiddle(TileIndex t, Axis a)
 {
 	assert(MayHaveBridgeAbove(t));
+	NotifyTileChange(t);
 	SetBit(_m[t].m6, 6 + a);
 }
 
@@ -147,6 +149,7 @@ static inline void SetBridgeMiddle(TileIndex t, Axis a)
  */
 static inline void MakeBridgeRamp(TileIndex t, Owner o, BridgeType bridgetype, DiagDirection d, TransportType tt, uint rt)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_TUNNELBRIDGE);
 	SetTileOwner(t, o);
 	_m[t].m2 = 0;
@@ -97,6 +97,7 @@ static inline uint GetClearDensity(TileIndex t)
 static inline void AddClearDensity(TileIndex t, int d)
 {
 	assert(IsTileType(t, MP_CLEAR)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m5 += d;
 }
 
@@ -109,6 +110,7 @@ static inline void AddClearDensity(TileIndex t, int d)
 static inline void SetClearDensity(TileIndex t, uint d)
 {
 	assert(IsTileType(t, MP_CLEAR));
+	NotifyTileChange(t);
 	SB(_m[t].m5, 0, 2, d);
 }
 
@@ -134,6 +136,7 @@ static inline uint GetClearCounter(TileIndex t)
 static inline void AddClearCounter(TileIndex t, int c)
 {
 	assert(IsTileType(t, MP_CLEAR)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m5 += c << 5;
 }
 
@@ -146,6 +149,7 @@ static inline void AddClearCounter(TileIndex t, int c)
 static inline void SetClearCounter(TileIndex t, uint c)
 {
 	assert(IsTileType(t, MP_CLEAR)); // XXX incomplete
+	NotifyTileChange(t);
 	SB(_m[t].m5, 5, 3, c);
 }
 
@@ -160,6 +164,7 @@ static inline void SetClearCounter(TileIndex t, uint c)
 static inline void SetClearGroundDensity(TileIndex t, ClearGround type, uint density)
 {
 	assert(IsTileType(t, MP_CLEAR)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m5 = 0 << 5 | type << 2 | density;
 }
 
@@ -185,6 +190,7 @@ static inline uint GetFieldType(TileIndex t)
 static inline void SetFieldType(TileIndex t, uint f)
 {
 	assert(GetClearGround(t) == CLEAR_FIELDS); // XXX incomplete
+	NotifyTileChange(t);
 	SB(_m[t].m3, 0, 4, f);
 }
 
@@ -209,6 +215,7 @@ static inline IndustryID GetIndustryIndexOfField(TileIndex t)
 static inline void SetIndustryIndexOfField(TileIndex t, IndustryID i)
 {
 	assert(GetClearGround(t) == CLEAR_FIELDS);
+	NotifyTileChange(t);
 	_m[t].m2 = i;
 }
 
@@ -235,6 +242,7 @@ static inline uint GetFenceSE(TileIndex t)
 static inline void SetFenceSE(TileIndex t, uint h)
 {
 	assert(IsClearGround(t, CLEAR_FIELDS));
+	NotifyTileChange(t);
 	SB(_m[t].m4, 2, 3, h);
 }
 
@@ -260,6 +268,7 @@ static inline uint GetFenceSW(TileIndex t)
 static inline void SetFenceSW(TileIndex t, uint h)
 {
 	assert(IsClearGround(t, CLEAR_FIELDS));
+	NotifyTileChange(t);
 	SB(_m[t].m4, 5, 3, h);
 }
 
@@ -285,6 +294,7 @@ static inline uint GetFenceNE(TileIndex t)
 static inline void SetFenceNE(TileIndex t, uint h)
 {
 	assert(IsClearGround(t, CLEAR_FIELDS));
+	NotifyTileChange(t);
 	SB(_m[t].m3, 5, 3, h);
 }
 
@@ -310,6 +320,7 @@ static inline uint GetFenceNW(TileIndex t)
 static inline void SetFenceNW(TileIndex t, uint h)
 {
 	assert(IsClearGround(t, CLEAR_FIELDS));
+	NotifyTileChange(t);
 	SB(_m[t].m6, 2, 3, h);
 }
 
@@ -322,6 +333,7 @@ static inline void SetFenceNW(TileIndex t, uint h)
  */
 static inline void MakeClear(TileIndex t, ClearGround g, uint density)
 {
+	NotifyTileChange(t);
 	/* If this is a non-bridgeable tile, clear the bridge bits while the rest
 	 * of the tile information is still here. */
 	if (!MayHaveBridgeAbove(t)) SB(_m[t].m6, 6, 2, 0);
@@ -346,6 +358,7 @@ static inline void MakeClear(TileIndex t, ClearGround g, uint density)
  */
 static inline void MakeField(TileIndex t, uint field_type, IndustryID industry)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_CLEAR);
 	_m[t].m1 = 0;
 	SetTileOwner(t, OWNER_NONE);
@@ -366,6 +379,7 @@ static inline void MakeField(TileIndex t, uint field_type, IndustryID industry)
 static inline void MakeSnow(TileIndex t, uint density = 0)
 {
 	assert(GetClearGround(t) != CLEAR_SNOW);
+	NotifyTileChange(t);
 	SetBit(_m[t].m3, 4);
 	if (GetRawClearGround(t) == CLEAR_FIELDS) {
 		SetClearGroundDensity(t, CLEAR_GRASS, density);
@@ -382,6 +396,7 @@ static inline void MakeSnow(TileIndex t, uint density = 0)
 static inline void ClearSnow(TileIndex t)
 {
 	assert(GetClearGround(t) == CLEAR_SNOW);
+	NotifyTileChange(t);
 	ClrBit(_m[t].m3, 4);
 	SetClearDensity(t, 3);
 }
@@ -26,6 +26,7 @@
 #include "signal_func.h"
 #include "core/backup_type.hpp"
 #include "object_base.h"
+#include "pbs.h"
 
 #include "table/strings.h"
 
@@ -353,6 +354,20 @@ CommandFlags GetCommandFlags(uint32 cmd)
 	return _command_proc_table[cmd & CMD_ID_MASK].flags;
 }
 
+/*!
+ * This function mask the parameter with CMD_ID_MASK and returns
+ * the type which belongs to the given command.
+ *
+ * @param cmd The integer value of the command
+ * @return The type of this command
+ */
+CommandType GetCommandType(uint32 cmd)
+{
+	assert(IsValidCommand(cmd));
+
+	return _command_proc_table[cmd & CMD_ID_MASK].type;
+}
+
 /*!
  * This function mask the parameter with CMD_ID_MASK and returns
  * the name which belongs to the given command.
@@ -460,6 +475,8 @@ CommandCost DoCommand(TileIndex tile, uint32 p1, uint32 p2, DoCommandFlag flags,
 	 * themselves to the cost object at some point */
 	if (_docommand_recursive == 1) _cleared_object_areas.Clear();
 	res = proc(tile, flags, p1, p2, text);
+	/* The command might have changed the track layout. */
+	InvalidateReservationCache();
 	if (res.Failed()) {
 error:
 		_docommand_recursive--;
@@ -685,6 +702,7 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	_cleared_object_areas.Clear();
 	ClearStorageChanges(false);
 	CommandCost res2 = proc(tile, flags | DC_EXEC, p1, p2, text);
+	InvalidateReservationCache();
 
 	if (cmd_id == CMD_COMPANY_CTRL) {
 		cur_company.Trash();
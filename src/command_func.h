@@ -50,6 +50,7 @@ extern Money _additional_cash_required;
 
 bool IsValidCommand(uint32 cmd);
 CommandFlags GetCommandFlags(uint32 cmd);
+CommandType GetCommandType(uint32 cmd);
 const char *GetCommandName(uint32 cmd);
 Money GetAvailableMoneyForCommand();
 bool IsCommandAllowedWhilePaused(uint32 cmd);
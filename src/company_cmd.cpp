@@ -801,6 +801,7 @@ CommandCost CmdCompanyCtrl(TileIndex tile, DoCommandFlag flags, uint32 p1, uint3
 	CompanyID company_id = (CompanyID)GB(p1, 16, 8);
 #ifdef ENABLE_NETWORK
 	ClientID client_id = (ClientID)p2;
+	if (_network_server && (flags & DC_EXEC)) NetworkInvalidateServerInfo();
 #endif /* ENABLE_NETWORK */
 
 	switch (GB(p1, 0, 16)) {
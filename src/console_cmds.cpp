@@ -38,6 +38,9 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "pathfinder/pf_stats.h"
+#include "saveload/saveload_profile.h"
+#include "video/video_driver.hpp"
 
 #ifdef ENABLE_NETWORK
 	#include "table/strings.h"
@@ -148,6 +151,27 @@ DEF_CONSOLE_HOOK(ConHookNewGRFDeveloperTool)
 	return CHR_HIDE;
 }
 
+/**
+ * Check whether the game runs without user interface and without clients,
+ * so the game can be replaced without any window or client noticing.
+ * @return True when the game runs headless.
+ */
+DEF_CONSOLE_HOOK(ConHookHeadless)
+{
+#ifdef ENABLE_NETWORK
+	if (_networking && (!_network_dedicated || _network_game_info.clients_on != 0)) {
+		if (echo) IConsoleError("This command is forbidden in multiplayer.");
+		return CHR_DISALLOW;
+	}
+	if (_network_dedicated) return CHR_ALLOW;
+#endif /* ENABLE_NETWORK */
+	if (strcmp(_video_driver->GetName(), "null") != 0) {
+		if (echo) IConsoleError("This command is only available on a dedicated server or with the null video driver.");
+		return CHR_DISALLOW;
+	}
+	return CHR_ALLOW;
+}
+
 /**
  * Show help for the console.
  * @param str String to print in the console.
@@ -1328,6 +1352,198 @@ DEF_CONSOLE_CMD(ConGetDate)
 	return true;
 }
 
+/** Print the statistics of the path finder searches of trains, road vehicles and ships. */
+static void PrintPathfinderStats()
+{
+	static const char * const names[] = { "Trains", "Road vehicles", "Ships" };
+	assert_compile(lengthof(names) == VEH_AIRCRAFT);
+
+	for (VehicleType type = VEH_TRAIN; type < VEH_AIRCRAFT; type++) {
+		const PathfinderStats *stats = &_pathfinder_stats[type];
+		IConsolePrintF(CC_DEFAULT, "%s: %u calls, " OTTD_PRINTF64 " nodes, " OTTD_PRINTF64 " cache hits, " OTTD_PRINTF64 " cost calculations, %u max-node aborts, %u not found",
+				names[type], stats->calls, (int64)stats->nodes, (int64)stats->cache_hits, (int64)stats->cost_calcs, stats->aborts, stats->not_found);
+		IConsolePrintF(CC_DEFAULT, "  time: p50 < %u us, p90 < %u us, p99 < %u us, max %u us, total " OTTD_PRINTF64 " ms",
+				stats->GetTimePercentile(50), stats->GetTimePercentile(90), stats->GetTimePercentile(99), stats->max_us, (int64)(stats->total_us / 1000));
+	}
+}
+
+DEF_CONSOLE_CMD(ConPathfinderStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the statistics of the YAPF searches per vehicle type. Usage: 'pf_stats [reset]'");
+		IConsoleHelp("'reset' clears the statistics. Times are approximate; percentiles are rounded up to a power of two");
+		return true;
+	}
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		ResetPathfinderStats();
+		IConsolePrint(CC_DEFAULT, "Path finder statistics cleared.");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	PrintPathfinderStats();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderRecord)
+{
+	if (argc == 0) {
+		IConsoleHelp("Record the path finder requests of all vehicles to a file in the save directory. Usage: 'pf_record <filename>'");
+		IConsoleHelp("If filename is omitted, a running recording is stopped. Save the game when starting a recording to be able to replay it");
+		return true;
+	}
+
+	if (argc == 1) {
+		if (_pathfinder_record_file == NULL) {
+			IConsoleError("no path finder recording is running");
+			return true;
+		}
+		StopPathfinderRecording();
+		IConsolePrint(CC_DEFAULT, "Path finder recording stopped.");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	if (StartPathfinderRecording(argv[1])) {
+		IConsolePrintF(CC_DEFAULT, "Path finder recording started to: %s", argv[1]);
+	} else {
+		IConsoleError("could not open file");
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderReplay)
+{
+	if (argc == 0) {
+		IConsoleHelp("Replay recorded path finder requests from the save directory against the current game and time them. Usage: 'pf_replay <filename>'");
+		IConsoleHelp("Load the game that was saved when the recording started first. The path finder statistics are reset before the replay");
+		return true;
+	}
+
+	if (argc != 2) return false;
+
+	ResetPathfinderStats();
+
+	PathfinderReplayResult result;
+	if (!ReplayPathfinderRequests(argv[1], &result)) {
+		IConsoleError("could not open file");
+		return true;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Replayed %u of %u requests in " OTTD_PRINTF64 " ms, %u with a different result.",
+			result.requests - result.skipped, result.requests, (int64)(result.time_us / 1000), result.different);
+	PrintPathfinderStats();
+	return true;
+}
+
+/** Print the profile of the last savegame that was saved or loaded while profiling. */
+static void PrintSaveLoadProfile()
+{
+	const SaveLoadProfile *profile = &_savegame_profile;
+	if (profile->format == NULL) {
+		IConsolePrint(CC_DEFAULT, "No savegame has been saved or loaded while profiling.");
+		return;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "%s a '%s' savegame:", profile->save ? "Saved" : "Loaded", profile->format);
+	IConsolePrint(CC_DEFAULT, "  chunk         size   compressed       time");
+
+	uint64 size = 0;
+	uint64 time_us = 0;
+	for (const SaveLoadChunkProfile *chunk = profile->chunks.Begin(); chunk != profile->chunks.End(); chunk++) {
+		char packed[16];
+		if (profile->save) {
+			seprintf(packed, lastof(packed), "%u", (uint)chunk->packed_size);
+		} else {
+			strecpy(packed, "-", lastof(packed));
+		}
+		IConsolePrintF(CC_DEFAULT, "  %c%c%c%c %12u %12s %7u us",
+				chunk->id >> 24, chunk->id >> 16, chunk->id >> 8, chunk->id, (uint)chunk->size, packed, chunk->time_us);
+		size += chunk->size;
+		time_us += chunk->time_us;
+	}
+
+	IConsolePrintF(CC_DEFAULT, "  total " OTTD_PRINTF64 " bytes in " OTTD_PRINTF64 " ms, " OTTD_PRINTF64 " bytes in the savegame file",
+			(int64)size, (int64)(time_us / 1000), (int64)profile->packed_size);
+	if (profile->save) {
+		IConsolePrintF(CC_DEFAULT, "  compressing and writing: %u ms", profile->write_us / 1000);
+	} else {
+		IConsolePrintF(CC_DEFAULT, "  fixing pointers: %u ms, AfterLoadGame: %u ms", profile->fix_pointers_us / 1000, profile->after_load_us / 1000);
+	}
+}
+
+DEF_CONSOLE_CMD(ConSaveLoadProfile)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the profile of the last savegame that was saved or loaded. Usage: 'sl_profile [on | off]'");
+		IConsoleHelp("'on' and 'off' switch profiling; savegames are not saved in the background while profiling. Times are approximate");
+		return true;
+	}
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "on") == 0) {
+			_savegame_profiling = true;
+		} else if (strcmp(argv[1], "off") == 0) {
+			_savegame_profiling = false;
+		} else {
+			return false;
+		}
+		IConsolePrintF(CC_DEFAULT, "Savegame profiling %s.", _savegame_profiling ? "enabled" : "disabled");
+		return true;
+	}
+
+	if (argc != 1) return false;
+
+	if (!_savegame_profiling) IConsolePrint(CC_DEFAULT, "Savegame profiling is disabled; enable it with 'sl_profile on'.");
+	PrintSaveLoadProfile();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConSaveLoadBenchmark)
+{
+	if (argc == 0) {
+		IConsoleHelp("Save and load games with every savegame format and time it. Usage: 'sl_benchmark <count> [<savegame> ...]'");
+		IConsoleHelp("Each savegame of the save directory is loaded, then saved to 'benchmark.sav' and loaded back <count> times per format. Without savegames the current game is used. Afterwards the current game is loaded again");
+		IConsoleHelp("Only the raw loading is timed; the savegames are loaded without the steps of the normal switch to a loaded game, like the game start script");
+		return true;
+	}
+
+	if (argc < 2 || atoi(argv[1]) <= 0) return false;
+	uint count = atoi(argv[1]);
+
+	if (argc == 2 && _game_mode != GM_NORMAL) {
+		IConsoleError("no game is running to benchmark");
+		return true;
+	}
+
+	for (uint i = 2; i < argc; i++) {
+		if (strchr(argv[i], PATHSEPCHAR) != NULL || strchr(argv[i], '/') != NULL) {
+			IConsoleError("savegames must be given by their name in the save directory");
+			return true;
+		}
+	}
+
+	for (uint i = 2; i < max<uint>(argc, 3); i++) {
+		const char *filename = argc > 2 ? argv[i] : NULL;
+
+		IConsolePrintF(CC_DEFAULT, "%s, %u iteration(s) per format:", filename != NULL ? filename : "Current game", count);
+
+		SmallVector<SavegameBenchmarkResult, 8> results;
+		bool success = BenchmarkSavegameFormats(filename, count, &results);
+		for (const SavegameBenchmarkResult *result = results.Begin(); result != results.End(); result++) {
+			IConsolePrintF(CC_DEFAULT, "  %-6s %12u bytes, save %6u ms, raw load %6u ms",
+					result->format, (uint)result->packed_size, result->save_us / 1000, result->load_us / 1000);
+		}
+		if (!success) {
+			IConsolePrintF(CC_ERROR, "Benchmarking failed: %s", GetSaveLoadErrorString() + 3);
+			break;
+		}
+	}
+	return true;
+}
 
 DEF_CONSOLE_CMD(ConAlias)
 {
@@ -1916,6 +2132,11 @@ void IConsoleStdLibRegister()
 	IConsoleCmdRegister("list_settings",ConListSettings);
 	IConsoleCmdRegister("gamelog",      ConGamelogPrint);
 	IConsoleCmdRegister("rescan_newgrf", ConRescanNewGRF);
+	IConsoleCmdRegister("pf_stats",     ConPathfinderStats);
+	IConsoleCmdRegister("pf_record",    ConPathfinderRecord);
+	IConsoleCmdRegister("pf_replay",    ConPathfinderReplay, ConHookNoNetwork);
+	IConsoleCmdRegister("sl_profile",   ConSaveLoadProfile);
+	IConsoleCmdRegister("sl_benchmark", ConSaveLoadBenchmark, ConHookHeadless);
 
 	IConsoleAliasRegister("dir",          "ls");
 	IConsoleAliasRegister("del",          "rm %+");
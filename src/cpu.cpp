@@ -0,0 +1,123 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file cpu.cpp OS/compiler dependant detection of the features of the CPU. */
+
+#include "stdafx.h"
+#include "core/bitmath_func.hpp"
+#include "cpu.h"
+
+#undef CPUID_AVAILABLE
+
+/* cpuid for MSVC, via the intrinsic because VS2005 does not support inline assembly on x64 */
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64)) && !defined(CPUID_AVAILABLE)
+#include <intrin.h>
+void ottd_cpuid(int info[4], int type)
+{
+	__cpuid(info, type);
+}
+#define CPUID_AVAILABLE
+#endif
+
+/* cpuid for all other x86 compilers. Use GCC syntax */
+#if (defined(__i386__) || defined(__x86_64__)) && !defined(CPUID_AVAILABLE)
+void ottd_cpuid(int info[4], int type)
+{
+#if defined(__i386__) && defined(__PIC__)
+	/* With position independent code ebx holds the GOT, so it may not be clobbered */
+	__asm__ __volatile__ (
+			"movl %%ebx, %%edi\n\t"
+			"cpuid\n\t"
+			"xchgl %%edi, %%ebx\n\t"
+			: "=a" (info[0]), "=D" (info[1]), "=c" (info[2]), "=d" (info[3])
+			: "a" (type), "c" (0));
+#else
+	__asm__ __volatile__ ("cpuid"
+			: "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
+			: "a" (type), "c" (0));
+#endif
+}
+#define CPUID_AVAILABLE
+#endif
+
+/* In all other cases there is no cpuid; report no features at all. */
+#if !defined(CPUID_AVAILABLE)
+void ottd_cpuid(int info[4], int type)
+{
+	info[0] = info[1] = info[2] = info[3] = 0;
+}
+#endif
+
+#undef XGETBV_AVAILABLE
+
+/* xgetbv for MSVC; the intrinsic exists since VS2010 SP1 */
+#if defined(_MSC_VER) && _MSC_VER >= 1600 && (defined(_M_IX86) || defined(_M_X64))
+#include <immintrin.h>
+uint64 ottd_xgetbv(uint index)
+{
+	return _xgetbv(index);
+}
+#define XGETBV_AVAILABLE
+#endif
+
+/* xgetbv for all other x86 compilers. Use GCC syntax, and the opcode as old assemblers do not know the mnemonic */
+#if (defined(__i386__) || defined(__x86_64__)) && !defined(XGETBV_AVAILABLE)
+uint64 ottd_xgetbv(uint index)
+{
+	uint32 eax, edx;
+	__asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0"
+			: "=a" (eax), "=d" (edx)
+			: "c" (index));
+	return (uint64)edx << 32 | eax;
+}
+#define XGETBV_AVAILABLE
+#endif
+
+/* In all other cases no state of the processor is known to be enabled. */
+#if !defined(XGETBV_AVAILABLE)
+uint64 ottd_xgetbv(uint index)
+{
+	return 0;
+}
+#endif
+
+/**
+ * Check whether the processor reports a feature flag via CPUID.
+ * @param type The CPUID function (leaf) that contains the flag.
+ * @param reg  The register in which the flag is returned.
+ * @param bit  The bit of the flag in that register.
+ * @return True when the processor has the flag set.
+ */
+bool HasCPUIDFlag(uint type, CPUIDRegister reg, uint bit)
+{
+	int info[4];
+
+	/* Function 0 returns the highest supported function in eax */
+	ottd_cpuid(info, 0);
+	if ((uint)info[CPUID_EAX] < type) return false;
+
+	ottd_cpuid(info, type);
+	return HasBit((uint)info[reg], bit);
+}
+
+/**
+ * Check whether the processor supports the AVX2 instructions, and the
+ * operating system saves the 256 bits registers they use on a task switch.
+ * @return True when AVX2 can be used.
+ */
+bool HasCPUAVX2()
+{
+	/* OSXSAVE tells that xgetbv may be used, AVX that the registers exist */
+	if (!HasCPUIDFlag(1, CPUID_ECX, 27) || !HasCPUIDFlag(1, CPUID_ECX, 28)) return false;
+
+	/* The operating system has to enable both the SSE and the AVX state */
+	if ((ottd_xgetbv(0) & 0x6) != 0x6) return false;
+
+	return HasCPUIDFlag(7, CPUID_EBX, 5);
+}
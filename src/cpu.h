@@ -0,0 +1,46 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file cpu.h Functions related to CPU specific instructions. */
+
+#ifndef CPU_H
+#define CPU_H
+
+/** Registers in which CPUID returns its information, as indices for #HasCPUIDFlag. */
+enum CPUIDRegister {
+	CPUID_EAX, ///< The EAX register.
+	CPUID_EBX, ///< The EBX register.
+	CPUID_ECX, ///< The ECX register.
+	CPUID_EDX, ///< The EDX register.
+};
+
+void ottd_cpuid(int info[4], int type);
+uint64 ottd_xgetbv(uint index);
+bool HasCPUIDFlag(uint type, CPUIDRegister reg, uint bit);
+bool HasCPUAVX2();
+
+/**
+ * Check whether the processor supports the SSE2 instructions.
+ * @return True when SSE2 is supported.
+ */
+static inline bool HasCPUSSE2()
+{
+	return HasCPUIDFlag(1, CPUID_EDX, 26);
+}
+
+/**
+ * Check whether the processor supports the SSSE3 instructions.
+ * @return True when SSSE3 is supported.
+ */
+static inline bool HasCPUSSSE3()
+{
+	return HasCPUIDFlag(1, CPUID_ECX, 9);
+}
+
+#endif /* CPU_H */
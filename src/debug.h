@@ -71,6 +71,12 @@ const char *GetDebugString();
  */
 uint64 ottd_rdtsc();
 
+/**
+ * Get the time of a real time clock (for timing of durations).
+ * @return The time in microseconds.
+ */
+uint64 ottd_microseconds();
+
 /* Used for profiling
  *
  * Usage:
@@ -44,6 +44,7 @@
 #include "core/backup_type.hpp"
 #include "cargo_type.h"
 #include "water.h"
+#include "pbs.h"
 #include "game/game.hpp"
 
 #include "table/strings.h"
@@ -448,6 +449,10 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
 
+		/* The owner of tracks changed, so reservations may end elsewhere for the trains. */
+		InvalidateReservationCache();
+		InvalidateSignalSegmentCache();
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
@@ -91,6 +91,7 @@ IndustryType GetIndustryType(TileIndex tile);
 static inline void SetIndustryCompleted(TileIndex tile, bool isCompleted)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	SB(_m[tile].m1, 7, 1, isCompleted ? 1 :0);
 }
 
@@ -115,6 +116,7 @@ static inline byte GetIndustryConstructionStage(TileIndex tile)
 static inline void SetIndustryConstructionStage(TileIndex tile, byte value)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	SB(_m[tile].m1, 0, 2, value);
 }
 
@@ -152,6 +154,7 @@ static inline IndustryGfx GetIndustryGfx(TileIndex t)
 static inline void SetIndustryGfx(TileIndex t, IndustryGfx gfx)
 {
 	assert(IsTileType(t, MP_INDUSTRY));
+	NotifyTileChange(t);
 	_m[t].m5 = GB(gfx, 0, 8);
 	SB(_m[t].m6, 2, 1, GB(gfx, 8, 1));
 }
@@ -177,6 +180,7 @@ static inline byte GetIndustryConstructionCounter(TileIndex tile)
 static inline void SetIndustryConstructionCounter(TileIndex tile, byte value)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	SB(_m[tile].m1, 2, 2, value);
 }
 
@@ -190,6 +194,7 @@ static inline void SetIndustryConstructionCounter(TileIndex tile, byte value)
 static inline void ResetIndustryConstructionStage(TileIndex tile)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	SB(_m[tile].m1, 0, 4, 0);
 	SB(_m[tile].m1, 7, 1, 0);
 }
@@ -214,6 +219,7 @@ static inline byte GetIndustryAnimationLoop(TileIndex tile)
 static inline void SetIndustryAnimationLoop(TileIndex tile, byte count)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	_m[tile].m4 = count;
 }
 
@@ -240,6 +246,7 @@ static inline byte GetIndustryRandomBits(TileIndex tile)
 static inline void SetIndustryRandomBits(TileIndex tile, byte bits)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	_m[tile].m3 = bits;
 }
 
@@ -267,6 +274,7 @@ static inline byte GetIndustryTriggers(TileIndex tile)
 static inline void SetIndustryTriggers(TileIndex tile, byte triggers)
 {
 	assert(IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 	SB(_m[tile].m6, 3, 3, triggers);
 }
 
@@ -280,6 +288,7 @@ static inline void SetIndustryTriggers(TileIndex tile, byte triggers)
  */
 static inline void MakeIndustry(TileIndex t, IndustryID index, IndustryGfx gfx, uint8 random, WaterClass wc)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_INDUSTRY);
 	_m[t].m1 = 0;
 	_m[t].m2 = index;
@@ -16,6 +16,7 @@
 #include "../window_func.h"
 #include "../window_gui.h"
 #include "../moving_average.h"
+#include "../pathfinder/pf_performance_timer.hpp"
 #include "linkgraph.h"
 #include "demands.h"
 #include "mcf.h"
@@ -27,6 +28,11 @@
  */
 LinkGraph _link_graphs[NUM_CARGO];
 
+/**
+ * Statistics of the joined link graph jobs.
+ */
+LinkGraphJobStats _link_graph_job_stats;
+
 /**
  * Handlers to be run for each job.
  */
@@ -368,7 +374,21 @@ void Node::ExportFlows(CargoID cargo)
  */
 void LinkGraph::Join()
 {
+	CPerformanceTimer perf;
+	perf.Start();
 	this->LinkGraphJob::Join();
+	perf.Stop();
+
+	if (this->GetSize() > 0) {
+		LinkGraphJobStats *stats = &_link_graph_job_stats;
+		uint32 wait_us = perf.Get(1000000);
+		stats->jobs++;
+		stats->nodes += this->GetSize();
+		stats->run_us += this->run_us;
+		stats->max_run_us = max(stats->max_run_us, this->run_us);
+		stats->wait_us += wait_us;
+		stats->max_wait_us = max(stats->max_wait_us, wait_us);
+	}
 
 	for (NodeID node_id = 0; node_id < this->GetSize(); ++node_id) {
 		Node &node = this->GetNode(node_id);
@@ -388,9 +408,14 @@ void LinkGraph::Join()
 /* static */ void LinkGraphJob::RunLinkGraphJob(void *j)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
+	CPerformanceTimer perf;
+	perf.Start();
 	for (HandlerList::iterator i = LinkGraphJob::_handlers.begin(); i != LinkGraphJob::_handlers.end(); ++i) {
 		(*i)->Run(job);
 	}
+	perf.Stop();
+	/* Only read by the game thread after joining the job. */
+	job->run_us = perf.Get(1000000);
 }
 
 /**
@@ -196,6 +196,18 @@ public:
 	virtual void Run(LinkGraphComponent *component) = 0;
 };
 
+/** Statistics of the link graph jobs that were joined. */
+struct LinkGraphJobStats {
+	uint32 jobs;        ///< Number of joined jobs.
+	uint64 nodes;       ///< Total number of nodes of the components of the jobs.
+	uint64 run_us;      ///< Total time the jobs ran in microseconds.
+	uint32 max_run_us;  ///< Time of the longest running job in microseconds.
+	uint64 wait_us;     ///< Total time the game waited for unfinished jobs when joining them in microseconds.
+	uint32 max_wait_us; ///< Longest time the game waited for a job in microseconds.
+};
+
+extern LinkGraphJobStats _link_graph_job_stats;
+
 /**
  * A job to be executed on a link graph component. It inherits a component and
  * keeps a static list of handlers to be run on it. It may or may not run in a
@@ -207,7 +219,7 @@ private:
 
 public:
 
-	LinkGraphJob() : thread(NULL) {}
+	LinkGraphJob() : run_us(0), thread(NULL) {}
 
 	/**
 	 * Destructor; Clean up the thread if it's there.
@@ -234,6 +246,9 @@ public:
 
 	void Join();
 
+protected:
+	uint32 run_us;                  ///< Time the handlers of the job ran in microseconds.
+
 private:
 	static HandlerList _handlers;   ///< Handlers the job is executing.
 	ThreadObject *thread;           ///< Thread the job is running in or NULL if it's running in the main thread.
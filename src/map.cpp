@@ -12,6 +12,7 @@
 #include "stdafx.h"
 #include "debug.h"
 #include "core/alloc_func.hpp"
+#include "core/smallvec_type.hpp"
 #include "water_map.h"
 
 #if defined(_MSC_VER)
@@ -29,6 +30,17 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 Tile *_m = NULL;          ///< Tiles of the map
 TileExtended *_me = NULL; ///< Extended Tiles of the map
 
+byte *_tile_hash_recorded = NULL; ///< Bit for each tile whose hash before its latest change is remembered
+
+/** The hash of a tile before it changed. */
+struct RecordedTileHash {
+	TileIndex tile; ///< The tile that changed.
+	uint32 hash;    ///< The hash of the tile before its first change.
+};
+
+static SmallVector<RecordedTileHash, 256> _recorded_tile_hashes; ///< The tiles that changed since the hash of the map was updated
+static uint32 _map_hash[MAP_HASH_PARTS];                         ///< The hash of each part of the map
+
 
 /**
  * (Re)allocates a map with the given dimension
@@ -60,6 +72,89 @@ void AllocateMap(uint size_x, uint size_y)
 
 	_m = CallocT<Tile>(_map_size);
 	_me = CallocT<TileExtended>(_map_size);
+
+	/* The new map is hashed from scratch when its hash is needed. */
+	free(_tile_hash_recorded);
+	_tile_hash_recorded = NULL;
+	_recorded_tile_hashes.Clear();
+}
+
+/**
+ * Hash the contents of a tile.
+ * @param tile The tile.
+ * @return The hash of the tile and its contents.
+ */
+static uint32 HashTile(TileIndex tile)
+{
+	const Tile *m = &_m[tile];
+	uint32 hash = tile * 0x9E3779B1U;
+	/* Every step is a bijection of each of the values, so any single difference changes the hash. */
+	hash = (hash ^ (m->type_height | m->m1 << 8 | (uint32)m->m2 << 16)) * 16777619U;
+	hash = (hash ^ (m->m3 | m->m4 << 8 | m->m5 << 16 | (uint32)m->m6 << 24)) * 16777619U;
+	hash = (hash ^ _me[tile].m7) * 16777619U;
+	/* Mix the bits, as the hashes of the tiles are added up. */
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6BU;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+/**
+ * Get the part of the map a tile is hashed with.
+ * @param tile The tile.
+ * @return The part, the rows of the map divided in #MAP_HASH_PARTS ranges.
+ */
+static inline uint GetMapHashPart(TileIndex tile)
+{
+	return tile / (MapSize() / MAP_HASH_PARTS);
+}
+
+/**
+ * Remember the hash of a tile before it changes, see NotifyTileChange().
+ * @param tile The tile that changes.
+ */
+void RecordTileHash(TileIndex tile)
+{
+	if (_recorded_tile_hashes.Length() >= MapSize() / 16) {
+		/* Nobody asked for the hash for a long time; hashing the whole map
+		 * again when it is needed is cheaper than recording every change. */
+		free(_tile_hash_recorded);
+		_tile_hash_recorded = NULL;
+		_recorded_tile_hashes.Clear();
+		return;
+	}
+
+	SetBit(_tile_hash_recorded[tile / 8], tile % 8);
+
+	RecordedTileHash *rth = _recorded_tile_hashes.Append();
+	rth->tile = tile;
+	rth->hash = HashTile(tile);
+}
+
+/**
+ * Get the hash of each part of the map. The hash of a part is the sum of the
+ * hashes of its tiles, so it is only updated for the tiles that changed since
+ * the previous call. Only the first call after the map was allocated hashes
+ * the whole map; from then on every change of a tile is recorded.
+ * @return The #MAP_HASH_PARTS hashes of the parts of the map.
+ */
+const uint32 *GetMapHash()
+{
+	if (_tile_hash_recorded == NULL) {
+		_tile_hash_recorded = CallocT<byte>(MapSize() / 8);
+		memset(_map_hash, 0, sizeof(_map_hash));
+		for (TileIndex tile = 0; tile < MapSize(); tile++) {
+			_map_hash[GetMapHashPart(tile)] += HashTile(tile);
+		}
+		return _map_hash;
+	}
+
+	for (const RecordedTileHash *rth = _recorded_tile_hashes.Begin(); rth != _recorded_tile_hashes.End(); rth++) {
+		_map_hash[GetMapHashPart(rth->tile)] += HashTile(rth->tile) - rth->hash;
+		ClrBit(_tile_hash_recorded[rth->tile / 8], rth->tile % 8);
+	}
+	_recorded_tile_hashes.Clear();
+	return _map_hash;
 }
 
 
@@ -13,6 +13,7 @@
 #define MAP_FUNC_H
 
 #include "core/math_func.hpp"
+#include "core/bitmath_func.hpp"
 #include "tile_type.h"
 #include "map_type.h"
 #include "direction_func.h"
@@ -45,6 +46,28 @@ extern TileExtended *_me;
 
 void AllocateMap(uint size_x, uint size_y);
 
+static const uint MAP_HASH_PARTS = 8; ///< Number of parts of the map, consecutive ranges of rows, that are hashed separately.
+
+/**
+ * Bit for each tile whose hash before its latest change is remembered, so
+ * the hash of the map can be updated for it; NULL when the map is not hashed.
+ */
+extern byte *_tile_hash_recorded;
+
+void RecordTileHash(TileIndex tile);
+const uint32 *GetMapHash();
+
+/**
+ * Tell that a tile of the map is about to change. Has to be called
+ * before any write to the arrays of the map, so the hash of the map
+ * can be updated for the tile, see GetMapHash().
+ * @param tile The tile that changes.
+ */
+static inline void NotifyTileChange(TileIndex tile)
+{
+	if (_tile_hash_recorded != NULL && !HasBit(_tile_hash_recorded[tile / 8], tile % 8)) RecordTileHash(tile);
+}
+
 /**
  * Logarithm of the map size along the X side.
  * @note try to avoid using this one
@@ -27,6 +27,8 @@
 #include "window_func.h"
 #include "core/pool_type.hpp"
 #include "game/game.hpp"
+#include "pbs.h"
+#include "signal_func.h"
 
 
 extern TileIndex _cur_tileloop_tile;
@@ -92,6 +94,8 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeBuildingCounts();
 
 	InitializeNPF();
+	InvalidateReservationCache();
+	InvalidateSignalSegmentCache();
 
 	InitializeCompanies();
 	AI::Initialize();
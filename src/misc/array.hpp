@@ -28,35 +28,44 @@ protected:
 	static const uint Tcapacity = B * N; ///< total max number of items
 
 	SuperArray data; ///< array of arrays of items
+	uint used;       ///< number of sub-arrays in use, the ones behind them are empty and kept for reuse
 
 	/** return first sub-array with free space for new item */
 	inline SubArray& FirstFreeSubArray()
 	{
-		uint super_size = data.Length();
-		if (super_size > 0) {
-			SubArray& s = data[super_size - 1];
+		if (used > 0) {
+			SubArray& s = data[used - 1];
 			if (!s.IsFull()) return s;
 		}
+		if (used < data.Length()) return data[used++];
+		used++;
 		return *data.AppendC();
 	}
 
 public:
 	/** implicit constructor */
-	inline SmallArray() { }
+	inline SmallArray() : used(0) { }
 	/** Clear (destroy) all items */
-	inline void Clear() {data.Clear();}
+	inline void Clear() {data.Clear(); used = 0;}
+	/** Destroy all items, but keep the allocated sub-arrays for reuse */
+	inline void Reset()
+	{
+		for (uint i = 0; i < used; i++) data[i].Clear();
+		used = 0;
+	}
+	/** Return number of allocated sub-arrays, including the ones kept for reuse */
+	inline uint NumBlocks() const { return data.Length(); }
 	/** Return actual number of items */
 	inline uint Length() const
 	{
-		uint super_size = data.Length();
-		if (super_size == 0) return 0;
-		uint sub_size = data[super_size - 1].Length();
-		return (super_size - 1) * B + sub_size;
+		if (used == 0) return 0;
+		uint sub_size = data[used - 1].Length();
+		return (used - 1) * B + sub_size;
 	}
 	/** return true if array is empty */
-	inline bool IsEmpty() { return data.IsEmpty(); }
+	inline bool IsEmpty() { return used == 0; }
 	/** return true if array is full */
-	inline bool IsFull() { return data.IsFull() && data[N - 1].IsFull(); }
+	inline bool IsFull() { return used == N && data[N - 1].IsFull(); }
 	/** allocate but not construct new item */
 	inline T *Append() { return FirstFreeSubArray().Append(); }
 	/** allocate and construct new item */
@@ -20,8 +20,9 @@ struct CHashTableSlotT
 	typedef typename Titem_::Key Key;          // make Titem_::Key a property of HashTable
 
 	Titem_ *m_pFirst;
+	uint    m_generation; // generation of the hash table the items of this slot belong to
 
-	inline CHashTableSlotT() : m_pFirst(NULL) {}
+	inline CHashTableSlotT() : m_pFirst(NULL), m_generation(0) {}
 
 	/** hash table slot helper - clears the slot by simple forgetting its items */
 	inline void Clear() {m_pFirst = NULL;}
@@ -147,10 +148,11 @@ protected:
 
 	Slot  m_slots[Tcapacity]; // here we store our data (array of blobs)
 	int   m_num_items;        // item counter
+	uint  m_generation;       // slots of other generations are empty, see Reset()
 
 public:
 	/* default constructor */
-	inline CHashTableT() : m_num_items(0)
+	inline CHashTableT() : m_num_items(0), m_generation(0)
 	{
 	}
 
@@ -170,6 +172,17 @@ protected:
 	/** static helper - return hash for the given item modulo number of slots */
 	inline static int CalcHash(const Titem_& item) {return CalcHash(item.GetKey());}
 
+	/** return the slot for the given hash, empty it first if it was left over from before the last Reset() */
+	inline Slot& GetSlot(int hash)
+	{
+		Slot& slot = m_slots[hash];
+		if (slot.m_generation != m_generation) {
+			slot.Clear();
+			slot.m_generation = m_generation;
+		}
+		return slot;
+	}
+
 public:
 	/** item count */
 	inline int Count() const {return m_num_items;}
@@ -177,11 +190,22 @@ public:
 	/** simple clear - forget all items - used by CSegmentCostCacheT.Flush() */
 	inline void Clear() {for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();}
 
+	/** forget all items without touching the slots - they are emptied when they are used again */
+	inline void Reset()
+	{
+		m_num_items = 0;
+		if (++m_generation == 0) {
+			/* the generation counter wrapped, so very old slots would look valid again */
+			Clear();
+		}
+	}
+
 	/** const item search */
 	const Titem_ *Find(const Tkey& key) const
 	{
 		int hash = CalcHash(key);
 		const Slot& slot = m_slots[hash];
+		if (slot.m_generation != m_generation) return NULL;
 		const Titem_ *item = slot.Find(key);
 		return item;
 	}
@@ -190,7 +214,7 @@ public:
 	Titem_ *Find(const Tkey& key)
 	{
 		int hash = CalcHash(key);
-		Slot& slot = m_slots[hash];
+		Slot& slot = GetSlot(hash);
 		Titem_ *item = slot.Find(key);
 		return item;
 	}
@@ -199,7 +223,7 @@ public:
 	Titem_ *TryPop(const Tkey& key)
 	{
 		int hash = CalcHash(key);
-		Slot& slot = m_slots[hash];
+		Slot& slot = GetSlot(hash);
 		Titem_ *item = slot.Detach(key);
 		if (item != NULL) {
 			m_num_items--;
@@ -220,7 +244,7 @@ public:
 	{
 		const Tkey& key = item.GetKey();
 		int hash = CalcHash(key);
-		Slot& slot = m_slots[hash];
+		Slot& slot = GetSlot(hash);
 		bool ret = slot.Detach(item);
 		if (ret) {
 			m_num_items--;
@@ -239,7 +263,7 @@ public:
 	void Push(Titem_& new_item)
 	{
 		int hash = CalcHash(new_item);
-		Slot& slot = m_slots[hash];
+		Slot& slot = GetSlot(hash);
 		assert(slot.Find(new_item.GetKey()) == NULL);
 		slot.Attach(new_item);
 		m_num_items++;
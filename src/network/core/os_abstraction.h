@@ -168,6 +168,14 @@ static inline void OTTDfreeaddrinfo(struct addrinfo *ai)
 #			include <ifaddrs.h>
 #			define HAVE_GETIFADDRS
 #		endif
+#		if !defined(__MORPHOS__) && !defined(__AMIGA__)
+#			include <sys/uio.h>
+#			define HAVE_WRITEV
+#		endif
+#		if defined(__linux__)
+#			include <sys/epoll.h>
+#			define HAVE_EPOLL
+#		endif
 #		if !defined(INADDR_NONE)
 #			define INADDR_NONE 0xffffffff
 #		endif
@@ -15,9 +15,102 @@
 
 #include "../../stdafx.h"
 #include "../../string_func.h"
+#include "../../thread/thread.h"
 
 #include "packet.h"
 
+/** Size of the buffer of a new packet; most packets are small, others get a buffer of #SEND_MTU bytes when they need it. */
+static const uint PACKET_SMALL_BUFFER_SIZE = 128;
+
+/**
+ * Unused memory blocks of one size, kept for new packets. With many clients
+ * packets are made and deleted all the time; reusing their memory saves the
+ * calls to the allocator for them.
+ * @tparam Tblock_size The size of the blocks.
+ * @tparam Tmax_count  The maximum number of blocks that are kept.
+ */
+template <size_t Tblock_size, uint Tmax_count>
+struct PacketFreeList {
+	void *blocks[Tmax_count]; ///< The unused blocks.
+	uint count;               ///< Number of blocks in #blocks.
+
+	void *Allocate();
+	void Free(void *block);
+};
+
+static PacketFreeList<sizeof(Packet), 1024> _packet_pool;                      ///< Deleted packets, to be reused by new packets.
+static PacketFreeList<PACKET_SMALL_BUFFER_SIZE, 1024> _packet_small_buffer_pool; ///< Small buffers of deleted packets.
+static PacketFreeList<SEND_MTU, 256> _packet_buffer_pool;                       ///< Buffers of #SEND_MTU bytes of deleted packets.
+static ThreadMutex *_packet_pool_mutex = ThreadMutex::New();                    ///< Mutex for the pools, as the savegame and network I/O threads make packets too.
+
+/**
+ * Get a block, reusing an unused one if possible.
+ * @return A block of \a Tblock_size bytes.
+ */
+template <size_t Tblock_size, uint Tmax_count>
+void *PacketFreeList<Tblock_size, Tmax_count>::Allocate()
+{
+	void *block = NULL;
+
+	_packet_pool_mutex->BeginCritical();
+	if (this->count > 0) block = this->blocks[--this->count];
+	_packet_pool_mutex->EndCritical();
+
+	return block != NULL ? block : MallocT<byte>(Tblock_size);
+}
+
+/**
+ * Keep a block that is not used anymore, or free it when enough blocks are kept.
+ * @param block The block of \a Tblock_size bytes.
+ */
+template <size_t Tblock_size, uint Tmax_count>
+void PacketFreeList<Tblock_size, Tmax_count>::Free(void *block)
+{
+	_packet_pool_mutex->BeginCritical();
+	if (this->count < Tmax_count) {
+		this->blocks[this->count++] = block;
+		block = NULL;
+	}
+	_packet_pool_mutex->EndCritical();
+
+	free(block);
+}
+
+/**
+ * Allocate the memory of a packet from the pool.
+ * @param size The size of the packet.
+ * @return The memory for the packet.
+ */
+/* static */ void *Packet::operator new(size_t size)
+{
+	assert(size == sizeof(Packet));
+	return _packet_pool.Allocate();
+}
+
+/**
+ * Return the memory of a packet to the pool.
+ * @param p The memory of the packet.
+ */
+/* static */ void Packet::operator delete(void *p)
+{
+	if (p != NULL) _packet_pool.Free(p);
+}
+
+/**
+ * Move the contents of the small buffer of this packet to a buffer of #SEND_MTU bytes.
+ */
+void Packet::GrowBuffer()
+{
+	assert(this->capacity == PACKET_SMALL_BUFFER_SIZE);
+
+	byte *buffer = (byte *)_packet_buffer_pool.Allocate();
+	memcpy(buffer, this->buffer, PACKET_SMALL_BUFFER_SIZE);
+	_packet_small_buffer_pool.Free(this->buffer);
+
+	this->buffer   = buffer;
+	this->capacity = SEND_MTU;
+}
+
 /**
  * Create a packet that is used to read from a network socket
  * @param cs the socket handler associated with the socket we are reading from
@@ -30,7 +123,8 @@ Packet::Packet(NetworkSocketHandler *cs)
 	this->next   = NULL;
 	this->pos    = 0; // We start reading from here
 	this->size   = 0;
-	this->buffer = MallocT<byte>(SEND_MTU);
+	this->buffer = (byte *)_packet_small_buffer_pool.Allocate();
+	this->capacity = PACKET_SMALL_BUFFER_SIZE;
 }
 
 /**
@@ -45,7 +139,8 @@ Packet::Packet(PacketType type)
 	/* Skip the size so we can write that in before sending the packet */
 	this->pos                  = 0;
 	this->size                 = sizeof(PacketSize);
-	this->buffer               = MallocT<byte>(SEND_MTU);
+	this->buffer               = (byte *)_packet_small_buffer_pool.Allocate();
+	this->capacity             = PACKET_SMALL_BUFFER_SIZE;
 	this->buffer[this->size++] = type;
 }
 
@@ -54,7 +149,11 @@ Packet::Packet(PacketType type)
  */
 Packet::~Packet()
 {
-	free(this->buffer);
+	if (this->capacity == SEND_MTU) {
+		_packet_buffer_pool.Free(this->buffer);
+	} else {
+		_packet_small_buffer_pool.Free(this->buffer);
+	}
 }
 
 /**
@@ -98,6 +197,7 @@ void Packet::Send_bool(bool data)
 void Packet::Send_uint8(uint8 data)
 {
 	assert(this->size < SEND_MTU - sizeof(data));
+	this->Reserve(this->size + sizeof(data));
 	this->buffer[this->size++] = data;
 }
 
@@ -108,6 +208,7 @@ void Packet::Send_uint8(uint8 data)
 void Packet::Send_uint16(uint16 data)
 {
 	assert(this->size < SEND_MTU - sizeof(data));
+	this->Reserve(this->size + sizeof(data));
 	this->buffer[this->size++] = GB(data, 0, 8);
 	this->buffer[this->size++] = GB(data, 8, 8);
 }
@@ -119,6 +220,7 @@ void Packet::Send_uint16(uint16 data)
 void Packet::Send_uint32(uint32 data)
 {
 	assert(this->size < SEND_MTU - sizeof(data));
+	this->Reserve(this->size + sizeof(data));
 	this->buffer[this->size++] = GB(data,  0, 8);
 	this->buffer[this->size++] = GB(data,  8, 8);
 	this->buffer[this->size++] = GB(data, 16, 8);
@@ -132,6 +234,7 @@ void Packet::Send_uint32(uint32 data)
 void Packet::Send_uint64(uint64 data)
 {
 	assert(this->size < SEND_MTU - sizeof(data));
+	this->Reserve(this->size + sizeof(data));
 	this->buffer[this->size++] = GB(data,  0, 8);
 	this->buffer[this->size++] = GB(data,  8, 8);
 	this->buffer[this->size++] = GB(data, 16, 8);
@@ -150,8 +253,10 @@ void Packet::Send_uint64(uint64 data)
 void Packet::Send_string(const char *data)
 {
 	assert(data != NULL);
+	size_t length = strlen(data) + 1;
 	/* The <= *is* valid due to the fact that we are comparing sizes and not the index. */
-	assert(this->size + strlen(data) + 1 <= SEND_MTU);
+	assert(this->size + length <= SEND_MTU);
+	this->Reserve(this->size + length);
 	while ((this->buffer[this->size++] = *data++) != '\0') {}
 }
 
@@ -54,16 +54,32 @@ struct Packet {
 	PacketSize pos;
 	/** The buffer of this packet, of basically variable length up to SEND_MTU. */
 	byte *buffer;
+	/** The size of #buffer; small packets get a smaller buffer than SEND_MTU. */
+	PacketSize capacity;
 
 private:
 	/** Socket we're associated with. */
 	NetworkSocketHandler *cs;
 
+	void GrowBuffer();
+
 public:
 	Packet(NetworkSocketHandler *cs);
 	Packet(PacketType type);
 	~Packet();
 
+	static void *operator new(size_t size);
+	static void operator delete(void *p);
+
+	/**
+	 * Make sure the buffer can hold a number of bytes.
+	 * @param size The number of bytes, at most #SEND_MTU.
+	 */
+	inline void Reserve(size_t size)
+	{
+		if (size > this->capacity) this->GrowBuffer();
+	}
+
 	/* Sending/writing of packets */
 	void PrepareToSend();
 
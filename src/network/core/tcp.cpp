@@ -17,6 +17,12 @@
 #include "../../debug.h"
 
 #include "tcp.h"
+#include "tcp_io_thread.h"
+
+#ifdef HAVE_WRITEV
+/** Maximum number of packets that are handed to the OS at once. */
+static const int SEND_BATCH_SIZE = 32;
+#endif
 
 /**
  * Construct a socket handler for a TCP connection.
@@ -24,13 +30,28 @@
  */
 NetworkTCPSocketHandler::NetworkTCPSocketHandler(SOCKET s) :
 		NetworkSocketHandler(),
-		packet_queue(NULL), packet_recv(NULL),
-		sock(s), writable(false)
+		packet_queue(NULL), packet_queue_end(NULL), packet_recv(NULL),
+		sock(s), writable(false), bytes_sent(0), bytes_received(0)
 {
+#ifdef HAVE_EPOLL
+	this->epoll_fd = -1;
+	this->epoll_data = 0;
+	this->io = NULL;
+#endif
 }
 
 NetworkTCPSocketHandler::~NetworkTCPSocketHandler()
 {
+#ifdef HAVE_EPOLL
+	if (this->io != NULL) {
+		/* The I/O thread sends what is handed over already and closes the socket. */
+		this->io->Release();
+		this->io = NULL;
+		this->sock = INVALID_SOCKET;
+	}
+#endif
+
+	/* This also removes the socket from epoll before it is closed. */
 	this->CloseConnection();
 
 	if (this->sock != INVALID_SOCKET) closesocket(this->sock);
@@ -42,12 +63,21 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
 	this->writable = false;
 	NetworkSocketHandler::CloseConnection(error);
 
+#ifdef HAVE_EPOLL
+	if (this->epoll_fd != -1) {
+		/* A closed descriptor is only dropped by epoll when no duplicate of it is open anymore. */
+		if (epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, this->sock, NULL) != 0) DEBUG(net, 0, "epoll_ctl failed with error %d", errno);
+		this->epoll_fd = -1;
+	}
+#endif
+
 	/* Free all pending and partially received packets */
 	while (this->packet_queue != NULL) {
 		Packet *p = this->packet_queue->next;
 		delete this->packet_queue;
 		this->packet_queue = p;
 	}
+	this->packet_queue_end = NULL;
 	delete this->packet_recv;
 	this->packet_recv = NULL;
 
@@ -62,26 +92,31 @@ NetworkRecvStatus NetworkTCPSocketHandler::CloseConnection(bool error)
  */
 void NetworkTCPSocketHandler::SendPacket(Packet *packet)
 {
-	Packet *p;
 	assert(packet != NULL);
 
 	packet->PrepareToSend();
+	this->bytes_sent += packet->size;
+
+	/* Append the packet to the last packet buffered for the client when it
+	 * fits, as in 99+% of the times we send at most 25 bytes and keeping the
+	 * other 1400+ bytes wastes memory, especially when someone tries to do a
+	 * denial of service attack! It also saves calls to send the packets. */
+	Packet *p = this->packet_queue_end;
+	if (p != NULL && p->size + packet->size <= SEND_MTU) {
+		p->Reserve(p->size + packet->size);
+		memcpy(p->buffer + p->size, packet->buffer, packet->size);
+		p->size += packet->size;
+		delete packet;
+		return;
+	}
 
-	/* Reallocate the packet as in 99+% of the times we send at most 25 bytes and
-	 * keeping the other 1400+ bytes wastes memory, especially when someone tries
-	 * to do a denial of service attack! */
-	packet->buffer = ReallocT(packet->buffer, packet->size);
-
-	/* Locate last packet buffered for the client */
-	p = this->packet_queue;
 	if (p == NULL) {
 		/* No packets yet */
 		this->packet_queue = packet;
 	} else {
-		/* Skip to the last packet */
-		while (p->next != NULL) p = p->next;
 		p->next = packet;
 	}
+	this->packet_queue_end = packet;
 }
 
 /**
@@ -96,16 +131,35 @@ void NetworkTCPSocketHandler::SendPacket(Packet *packet)
  */
 SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 {
-	ssize_t res;
-	Packet *p;
-
 	/* We can not write to this socket!! */
 	if (!this->writable) return SPS_NONE_SENT;
 	if (!this->IsConnected()) return SPS_CLOSED;
 
-	p = this->packet_queue;
-	while (p != NULL) {
-		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+#ifdef HAVE_EPOLL
+	if (this->io != NULL) {
+		/* Hand the whole queue over to the I/O thread. */
+		SendPacketsState state = this->io->SendPackets(this->packet_queue);
+		this->packet_queue = NULL;
+		this->packet_queue_end = NULL;
+		if (state == SPS_CLOSED && !closing_down) this->CloseConnection();
+		return state;
+	}
+#endif
+
+	while (this->packet_queue != NULL) {
+#ifdef HAVE_WRITEV
+		/* Hand as many packets as possible to the OS at once. */
+		struct iovec iov[SEND_BATCH_SIZE];
+		int count = 0;
+		for (Packet *p = this->packet_queue; p != NULL && count < SEND_BATCH_SIZE; p = p->next, count++) {
+			iov[count].iov_base = p->buffer + p->pos;
+			iov[count].iov_len = p->size - p->pos;
+		}
+		ssize_t res = writev(this->sock, iov, count);
+#else
+		Packet *p = this->packet_queue;
+		ssize_t res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+#endif
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -116,6 +170,10 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+#ifdef HAVE_EPOLL
+			/* Let epoll tell when more can be sent. */
+			if (this->epoll_fd != -1) this->SetWritable(false);
+#endif
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -124,19 +182,21 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
-		p->pos += res;
+		/* Go to the next packet for each packet that is sent. */
+		while (res > 0) {
+			Packet *p = this->packet_queue;
+			if (res < p->size - p->pos) {
+				p->pos += (PacketSize)res;
+				return SPS_PARTLY_SENT;
+			}
 
-		/* Is this packet sent? */
-		if (p->pos == p->size) {
-			/* Go to the next packet */
+			res -= p->size - p->pos;
 			this->packet_queue = p->next;
 			delete p;
-			p = this->packet_queue;
-		} else {
-			return SPS_PARTLY_SENT;
 		}
 	}
 
+	this->packet_queue_end = NULL;
 	return SPS_ALL_SENT;
 }
 
@@ -150,6 +210,17 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 
 	if (!this->IsConnected()) return NULL;
 
+#ifdef HAVE_EPOLL
+	if (this->io != NULL) {
+		/* The I/O thread already received the packets. */
+		bool closed;
+		Packet *p = this->io->ReceivePacket(&closed);
+		if (p != NULL) this->bytes_received += p->size;
+		if (closed) this->CloseConnection();
+		return p;
+	}
+#endif
+
 	if (this->packet_recv == NULL) {
 		this->packet_recv = new Packet(this);
 	}
@@ -187,6 +258,7 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 			this->CloseConnection();
 			return NULL;
 		}
+		p->Reserve(p->size);
 	}
 
 	/* Read rest of packet */
@@ -214,6 +286,7 @@ Packet *NetworkTCPSocketHandler::ReceivePacket()
 
 	/* Prepare for receiving a new packet */
 	this->packet_recv = NULL;
+	this->bytes_received += p->size;
 
 	p->PrepareToRead();
 	return p;
@@ -246,4 +319,41 @@ bool NetworkTCPSocketHandler::CanSendReceive()
 	return FD_ISSET(this->sock, &read_fd) != 0;
 }
 
+/**
+ * Set whether this socket can be written to. When the socket is watched by
+ * epoll and cannot be written to, epoll is asked to report once when it can.
+ * @param writable Whether the socket can be written to.
+ */
+void NetworkTCPSocketHandler::SetWritable(bool writable)
+{
+	this->writable = writable;
+
+#ifdef HAVE_EPOLL
+	if (this->epoll_fd == -1) return;
+
+	struct epoll_event event;
+	event.events = writable ? EPOLLIN : EPOLLIN | EPOLLOUT;
+	event.data.u64 = this->epoll_data;
+	if (epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, this->sock, &event) != 0) DEBUG(net, 0, "epoll_ctl failed with error %d", errno);
+#endif
+}
+
+#ifdef HAVE_EPOLL
+/**
+ * Let the network I/O thread read and write the socket, if the thread is running.
+ * @return True if the I/O thread handles the socket.
+ */
+bool NetworkTCPSocketHandler::StartThreadedIO()
+{
+	assert(this->io == NULL && this->packet_queue == NULL && this->packet_recv == NULL);
+
+	this->io = NetworkIOConnection::New(this->sock, this);
+	if (this->io == NULL) return false;
+
+	/* The I/O thread takes the packets whenever they are handed over. */
+	this->writable = true;
+	return true;
+}
+#endif
+
 #endif /* ENABLE_NETWORK */
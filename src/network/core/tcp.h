@@ -31,10 +31,18 @@ enum SendPacketsState {
 class NetworkTCPSocketHandler : public NetworkSocketHandler {
 private:
 	Packet *packet_queue;     ///< Packets that are awaiting delivery
+	Packet *packet_queue_end; ///< Last packet of #packet_queue, to append new packets to
 	Packet *packet_recv;      ///< Partially received packet
 public:
 	SOCKET sock;              ///< The socket currently connected to
 	bool writable;            ///< Can we write to this socket?
+	uint64 bytes_sent;        ///< Number of bytes of the packets sent over this socket
+	uint64 bytes_received;    ///< Number of bytes of the packets received over this socket
+#ifdef HAVE_EPOLL
+	int epoll_fd;             ///< The epoll instance reporting whether the socket is ready, or -1 when it is checked with select
+	uint64 epoll_data;        ///< The data the epoll instance reports with the readiness of this socket
+	class NetworkIOConnection *io; ///< The connection when the network I/O thread reads and writes the socket, otherwise NULL
+#endif
 
 	/**
 	 * Whether this socket is currently bound to a socket.
@@ -49,6 +57,10 @@ public:
 	virtual Packet *ReceivePacket();
 
 	bool CanSendReceive();
+	void SetWritable(bool writable);
+#ifdef HAVE_EPOLL
+	bool StartThreadedIO();
+#endif
 
 	NetworkTCPSocketHandler(SOCKET s = INVALID_SOCKET);
 	~NetworkTCPSocketHandler();
@@ -87,6 +87,11 @@ NetworkRecvStatus NetworkAdminSocketHandler::HandlePacket(Packet *p)
 		case ADMIN_PACKET_SERVER_CONSOLE:         return this->Receive_SERVER_CONSOLE(p);
 		case ADMIN_PACKET_SERVER_CMD_NAMES:       return this->Receive_SERVER_CMD_NAMES(p);
 		case ADMIN_PACKET_SERVER_CMD_LOGGING:     return this->Receive_SERVER_CMD_LOGGING(p);
+		case ADMIN_PACKET_SERVER_PATHFINDER_STATS: return this->Receive_SERVER_PATHFINDER_STATS(p);
+		case ADMIN_PACKET_SERVER_TICK_STATS:      return this->Receive_SERVER_TICK_STATS(p);
+		case ADMIN_PACKET_SERVER_POOL_STATS:      return this->Receive_SERVER_POOL_STATS(p);
+		case ADMIN_PACKET_SERVER_LINKGRAPH_STATS: return this->Receive_SERVER_LINKGRAPH_STATS(p);
+		case ADMIN_PACKET_SERVER_CLIENT_TRAFFIC:  return this->Receive_SERVER_CLIENT_TRAFFIC(p);
 
 		default:
 			if (this->HasClientQuit()) {
@@ -162,5 +167,10 @@ NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_RCON(Packet *p) { re
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CONSOLE(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_CONSOLE); }
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CMD_NAMES(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_CMD_NAMES); }
 NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CMD_LOGGING(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_CMD_LOGGING); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_PATHFINDER_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_PATHFINDER_STATS); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_TICK_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_TICK_STATS); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_POOL_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_POOL_STATS); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_LINKGRAPH_STATS(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_LINKGRAPH_STATS); }
+NetworkRecvStatus NetworkAdminSocketHandler::Receive_SERVER_CLIENT_TRAFFIC(Packet *p) { return this->ReceiveInvalidPacket(ADMIN_PACKET_SERVER_CLIENT_TRAFFIC); }
 
 #endif /* ENABLE_NETWORK */
@@ -60,6 +60,11 @@ enum PacketAdminType {
 	ADMIN_PACKET_SERVER_CMD_NAMES,       ///< The server sends out the names of the DoCommands to the admins.
 	ADMIN_PACKET_SERVER_CMD_LOGGING,     ///< The server gives the admin copies of incoming command packets.
 	ADMIN_PACKET_SERVER_GAMESCRIPT,      ///< The server gives the admin information from the GameScript in JSON.
+	ADMIN_PACKET_SERVER_PATHFINDER_STATS, ///< The server gives the admin statistics of the path finder searches.
+	ADMIN_PACKET_SERVER_TICK_STATS,      ///< The server gives the admin statistics of the durations of the ticks.
+	ADMIN_PACKET_SERVER_POOL_STATS,      ///< The server gives the admin the occupancy of the pools.
+	ADMIN_PACKET_SERVER_LINKGRAPH_STATS, ///< The server gives the admin statistics of the link graph jobs.
+	ADMIN_PACKET_SERVER_CLIENT_TRAFFIC,  ///< The server gives the admin the amount of network traffic of a client.
 
 	INVALID_ADMIN_PACKET = 0xFF,         ///< An invalid marker for admin packets.
 };
@@ -83,6 +88,11 @@ enum AdminUpdateType {
 	ADMIN_UPDATE_CMD_NAMES,       ///< The admin would like a list of all DoCommand names.
 	ADMIN_UPDATE_CMD_LOGGING,     ///< The admin would like to have DoCommand information.
 	ADMIN_UPDATE_GAMESCRIPT,      ///< The admin would like to have gamescript messages.
+	ADMIN_UPDATE_PATHFINDER_STATS, ///< Updates about the statistics of the path finders.
+	ADMIN_UPDATE_TICK_STATS,      ///< Updates about the statistics of the durations of the ticks.
+	ADMIN_UPDATE_POOL_STATS,      ///< Updates about the occupancy of the pools.
+	ADMIN_UPDATE_LINKGRAPH_STATS, ///< Updates about the statistics of the link graph jobs.
+	ADMIN_UPDATE_CLIENT_TRAFFIC,  ///< Updates about the network traffic of the clients.
 	ADMIN_UPDATE_END,             ///< Must ALWAYS be on the end of this list!! (period)
 };
 
@@ -454,6 +464,83 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_CMD_LOGGING(Packet *p);
 
+	/**
+	 * Statistics of the path finder searches of one vehicle type, since the
+	 * start of the server or the last 'pf_stats reset':
+	 * uint8   Vehicle type (see #VehicleType), only trains, road vehicles and ships.
+	 * uint32  Number of searches.
+	 * uint64  Number of expanded nodes.
+	 * uint64  Number of node costs taken from the segment cost cache.
+	 * uint64  Number of node costs that had to be calculated.
+	 * uint32  Number of searches aborted at the maximum number of nodes.
+	 * uint32  Number of searches that did not find a path.
+	 * uint32  Search time in microseconds that 50% of the searches stayed below.
+	 * uint32  Search time in microseconds that 90% of the searches stayed below.
+	 * uint32  Search time in microseconds that 99% of the searches stayed below.
+	 * uint32  Time of the longest search in microseconds.
+	 * uint64  Total time of all searches in microseconds.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_PATHFINDER_STATS(Packet *p);
+
+	/**
+	 * Statistics of the durations of the ticks in which the game was not
+	 * paused, since the start of the server:
+	 * uint32  Number of ticks.
+	 * uint64  Total time of all ticks in microseconds.
+	 * uint32  Tick time in microseconds that 50% of the ticks stayed below.
+	 * uint32  Tick time in microseconds that 90% of the ticks stayed below.
+	 * uint32  Tick time in microseconds that 99% of the ticks stayed below.
+	 * uint32  Time of the longest tick in microseconds.
+	 * uint8   Number of buckets of the histogram of the tick times.
+	 * For each bucket i:
+	 *   uint32  Number of ticks that took less than 2^i microseconds, but
+	 *           at least 2^(i-1) microseconds when i is not 0.
+	 * uint8   Number of parts of the ticks.
+	 * For each part (network, commands, date, tile loop, vehicles, landscape, scripts, other):
+	 *   uint64  Total time spent in the part in microseconds.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_TICK_STATS(Packet *p);
+
+	/**
+	 * The occupancy of the pools of the vehicles, the cargo packets and the stations:
+	 * uint8   Number of pools.
+	 * For each pool:
+	 *   string  Name of the pool.
+	 *   uint32  Number of items in the pool.
+	 *   uint32  Number of allocated slots of the pool.
+	 *   uint32  Maximum number of items of the pool.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_POOL_STATS(Packet *p);
+
+	/**
+	 * Statistics of the link graph jobs that were joined since the start of the server:
+	 * uint32  Number of jobs.
+	 * uint64  Total number of nodes of the jobs.
+	 * uint64  Total time the jobs ran in microseconds.
+	 * uint32  Time of the longest running job in microseconds.
+	 * uint64  Total time the game waited for unfinished jobs in microseconds.
+	 * uint32  Longest time the game waited for a job in microseconds.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_LINKGRAPH_STATS(Packet *p);
+
+	/**
+	 * The network traffic of a client since it connected:
+	 * uint32  ID of the client.
+	 * uint64  Number of bytes received from the client.
+	 * uint64  Number of bytes sent to the client.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_CLIENT_TRAFFIC(Packet *p);
+
 	NetworkRecvStatus HandlePacket(Packet *p);
 public:
 	NetworkRecvStatus CloseConnection(bool error = true);
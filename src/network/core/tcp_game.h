@@ -94,6 +94,7 @@ enum PacketGameType {
 	/* Sending commands around. */
 	PACKET_CLIENT_COMMAND,               ///< Client executed a command and sends it to the server.
 	PACKET_SERVER_COMMAND,               ///< Server distributes a command to (all) the clients.
+	PACKET_SERVER_COMMANDS,              ///< Server distributes the commands of a frame to (all) the clients.
 
 	/* Human communication! */
 	PACKET_CLIENT_CHAT,                  ///< Client said something that should be distributed.
@@ -137,7 +138,7 @@ class CommandQueue {
 
 public:
 	/** Initialise the command queue. */
-	CommandQueue() : first(NULL), last(NULL) {}
+	CommandQueue() : first(NULL), last(NULL), count(0) {}
 	/** Clear the command queue. */
 	~CommandQueue() { this->Free(); }
 	void Append(CommandPacket *p);
@@ -338,6 +339,8 @@ protected:
 	 * uint32  Frame counter.
 	 * uint32  General seed 1.
 	 * uint32  General seed 2 (dependant on compile settings, not default).
+	 * bool    Whether the hashes of the game state are known.
+	 * uint32  Hash of each part of the game state, see #StateHashPart.
 	 * @param p The packet that was just received.
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
@@ -377,6 +380,25 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
 
+	/**
+	 * Sends the DoCommands of a frame to the client:
+	 * uint32  Frame of execution.
+	 * uint8   Number of commands the client sent itself.
+	 * For each of those commands:
+	 * uint8   Index of the command.
+	 * uint8   Number of commands.
+	 * For each command:
+	 * uint8   ID of the company (0..MAX_COMPANIES-1).
+	 * uint32  ID of the command (see command.h).
+	 * uint32  P1 (free variable used in DoCommand).
+	 * uint32  P2.
+	 * uint32  Tile where this is taking place.
+	 * string  Text.
+	 * uint8   ID of the callback; only used for the commands the client sent itself.
+	 * @param p The packet that was just received.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_COMMANDS(Packet *p);
+
 	/**
 	 * Sends a chat-packet to the server:
 	 * uint8   ID of the action (see NetworkAction).
@@ -555,7 +577,7 @@ public:
 	NetworkRecvStatus ReceivePackets();
 
 	const char *ReceiveCommand(Packet *p, CommandPacket *cp);
-	void SendCommand(Packet *p, const CommandPacket *cp);
+	static void SendCommand(Packet *p, const CommandPacket *cp);
 };
 
 #endif /* ENABLE_NETWORK */
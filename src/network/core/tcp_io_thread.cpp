@@ -0,0 +1,569 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tcp_io_thread.cpp Reading and writing TCP connections in a separate thread.
+ */
+
+#ifdef ENABLE_NETWORK
+
+#include "../../stdafx.h"
+#include "../../debug.h"
+#include "../../thread/thread.h"
+#include "../../core/smallvec_type.hpp"
+
+#include "tcp_io_thread.h"
+
+#ifdef HAVE_EPOLL
+
+#include <fcntl.h>
+#include <time.h>
+
+/** Number of events that are fetched from epoll at once by the I/O thread. */
+static const int IO_THREAD_EVENTS = 256;
+/** Maximum number of packets that are handed to the OS at once. */
+static const int IO_THREAD_SEND_BATCH_SIZE = 32;
+/** Number of received packets the game thread may leave in the queue before the I/O thread stops reading the connection. */
+static const uint IO_THREAD_RECEIVE_LIMIT = 64;
+/** Number of bytes the I/O thread may be behind with sending before the game thread is told not everything is sent. */
+static const size_t IO_THREAD_SEND_BACKLOG = 64 * 1024;
+/** Number of milliseconds a released connection may take to send what is left before it is closed anyway. */
+static const uint32 IO_THREAD_LINGER_TIME = 2000;
+/** Number of milliseconds the I/O thread waits for events at most while connections are lingering. */
+static const int IO_THREAD_LINGER_POLL = 100;
+
+static ThreadObject *_io_thread = NULL; ///< The network I/O thread, if it is running.
+static int _io_epoll = -1;              ///< The epoll instance of the I/O thread.
+static int _io_signal[2] = { -1, -1 };  ///< Pipe to tell the I/O thread which connections to look at; \c NULL stops the thread.
+
+/**
+ * Get the time for timing out lingering connections.
+ * @return The time in milliseconds.
+ */
+static uint32 GetIOThreadTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32)ts.tv_sec * 1000 + (uint32)(ts.tv_nsec / 1000000);
+}
+
+/**
+ * Create the connection of a socket.
+ * @param s  The socket.
+ * @param cs The socket handler the received packets are for.
+ */
+NetworkIOConnection::NetworkIOConnection(SOCKET s, NetworkSocketHandler *cs) :
+		mutex(ThreadMutex::New()), sock(s), cs(cs), packet_recv(NULL), packet_queue(NULL), packet_queue_end(NULL),
+		events(EPOLLIN), reading(true), blocked(false), lingering(false), linger_end(0), received(NULL), incoming(NULL), incoming_end(NULL), incoming_count(0),
+		outgoing(NULL), outgoing_end(NULL), pending(0), throttled(false), closed(false), released(false), signalled(false)
+{
+}
+
+/**
+ * Free the connection and close its socket.
+ * Called by the I/O thread, or by the game thread when the I/O thread is not running anymore.
+ */
+NetworkIOConnection::~NetworkIOConnection()
+{
+	Packet *queues[] = { this->packet_recv, this->packet_queue, this->received, this->incoming, this->outgoing };
+	for (uint i = 0; i < lengthof(queues); i++) {
+		while (queues[i] != NULL) {
+			Packet *p = queues[i];
+			queues[i] = p->next;
+			delete p;
+		}
+	}
+
+	if (this->sock != INVALID_SOCKET) {
+		/* A closed descriptor is only dropped by epoll when no duplicate of it is open anymore. */
+		if (this->events != 0 && _io_epoll != -1 && epoll_ctl(_io_epoll, EPOLL_CTL_DEL, this->sock, NULL) != 0) {
+			DEBUG(net, 0, "[io] epoll_ctl failed with error %d", errno);
+		}
+		closesocket(this->sock);
+	}
+	delete this->mutex;
+}
+
+/**
+ * Tell the I/O thread to look at this connection.
+ * @pre The game thread is in the critical section of the connection.
+ */
+void NetworkIOConnection::Signal()
+{
+	if (this->signalled) return;
+	this->signalled = true;
+
+	/* The connection is in the pipe at most once, so the pipe never fills up. */
+	NetworkIOConnection *conn = this;
+	if (write(_io_signal[1], &conn, sizeof(conn)) != sizeof(conn)) DEBUG(net, 0, "[io] signalling the I/O thread failed with error %d", errno);
+}
+
+/**
+ * Let epoll report the events the I/O thread is waiting for. When it waits
+ * for none, the socket is removed from epoll, as epoll would otherwise keep
+ * reporting a hang up the I/O thread does not want to read yet.
+ */
+void NetworkIOConnection::UpdateEvents()
+{
+	uint32 events = (this->reading ? (uint32)EPOLLIN : 0) | (this->blocked ? (uint32)EPOLLOUT : 0);
+	if (events == this->events) return;
+
+	struct epoll_event event;
+	event.events = events;
+	event.data.ptr = this;
+	int op = events == 0 ? EPOLL_CTL_DEL : (this->events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+	if (epoll_ctl(_io_epoll, op, this->sock, &event) != 0) DEBUG(net, 0, "[io] epoll_ctl failed with error %d", errno);
+	this->events = events;
+}
+
+/** Mark the connection as closed; the game thread closes its socket handler when it notices. */
+void NetworkIOConnection::Fail()
+{
+	if (this->events != 0) epoll_ctl(_io_epoll, EPOLL_CTL_DEL, this->sock, NULL);
+	this->events = 0;
+
+	this->mutex->BeginCritical();
+	this->closed = true;
+	this->mutex->EndCritical();
+}
+
+/** Send as many of the queued packets as the socket accepts. */
+void NetworkIOConnection::Flush()
+{
+	size_t sent = 0;
+	bool failed = false;
+	this->blocked = false;
+
+	while (this->packet_queue != NULL) {
+		struct iovec iov[IO_THREAD_SEND_BATCH_SIZE];
+		int count = 0;
+		for (Packet *p = this->packet_queue; p != NULL && count < IO_THREAD_SEND_BATCH_SIZE; p = p->next, count++) {
+			iov[count].iov_base = p->buffer + p->pos;
+			iov[count].iov_len = p->size - p->pos;
+		}
+
+		ssize_t res = writev(this->sock, iov, count);
+		if (res == -1) {
+			int err = GET_LAST_ERROR();
+			if (err != EWOULDBLOCK) {
+				DEBUG(net, 0, "[io] send failed with error %d", err);
+				failed = true;
+			} else {
+				/* Let epoll tell when more can be sent. */
+				this->blocked = true;
+			}
+			break;
+		}
+		if (res == 0) {
+			failed = true;
+			break;
+		}
+
+		sent += res;
+		while (res > 0) {
+			Packet *p = this->packet_queue;
+			if (res < p->size - p->pos) {
+				p->pos += (PacketSize)res;
+				break;
+			}
+
+			res -= p->size - p->pos;
+			this->packet_queue = p->next;
+			delete p;
+		}
+	}
+	if (this->packet_queue == NULL) this->packet_queue_end = NULL;
+
+	this->mutex->BeginCritical();
+	this->pending -= sent;
+	bool throttled = this->throttled;
+	this->mutex->EndCritical();
+
+	if (failed) {
+		this->Fail();
+	} else {
+		this->reading = !throttled && !this->lingering;
+		this->UpdateEvents();
+	}
+}
+
+/** Receive packets until the socket has no more data or the game thread has enough packets waiting. */
+void NetworkIOConnection::Read()
+{
+	this->mutex->BeginCritical();
+	uint room = this->incoming_count < IO_THREAD_RECEIVE_LIMIT ? IO_THREAD_RECEIVE_LIMIT - this->incoming_count : 0;
+	this->mutex->EndCritical();
+
+	Packet *first = NULL;
+	Packet *last = NULL;
+	uint count = 0;
+	bool failed = false;
+
+	while (count < room) {
+		if (this->packet_recv == NULL) this->packet_recv = new Packet(this->cs);
+		Packet *p = this->packet_recv;
+
+		/* Read the size of the packet first, then the rest of it. */
+		PacketSize want = p->pos < sizeof(PacketSize) ? sizeof(PacketSize) - p->pos : p->size - p->pos;
+		ssize_t res = recv(this->sock, (char*)p->buffer + p->pos, want, 0);
+		if (res == -1) {
+			int err = GET_LAST_ERROR();
+			if (err != EWOULDBLOCK) {
+				/* Something went wrong... (104 is connection reset by peer) */
+				if (err != 104) DEBUG(net, 0, "[io] recv failed with error %d", err);
+				failed = true;
+			}
+			break;
+		}
+		if (res == 0) {
+			/* Client/server has left */
+			failed = true;
+			break;
+		}
+
+		bool read_size = p->pos < sizeof(PacketSize);
+		p->pos += (PacketSize)res;
+		if (read_size) {
+			if (p->pos < sizeof(PacketSize)) continue;
+
+			p->ReadRawPacketSize();
+			if (p->size > SEND_MTU) {
+				failed = true;
+				break;
+			}
+			p->Reserve(p->size);
+		}
+		if (p->pos < p->size) continue;
+
+		this->packet_recv = NULL;
+		p->PrepareToRead();
+		if (last == NULL) {
+			first = p;
+		} else {
+			last->next = p;
+		}
+		last = p;
+		count++;
+	}
+
+	this->mutex->BeginCritical();
+	if (first != NULL) {
+		if (this->incoming_end == NULL) {
+			this->incoming = first;
+		} else {
+			this->incoming_end->next = first;
+		}
+		this->incoming_end = last;
+		this->incoming_count += count;
+	}
+	/* Stop reading until the game thread takes the packets; TCP makes the other side wait. */
+	if (this->incoming_count >= IO_THREAD_RECEIVE_LIMIT) this->throttled = true;
+	bool throttled = this->throttled;
+	this->mutex->EndCritical();
+
+	if (failed) {
+		this->Fail();
+	} else {
+		this->reading = !throttled;
+		this->UpdateEvents();
+	}
+}
+
+/**
+ * Take the packets the game thread handed over and send them.
+ * @return Whether the game thread released the connection, so it has to be freed once everything is sent.
+ */
+bool NetworkIOConnection::HandleSignal()
+{
+	this->mutex->BeginCritical();
+	this->signalled = false;
+	Packet *queue = this->outgoing;
+	Packet *queue_end = this->outgoing_end;
+	this->outgoing = NULL;
+	this->outgoing_end = NULL;
+	bool released = this->released;
+	this->mutex->EndCritical();
+
+	if (released && !this->lingering) {
+		/* Nobody takes the received packets anymore; only send what is left. */
+		this->lingering = true;
+		this->linger_end = GetIOThreadTime() + IO_THREAD_LINGER_TIME;
+	}
+	this->reading = !this->throttled && !this->lingering;
+
+	if (queue != NULL) {
+		if (this->packet_queue_end == NULL) {
+			this->packet_queue = queue;
+		} else {
+			this->packet_queue_end->next = queue;
+		}
+		this->packet_queue_end = queue_end;
+	}
+
+	if (this->closed) return released;
+
+	if (!this->blocked) {
+		this->Flush();
+	} else {
+		this->UpdateEvents();
+	}
+	return released;
+}
+
+/**
+ * Check whether a lingering connection is done and can be freed.
+ * @param now The current time.
+ * @return True if everything is sent, the connection failed, or it took too long.
+ */
+bool NetworkIOConnection::IsDoneLingering(uint32 now) const
+{
+	if (this->closed || this->packet_queue == NULL) return true;
+	if ((int32)(now - this->linger_end) < 0) return false;
+
+	DEBUG(net, 1, "[io] closing a released connection before everything is sent");
+	return true;
+}
+
+/**
+ * The network I/O thread: wait for sockets that are ready and for connections the game thread signals.
+ * @param param Unused.
+ */
+/* static */ void NetworkIOConnection::ThreadProc(void *param)
+{
+	struct epoll_event events[IO_THREAD_EVENTS];
+	SmallVector<NetworkIOConnection *, 16> lingering;
+	SmallVector<NetworkIOConnection *, 16> released;
+
+	/* When told to stop, the lingering connections still get their chance to send what is left. */
+	for (bool quit = false; !quit || lingering.Length() != 0;) {
+		int count = epoll_wait(_io_epoll, events, IO_THREAD_EVENTS, lingering.Length() == 0 ? -1 : IO_THREAD_LINGER_POLL);
+		if (count == -1 && errno != EINTR) {
+			DEBUG(net, 0, "[io] epoll_wait failed with error %d", errno);
+			break;
+		}
+
+		for (int i = 0; i < count; i++) {
+			NetworkIOConnection *conn = (NetworkIOConnection *)events[i].data.ptr;
+			if (conn == NULL) {
+				/* The game thread tells which connections to look at. */
+				NetworkIOConnection *signalled[64];
+				ssize_t res;
+				while ((res = read(_io_signal[0], signalled, sizeof(signalled))) > 0) {
+					for (uint j = 0; j < (size_t)res / sizeof(*signalled); j++) {
+						if (signalled[j] == NULL) {
+							quit = true;
+						} else if (signalled[j]->HandleSignal()) {
+							lingering.Include(signalled[j]);
+						}
+					}
+				}
+				continue;
+			}
+
+			/* Connections that failed may still have events in this batch. */
+			if (conn->closed) continue;
+			/* A lingering connection does not read, so let sending notice a hang up. */
+			if ((events[i].events & (conn->lingering ? EPOLLOUT | EPOLLERR | EPOLLHUP : EPOLLOUT)) != 0) conn->Flush();
+			if (!conn->closed && conn->reading && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) conn->Read();
+		}
+
+		uint32 now = GetIOThreadTime();
+		for (NetworkIOConnection **iter = lingering.Begin(); iter != lingering.End();) {
+			if ((*iter)->IsDoneLingering(now)) {
+				released.Include(*iter);
+				lingering.Erase(iter);
+			} else {
+				iter++;
+			}
+		}
+
+		/* Only free the connections now, as they might be in the events of this batch. */
+		for (NetworkIOConnection **iter = released.Begin(); iter != released.End(); iter++) {
+			delete *iter;
+		}
+		released.Clear();
+	}
+}
+
+/**
+ * Let the network I/O thread read and write a socket.
+ * @param s  The socket; the connection closes it when it is released.
+ * @param cs The socket handler the received packets are for.
+ * @return The connection, or \c NULL when the I/O thread is not running.
+ */
+/* static */ NetworkIOConnection *NetworkIOConnection::New(SOCKET s, NetworkSocketHandler *cs)
+{
+	if (_io_thread == NULL) return NULL;
+
+	NetworkIOConnection *conn = new NetworkIOConnection(s, cs);
+
+	struct epoll_event event;
+	event.events = conn->events;
+	event.data.ptr = conn;
+	if (epoll_ctl(_io_epoll, EPOLL_CTL_ADD, s, &event) != 0) {
+		DEBUG(net, 0, "[io] epoll_ctl failed with error %d", errno);
+		conn->sock = INVALID_SOCKET;
+		delete conn;
+		return NULL;
+	}
+	return conn;
+}
+
+/**
+ * Get the next packet the I/O thread received.
+ * @param closed [out] Whether the connection is closed and all its packets are received.
+ * @return The packet, or \c NULL when there is none.
+ */
+Packet *NetworkIOConnection::ReceivePacket(bool *closed)
+{
+	*closed = false;
+
+	if (this->received == NULL) {
+		this->mutex->BeginCritical();
+		this->received = this->incoming;
+		this->incoming = NULL;
+		this->incoming_end = NULL;
+		this->incoming_count = 0;
+		if (this->throttled) {
+			/* There is room again, so let the I/O thread read. */
+			this->throttled = false;
+			this->Signal();
+		}
+		*closed = this->closed && this->received == NULL;
+		this->mutex->EndCritical();
+	}
+
+	Packet *p = this->received;
+	if (p == NULL) return NULL;
+
+	this->received = p->next;
+	p->next = NULL;
+	return p;
+}
+
+/**
+ * Hand packets over to the I/O thread for sending.
+ * @param queue The list of packets, prepared for sending; the connection takes care of freeing them.
+ * @return The state of sending: all packets are sent when the I/O thread keeps up with sending.
+ */
+SendPacketsState NetworkIOConnection::SendPackets(Packet *queue)
+{
+	size_t size = 0;
+	Packet *last = NULL;
+	for (Packet *p = queue; p != NULL; p = p->next) {
+		size += p->size - p->pos;
+		last = p;
+	}
+
+	this->mutex->BeginCritical();
+	bool closed = this->closed;
+	SendPacketsState state = this->pending < IO_THREAD_SEND_BACKLOG ? SPS_ALL_SENT : SPS_PARTLY_SENT;
+	if (!closed && queue != NULL) {
+		if (this->outgoing_end == NULL) {
+			this->outgoing = queue;
+		} else {
+			this->outgoing_end->next = queue;
+		}
+		this->outgoing_end = last;
+		this->pending += size;
+		this->Signal();
+	}
+	this->mutex->EndCritical();
+
+	if (!closed) return state;
+
+	while (queue != NULL) {
+		Packet *p = queue;
+		queue = p->next;
+		delete p;
+	}
+	return SPS_CLOSED;
+}
+
+/**
+ * Stop using the connection from the game thread. The I/O thread keeps
+ * sending the packets that were handed over already, until they are sent or
+ * #IO_THREAD_LINGER_TIME passed. Then it closes the socket and frees the connection.
+ */
+void NetworkIOConnection::Release()
+{
+	if (_io_thread == NULL) {
+		delete this;
+		return;
+	}
+
+	this->mutex->BeginCritical();
+	this->released = true;
+	this->Signal();
+	this->mutex->EndCritical();
+}
+
+/**
+ * Start the network I/O thread, if it is not running yet.
+ * @return True if the thread is running.
+ */
+bool StartNetworkIOThread()
+{
+	if (_io_thread != NULL) return true;
+
+	_io_epoll = epoll_create(IO_THREAD_EVENTS);
+	if (_io_epoll == -1) {
+		DEBUG(net, 0, "[io] epoll_create failed with error %d", errno);
+		return false;
+	}
+
+	if (pipe(_io_signal) == 0) {
+		fcntl(_io_signal[0], F_SETFL, O_NONBLOCK);
+
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		if (epoll_ctl(_io_epoll, EPOLL_CTL_ADD, _io_signal[0], &event) == 0 &&
+				ThreadObject::New(&NetworkIOConnection::ThreadProc, NULL, &_io_thread)) {
+			DEBUG(net, 3, "[io] started the network I/O thread");
+			return true;
+		}
+
+		close(_io_signal[0]);
+		close(_io_signal[1]);
+		_io_signal[0] = _io_signal[1] = -1;
+	}
+
+	DEBUG(net, 1, "[io] could not start the network I/O thread, using the game thread");
+	close(_io_epoll);
+	_io_epoll = -1;
+	_io_thread = NULL;
+	return false;
+}
+
+/**
+ * Stop the network I/O thread. Connections still in use by a socket handler
+ * are freed when they are released.
+ */
+void StopNetworkIOThread()
+{
+	if (_io_thread == NULL) return;
+
+	NetworkIOConnection *quit = NULL;
+	if (write(_io_signal[1], &quit, sizeof(quit)) == sizeof(quit)) _io_thread->Join();
+	delete _io_thread;
+	_io_thread = NULL;
+
+	close(_io_signal[0]);
+	close(_io_signal[1]);
+	_io_signal[0] = _io_signal[1] = -1;
+	close(_io_epoll);
+	_io_epoll = -1;
+
+	DEBUG(net, 3, "[io] stopped the network I/O thread");
+}
+
+#endif /* HAVE_EPOLL */
+
+#endif /* ENABLE_NETWORK */
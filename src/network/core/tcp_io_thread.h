@@ -0,0 +1,92 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file tcp_io_thread.h Reading and writing TCP connections in a separate thread.
+ */
+
+#ifndef NETWORK_CORE_TCP_IO_THREAD_H
+#define NETWORK_CORE_TCP_IO_THREAD_H
+
+#include "tcp.h"
+
+#if defined(ENABLE_NETWORK) && defined(HAVE_EPOLL)
+
+/**
+ * A TCP connection whose socket is read and written by the network I/O thread.
+ * The game thread and the I/O thread exchange whole lists of packets through
+ * two queues, each with one producer and one consumer: the received packets
+ * and the packets to send. The game thread takes the received packets and
+ * hands over its packets to send once per tick, so the lock of the queues is
+ * taken only a few times per tick for each connection.
+ */
+class NetworkIOConnection {
+private:
+	class ThreadMutex *mutex;   ///< Mutex guarding the queues and states shared by the threads.
+
+	/* Only used by the I/O thread. */
+	SOCKET sock;                ///< The socket of the connection.
+	NetworkSocketHandler *cs;   ///< The socket handler the received packets are for; only dereferenced by the game thread.
+	Packet *packet_recv;        ///< Partially received packet.
+	Packet *packet_queue;       ///< Packets the I/O thread is sending.
+	Packet *packet_queue_end;   ///< Last packet of #packet_queue.
+	uint32 events;              ///< The events epoll reports for the socket; 0 when the socket is not in epoll.
+	bool reading;               ///< Whether the socket is read, i.e. the received packets are not throttled.
+	bool blocked;               ///< Whether sending is waiting for the socket to become writable.
+	bool lingering;             ///< Whether the game thread released the connection and the I/O thread sends what is left.
+	uint32 linger_end;          ///< Time after which a lingering connection is freed, even when not everything is sent.
+
+	/* Only used by the game thread. */
+	Packet *received;           ///< Received packets the game thread has taken from the queue.
+
+	/* Shared by both threads, guarded by #mutex. */
+	Packet *incoming;           ///< Queue of received packets for the game thread.
+	Packet *incoming_end;       ///< Last packet of #incoming.
+	uint incoming_count;        ///< Number of packets in #incoming.
+	Packet *outgoing;           ///< Queue of packets handed over by the game thread.
+	Packet *outgoing_end;       ///< Last packet of #outgoing.
+	size_t pending;             ///< Number of bytes handed over by the game thread that are not sent yet.
+	bool throttled;             ///< Whether the I/O thread stopped reading until the game thread takes the received packets.
+	bool closed;                ///< Whether the connection got closed or failed.
+	bool released;              ///< Whether the game thread stopped using the connection.
+	bool signalled;             ///< Whether the I/O thread is told to look at this connection.
+
+	NetworkIOConnection(SOCKET s, NetworkSocketHandler *cs);
+	~NetworkIOConnection();
+
+	void Signal();
+	void UpdateEvents();
+	void Fail();
+	void Flush();
+	void Read();
+	bool HandleSignal();
+	bool IsDoneLingering(uint32 now) const;
+
+	static void ThreadProc(void *param);
+	friend bool StartNetworkIOThread();
+
+public:
+	static NetworkIOConnection *New(SOCKET s, NetworkSocketHandler *cs);
+
+	Packet *ReceivePacket(bool *closed);
+	SendPacketsState SendPackets(Packet *queue);
+	void Release();
+};
+
+bool StartNetworkIOThread();
+void StopNetworkIOThread();
+
+#else
+
+static inline bool StartNetworkIOThread() { return false; }
+static inline void StopNetworkIOThread() {}
+
+#endif /* ENABLE_NETWORK && HAVE_EPOLL */
+
+#endif /* NETWORK_CORE_TCP_IO_THREAD_H */
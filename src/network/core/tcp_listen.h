@@ -33,6 +33,73 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	/** Number of events that are fetched from epoll at once. */
+	static const int EPOLL_EVENTS = 256;
+
+	/** The epoll instance reporting which sockets are ready, or -1 when select is used. */
+	static int epoll_handle;
+
+	/**
+	 * Let the epoll instance report when a socket is ready to read.
+	 * @param s    The socket.
+	 * @param data The data to report with it: 0 for the listen sockets, the index of the socket handler plus one for the others.
+	 * @return True if the socket is registered.
+	 */
+	static bool EpollAdd(SOCKET s, uint64 data)
+	{
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u64 = data;
+		if (epoll_ctl(epoll_handle, EPOLL_CTL_ADD, s, &event) == 0) return true;
+
+		DEBUG(net, 0, "[%s] epoll_ctl failed with error %d", Tsocket::GetName(), errno);
+		return false;
+	}
+
+	/**
+	 * Let the epoll instance report when the socket of a client is ready.
+	 * The socket is writable until a send would block.
+	 * @param cs The socket handler of the client.
+	 */
+	static void EpollAddClient(Tsocket *cs)
+	{
+		if (!EpollAdd(cs->sock, cs->index + 1)) return;
+
+		cs->epoll_fd = epoll_handle;
+		cs->epoll_data = cs->index + 1;
+		cs->writable = true;
+	}
+
+	/**
+	 * Handle the receiving of packets of the sockets epoll reports to be ready.
+	 * @return true if everything went okay.
+	 */
+	static bool EpollReceive()
+	{
+		struct epoll_event events[EPOLL_EVENTS];
+		int count = epoll_wait(epoll_handle, events, EPOLL_EVENTS, 0);
+
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.u64 == 0) {
+				/* accept clients.. */
+				for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
+					AcceptClient(s->second);
+				}
+				continue;
+			}
+
+			/* The client might have been removed by handling one of the other events. */
+			Tsocket *cs = Tsocket::GetIfValid((size_t)events[i].data.u64 - 1);
+			if (cs == NULL || cs->epoll_fd != epoll_handle) continue;
+
+			if ((events[i].events & EPOLLOUT) != 0) cs->SetWritable(true);
+			if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) cs->ReceivePackets();
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
 	/**
 	 * Accepts clients from the sockets.
@@ -85,7 +152,12 @@ public:
 				continue;
 			}
 
+#ifdef HAVE_EPOLL
+			Tsocket *cs = Tsocket::AcceptConnection(s, address);
+			if (!cs->StartThreadedIO() && epoll_handle != -1) EpollAddClient(cs);
+#else
 			Tsocket::AcceptConnection(s, address);
+#endif
 		}
 	}
 
@@ -95,15 +167,28 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		/* The network I/O thread already received the packets of its sockets. */
+		Tsocket *cs;
+		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+			if (cs->io != NULL) cs->ReceivePackets();
+		}
+
+		if (epoll_handle != -1) return EpollReceive();
+#else
+		Tsocket *cs;
+#endif
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
 		FD_ZERO(&read_fd);
 		FD_ZERO(&write_fd);
 
-
-		Tsocket *cs;
 		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+#ifdef HAVE_EPOLL
+			if (cs->io != NULL) continue;
+#endif
 			FD_SET(cs->sock, &read_fd);
 			FD_SET(cs->sock, &write_fd);
 		}
@@ -127,6 +212,9 @@ public:
 
 		/* read stuff from clients */
 		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+#ifdef HAVE_EPOLL
+			if (cs->io != NULL) continue;
+#endif
 			cs->writable = !!FD_ISSET(cs->sock, &write_fd);
 			if (FD_ISSET(cs->sock, &read_fd)) {
 				cs->ReceivePackets();
@@ -157,6 +245,25 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		/* Let epoll report the ready sockets, so not all sockets have to be checked each tick. */
+		epoll_handle = epoll_create(MAX_CLIENT_SLOTS);
+		if (epoll_handle == -1) {
+			DEBUG(net, 1, "[%s] epoll_create failed with error %d, using select", Tsocket::GetName(), errno);
+			return true;
+		}
+
+		for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
+			EpollAdd(s->second, 0);
+		}
+
+		/* Connections made before, e.g. of the admins when the server restarts, are reported as well. */
+		Tsocket *cs;
+		FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+			if (cs->io == NULL) EpollAddClient(cs);
+		}
+#endif
+
 		return true;
 	}
 
@@ -167,11 +274,26 @@ public:
 			closesocket(s->second);
 		}
 		sockets.Clear();
+
+#ifdef HAVE_EPOLL
+		if (epoll_handle != -1) {
+			/* The remaining connections are checked with select until the next listen. */
+			Tsocket *cs;
+			FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+				cs->epoll_fd = -1;
+			}
+			close(epoll_handle);
+			epoll_handle = -1;
+		}
+#endif
 		DEBUG(net, 1, "[%s] closed listeners", Tsocket::GetName());
 	}
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+#ifdef HAVE_EPOLL
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> int TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_handle = -1;
+#endif
 
 #endif /* ENABLE_NETWORK */
 
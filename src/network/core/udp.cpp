@@ -121,6 +121,7 @@ void NetworkUDPSocketHandler::ReceivePackets()
 		memset(&client_addr, 0, sizeof(client_addr));
 
 		Packet p(this);
+		p.Reserve(SEND_MTU);
 		socklen_t client_len = sizeof(client_addr);
 
 		/* Try to receive anything */
@@ -25,6 +25,7 @@
 #include "network_base.h"
 #include "core/udp.h"
 #include "core/host.h"
+#include "core/tcp_io_thread.h"
 #include "network_gui.h"
 #include "../console_func.h"
 #include "../3rdparty/md5/md5.h"
@@ -37,6 +38,7 @@
 #include "../core/pool_func.hpp"
 #include "../gfx_func.h"
 #include "../error.h"
+#include "../tick_stats.h"
 
 #ifdef DEBUG_DUMP_COMMANDS
 #include "../fileio_func.h"
@@ -56,6 +58,7 @@ bool _network_server;     ///< network-server is active
 bool _network_available;  ///< is network mode available?
 bool _network_dedicated;  ///< are we a dedicated server?
 bool _is_network_server;  ///< Does this client wants to be a network-server?
+bool _network_relay;      ///< are we a dedicated relay of a server's game for spectators?
 NetworkServerGameInfo _network_game_info; ///< Information about our game.
 NetworkCompanyState *_network_company_states = NULL; ///< Statistics about some companies.
 ClientID _network_own_client_id;      ///< Our client identifier.
@@ -76,6 +79,7 @@ uint32 _sync_seed_1;                  ///< Seed to compare during sync checks.
 uint32 _sync_seed_2;                  ///< Second part of the seed.
 #endif
 uint32 _sync_frame;                   ///< The frame to perform the sync check.
+NetworkStateHash _sync_state_hash;    ///< Hashes of the game state to compare during sync checks.
 bool _network_first_time;             ///< Whether we have finished joining or not.
 bool _network_udp_server;             ///< Is the UDP server started?
 uint16 _network_udp_broadcast;        ///< Timeout for the UDP broadcasts.
@@ -491,8 +495,9 @@ void ParseConnectionString(const char **company, const char **port, char *connec
  * Handle the acception of a connection to the server.
  * @param s The socket of the new connection.
  * @param address The address of the peer.
+ * @return The socket handler of the new connection.
  */
-/* static */ void ServerNetworkGameSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
+/* static */ ServerNetworkGameSocketHandler *ServerNetworkGameSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
 {
 	/* Register the login */
 	_network_clients_connected++;
@@ -500,6 +505,7 @@ void ParseConnectionString(const char **company, const char **port, char *connec
 	SetWindowDirty(WC_CLIENT_LIST, 0);
 	ServerNetworkGameSocketHandler *cs = new ServerNetworkGameSocketHandler(s);
 	cs->client_address = address; // Save the IP of the client
+	return cs;
 }
 
 /**
@@ -532,6 +538,7 @@ void NetworkClose(bool close_admins)
 		ServerNetworkGameSocketHandler::CloseListeners();
 		ServerNetworkAdminSocketHandler::CloseListeners();
 	} else if (MyClient::my_client != NULL) {
+		if (_network_relay) NetworkRelayClose();
 		MyClient::SendQuit();
 		MyClient::my_client->CloseConnection(NETWORK_RECV_STATUS_CONN_LOST);
 	}
@@ -556,6 +563,7 @@ static void NetworkInitialize(bool close_admins = true)
 	NetworkUDPInitialize();
 
 	_sync_frame = 0;
+	_sync_state_hash.valid = false;
 	_network_first_time = true;
 
 	_network_reconnect = 0;
@@ -713,6 +721,8 @@ bool NetworkServerStart()
 
 	NetworkDisconnect(false, false);
 	NetworkInitialize(false);
+	/* Let a separate thread read and write the sockets of the clients and admins. */
+	if (_settings_client.network.threaded_io) StartNetworkIOThread();
 	if (!ServerNetworkGameSocketHandler::Listen(_settings_client.network.server_port)) return false;
 
 	/* Only listen for admins when the password isn't empty. */
@@ -720,6 +730,7 @@ bool NetworkServerStart()
 
 	/* Try to start UDP-server */
 	_network_udp_server = _udp_server_socket->Listen();
+	NetworkInvalidateServerInfo();
 
 	_network_company_states = CallocT<NetworkCompanyState>(MAX_COMPANIES);
 	_network_server = true;
@@ -817,6 +828,8 @@ static bool NetworkReceive()
 		ServerNetworkAdminSocketHandler::Receive();
 		return ServerNetworkGameSocketHandler::Receive();
 	} else {
+		/* A relay is the server of its own clients. */
+		if (_network_relay) ServerNetworkGameSocketHandler::Receive();
 		return ClientNetworkGameSocketHandler::Receive();
 	}
 }
@@ -828,6 +841,7 @@ static void NetworkSend()
 		ServerNetworkAdminSocketHandler::Send();
 		ServerNetworkGameSocketHandler::Send();
 	} else {
+		if (_network_relay) ServerNetworkGameSocketHandler::Send();
 		ClientNetworkGameSocketHandler::Send();
 	}
 }
@@ -969,7 +983,9 @@ void NetworkGameLoop()
 			send_frame = true;
 		}
 
+		TickTimingLap(TSP_NETWORK);
 		NetworkExecuteLocalCommandQueue();
+		TickTimingLap(TSP_COMMANDS);
 
 		/* Then we make the frame */
 		StateGameLoop();
@@ -996,6 +1012,8 @@ void NetworkGameLoop()
 				if (!ClientNetworkGameSocketHandler::GameLoop()) return;
 			}
 		}
+
+		if (_network_relay) NetworkRelay_Tick();
 	}
 
 	NetworkSend();
@@ -1067,6 +1085,7 @@ void NetworkShutDown()
 {
 	NetworkDisconnect(true);
 	NetworkUDPClose();
+	StopNetworkIOThread();
 
 	DEBUG(net, 3, "[core] shutting down network");
 
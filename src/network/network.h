@@ -24,6 +24,7 @@ extern bool _network_server;     ///< network-server is active
 extern bool _network_available;  ///< is network mode available?
 extern bool _network_dedicated;  ///< are we a dedicated server?
 extern bool _is_network_server;  ///< Does this client wants to be a network-server?
+extern bool _network_relay;      ///< are we a dedicated relay of a server's game for spectators?
 
 #else /* ENABLE_NETWORK */
 /* Network function stubs when networking is disabled */
@@ -37,6 +38,7 @@ static inline void NetworkDrawChatMessage() {}
 #define _network_available 0
 #define _network_dedicated 0
 #define _is_network_server 0
+#define _network_relay 0
 
 #endif /* ENABLE_NETWORK */
 #endif /* NETWORK_H */
@@ -24,6 +24,12 @@
 #include "../map_func.h"
 #include "../rev.h"
 #include "../game/game.hpp"
+#include "../pathfinder/pf_stats.h"
+#include "../tick_stats.h"
+#include "../vehicle_base.h"
+#include "../cargopacket.h"
+#include "../station_base.h"
+#include "../linkgraph/linkgraph.h"
 
 
 /* This file handles all the admin network commands. */
@@ -54,6 +60,11 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_PATHFINDER_STATS
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_TICK_STATS
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_POOL_STATS
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_LINKGRAPH_STATS
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_CLIENT_TRAFFIC
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -113,11 +124,13 @@ ServerNetworkAdminSocketHandler::~ServerNetworkAdminSocketHandler()
  * Handle the acception of a connection.
  * @param s The socket of the new connection.
  * @param address The address of the peer.
+ * @return The socket handler of the new connection.
  */
-/* static */ void ServerNetworkAdminSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
+/* static */ ServerNetworkAdminSocketHandler *ServerNetworkAdminSocketHandler::AcceptConnection(SOCKET s, const NetworkAddress &address)
 {
 	ServerNetworkAdminSocketHandler *as = new ServerNetworkAdminSocketHandler(s);
 	as->address = address; // Save the IP of the client
+	return as;
 }
 
 /***********
@@ -620,6 +633,122 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCmdLogging(ClientID clien
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the statistics of the path finder searches, one packet per vehicle type. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPathfinderStats()
+{
+	for (VehicleType type = VEH_TRAIN; type < VEH_AIRCRAFT; type++) {
+		const PathfinderStats *stats = &_pathfinder_stats[type];
+		Packet *p = new Packet(ADMIN_PACKET_SERVER_PATHFINDER_STATS);
+
+		p->Send_uint8 (type);
+		p->Send_uint32(stats->calls);
+		p->Send_uint64(stats->nodes);
+		p->Send_uint64(stats->cache_hits);
+		p->Send_uint64(stats->cost_calcs);
+		p->Send_uint32(stats->aborts);
+		p->Send_uint32(stats->not_found);
+		p->Send_uint32(stats->GetTimePercentile(50));
+		p->Send_uint32(stats->GetTimePercentile(90));
+		p->Send_uint32(stats->GetTimePercentile(99));
+		p->Send_uint32(stats->max_us);
+		p->Send_uint64(stats->total_us);
+
+		this->SendPacket(p);
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/** Send the statistics of the durations of the ticks. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendTickStats()
+{
+	const TickStats *stats = &_tick_stats;
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_TICK_STATS);
+
+	p->Send_uint32(stats->ticks);
+	p->Send_uint64(stats->total_us);
+	p->Send_uint32(stats->GetTimePercentile(50));
+	p->Send_uint32(stats->GetTimePercentile(90));
+	p->Send_uint32(stats->GetTimePercentile(99));
+	p->Send_uint32(stats->max_us);
+	p->Send_uint8 (TICK_STATS_TIME_BUCKETS);
+	for (uint i = 0; i < TICK_STATS_TIME_BUCKETS; i++) {
+		p->Send_uint32(stats->time_histogram[i]);
+	}
+	p->Send_uint8 (TSP_END);
+	for (uint i = 0; i < TSP_END; i++) {
+		p->Send_uint64(stats->part_us[i]);
+	}
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * Add the occupancy of a pool to a packet.
+ * @param p    The packet to add the occupancy to.
+ * @param pool The pool.
+ */
+template <typename Tpool>
+static void SendPoolOccupancy(Packet *p, const Tpool &pool)
+{
+	p->Send_string(pool.name);
+	p->Send_uint32((uint32)pool.items);
+	p->Send_uint32((uint32)pool.size);
+	p->Send_uint32((uint32)Tpool::MAX_SIZE);
+}
+
+/** Send the occupancy of the pools of the vehicles, the cargo packets and the stations. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendPoolStats()
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_POOL_STATS);
+
+	p->Send_uint8(3);
+	SendPoolOccupancy(p, _vehicle_pool);
+	SendPoolOccupancy(p, _cargopacket_pool);
+	SendPoolOccupancy(p, _station_pool);
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/** Send the statistics of the joined link graph jobs. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendLinkGraphStats()
+{
+	const LinkGraphJobStats *stats = &_link_graph_job_stats;
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_LINKGRAPH_STATS);
+
+	p->Send_uint32(stats->jobs);
+	p->Send_uint64(stats->nodes);
+	p->Send_uint64(stats->run_us);
+	p->Send_uint32(stats->max_run_us);
+	p->Send_uint64(stats->wait_us);
+	p->Send_uint32(stats->max_wait_us);
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+/**
+ * Send the network traffic of a client.
+ * @param cs The socket of the client.
+ */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendClientTraffic(const NetworkClientSocket *cs)
+{
+	Packet *p = new Packet(ADMIN_PACKET_SERVER_CLIENT_TRAFFIC);
+
+	p->Send_uint32(cs->client_id);
+	p->Send_uint64(cs->bytes_received);
+	p->Send_uint64(cs->bytes_sent);
+
+	this->SendPacket(p);
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /***********
  * Receiving functions
  ************/
@@ -735,6 +864,38 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendCmdNames();
 			break;
 
+		case ADMIN_UPDATE_PATHFINDER_STATS:
+			/* The admin is requesting the path finder statistics. */
+			this->SendPathfinderStats();
+			break;
+
+		case ADMIN_UPDATE_TICK_STATS:
+			/* The admin is requesting the tick statistics. */
+			this->SendTickStats();
+			break;
+
+		case ADMIN_UPDATE_POOL_STATS:
+			/* The admin is requesting the occupancy of the pools. */
+			this->SendPoolStats();
+			break;
+
+		case ADMIN_UPDATE_LINKGRAPH_STATS:
+			/* The admin is requesting the link graph job statistics. */
+			this->SendLinkGraphStats();
+			break;
+
+		case ADMIN_UPDATE_CLIENT_TRAFFIC:
+			/* The admin is requesting the network traffic of one or all clients. */
+			if (d1 == UINT32_MAX) {
+				FOR_ALL_CLIENT_SOCKETS(cs) {
+					this->SendClientTraffic(cs);
+				}
+			} else {
+				cs = NetworkClientSocket::GetByClientID((ClientID)d1);
+				if (cs != NULL) this->SendClientTraffic(cs);
+			}
+			break;
+
 		default:
 			/* An unsupported "poll" update type. */
 			DEBUG(net, 3, "[admin] Not supported poll %d (%d) from '%s' (%s).", type, d1, this->admin_name, this->admin_version);
@@ -996,6 +1157,30 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_PATHFINDER_STATS:
+						as->SendPathfinderStats();
+						break;
+
+					case ADMIN_UPDATE_TICK_STATS:
+						as->SendTickStats();
+						break;
+
+					case ADMIN_UPDATE_POOL_STATS:
+						as->SendPoolStats();
+						break;
+
+					case ADMIN_UPDATE_LINKGRAPH_STATS:
+						as->SendLinkGraphStats();
+						break;
+
+					case ADMIN_UPDATE_CLIENT_TRAFFIC: {
+						const NetworkClientSocket *cs;
+						FOR_ALL_CLIENT_SOCKETS(cs) {
+							as->SendClientTraffic(cs);
+						}
+						break;
+					}
+
 					default: NOT_REACHED();
 				}
 			}
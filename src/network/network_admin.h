@@ -69,9 +69,14 @@ public:
 	NetworkRecvStatus SendGameScript(const char *json);
 	NetworkRecvStatus SendCmdNames();
 	NetworkRecvStatus SendCmdLogging(ClientID client_id, const CommandPacket *cp);
+	NetworkRecvStatus SendPathfinderStats();
+	NetworkRecvStatus SendTickStats();
+	NetworkRecvStatus SendPoolStats();
+	NetworkRecvStatus SendLinkGraphStats();
+	NetworkRecvStatus SendClientTraffic(const NetworkClientSocket *cs);
 
 	static void Send();
-	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
+	static ServerNetworkAdminSocketHandler *AcceptConnection(SOCKET s, const NetworkAddress &address);
 	static bool AllowConnection();
 	static void WelcomeAll();
 
@@ -27,6 +27,15 @@
 #include "../gfx_func.h"
 #include "../error.h"
 #include "../rev.h"
+#include "../viewport_func.h"
+#include "../tilehighlight_func.h"
+#include "../tilearea_type.h"
+#include "../town.h"
+#include "../pbs.h"
+#include "../signal_func.h"
+#include "../rail_map.h"
+#include "../road_map.h"
+#include "../pathfinder/yapf/yapf_cache.h"
 #include "network.h"
 #include "network_base.h"
 #include "network_client.h"
@@ -117,6 +126,328 @@ struct PacketReader : LoadFilter {
 };
 
 
+/** Time in milliseconds after which an own command that the server did not return for execution is not shown as predicted anymore. */
+static const uint PREDICTED_COMMAND_TIMEOUT = 10000;
+
+/** An own construction command that is sent to the server, but that did not come back for execution yet. */
+struct PredictedCommand {
+	CommandContainer cmd; ///< The command as it is sent to the server.
+	CompanyID company;    ///< The company the command is executed for.
+	TileArea area;        ///< The tiles the command is expected to change.
+	uint32 sent;          ///< Value of #_realtime_tick when the command was sent.
+	bool speculative;     ///< Whether the command is executed on the local game state until the server returns it.
+	bool executed;        ///< Whether the command is executed on the local game state since the last rollback, or found not to be executable.
+};
+
+/**
+ * The own construction commands that passed their test run against the
+ * local game state and are sent to the server. Their tiles are highlighted
+ * until the server returns the commands for execution in a frame.
+ */
+static SmallVector<PredictedCommand, 8> _predicted_commands;
+
+/** A tile as it was before a speculative command changed it. */
+struct PredictedTile {
+	TileIndex index; ///< The tile.
+	Tile m;          ///< The original contents of #_m.
+	TileExtended me; ///< The original contents of #_me.
+};
+
+/** The parts of a company a speculative command may change. */
+struct PredictedCompany {
+	bool valid;                               ///< Whether the company existed.
+	Money money;                              ///< The original money of the company.
+	Money expenses[EXPENSES_END];             ///< The original expenses of this year.
+	CompanyEconomyEntry cur_economy;          ///< The original economy of this quarter.
+	CompanyInfrastructure infrastructure;     ///< The original infrastructure counts.
+	uint32 clear_limit;                       ///< The original amount of tiles that can be cleared.
+};
+
+/** The ratings of a town, which removing trees or town roads changes. */
+struct PredictedTown {
+	TownID index;                  ///< The town.
+	CompanyMask have_ratings;      ///< The original companies that have a rating.
+	int16 ratings[MAX_COMPANIES];  ///< The original ratings.
+};
+
+/*
+ * The state of the game before the speculative commands were executed on it,
+ * so it can be rolled back before the game state advances. A speculative
+ * command can only change the tiles of its area, the companies and the
+ * ratings of towns; the commands that change anything else, like vehicles,
+ * stations and signals elsewhere, are not executed speculatively.
+ */
+static bool _predictions_applied = false;                         ///< Whether the speculative commands changed the game state.
+static SmallVector<PredictedTile, 64> _predicted_tiles;           ///< The tiles before the speculative commands, in the order they were saved.
+static PredictedCompany _predicted_companies[MAX_COMPANIES];      ///< The companies before the speculative commands.
+static SmallVector<PredictedTown, 64> _predicted_towns;           ///< The towns before the speculative commands.
+static Randomizer _predicted_random;                              ///< The random state before the speculative commands.
+
+/**
+ * Redraw the tiles of a predicted command.
+ * @param pc The predicted command.
+ */
+static void MarkPredictedCommandDirty(const PredictedCommand *pc)
+{
+	TILE_AREA_LOOP(tile, pc->area) MarkTileDirtyByTile(tile);
+}
+
+/**
+ * Check whether a command only changes things that can be rolled back,
+ * so it can be executed speculatively, and determine the tiles it changes.
+ * @param cmd  The command.
+ * @param area Is set to the tiles the command changes.
+ * @return True if the command can be executed speculatively.
+ */
+static bool GetSpeculativeCommandArea(const CommandContainer *cmd, TileArea *area)
+{
+	switch (cmd->cmd & CMD_ID_MASK) {
+		case CMD_BUILD_SINGLE_RAIL:
+		case CMD_REMOVE_SINGLE_RAIL:
+		case CMD_BUILD_ROAD:
+			*area = TileArea(cmd->tile, 1, 1);
+			return true;
+
+		case CMD_BUILD_RAILROAD_TRACK:
+		case CMD_REMOVE_RAILROAD_TRACK:
+		case CMD_BUILD_LONG_ROAD:
+		case CMD_REMOVE_LONG_ROAD:
+			/* The end of the drag is the first parameter. */
+			if (cmd->p1 >= MapSize()) return false;
+			*area = TileArea(cmd->tile, cmd->p1);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ * Check whether the tiles of a speculative command can be rolled back by
+ * restoring the tiles alone. That is not the case for tiles that are tied
+ * to other tiles or to vehicles, like bridges, stations and reserved tracks.
+ * @param area The tiles the command changes.
+ * @return True if the command can be executed on these tiles speculatively.
+ */
+static bool CanPredictTiles(const TileArea &area)
+{
+	TILE_AREA_LOOP(tile, area) {
+		switch (GetTileType(tile)) {
+			case MP_CLEAR:
+			case MP_TREES:
+				break;
+
+			case MP_RAILWAY:
+				if (IsRailDepot(tile) || GetRailReservationTrackBits(tile) != TRACK_BIT_NONE) return false;
+				break;
+
+			case MP_ROAD:
+				if (IsRoadDepot(tile) || (IsLevelCrossing(tile) && HasCrossingReservation(tile))) return false;
+				break;
+
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+/** Save the parts of the game state outside the tiles that a speculative command may change. */
+static void SavePredictedState()
+{
+	_predicted_random = _random;
+
+	for (CompanyID cid = COMPANY_FIRST; cid < MAX_COMPANIES; cid++) {
+		PredictedCompany *pc = &_predicted_companies[cid];
+		const Company *c = Company::GetIfValid(cid);
+		pc->valid = c != NULL;
+		if (c == NULL) continue;
+
+		pc->money = c->money;
+		for (uint i = 0; i < EXPENSES_END; i++) pc->expenses[i] = c->yearly_expenses[0][i];
+		pc->cur_economy = c->cur_economy;
+		pc->infrastructure = c->infrastructure;
+		pc->clear_limit = c->clear_limit;
+	}
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		PredictedTown *pt = _predicted_towns.Append();
+		pt->index = t->index;
+		pt->have_ratings = t->have_ratings;
+		MemCpyT(pt->ratings, t->ratings, lengthof(pt->ratings));
+	}
+}
+
+/**
+ * Execute a predicted command on the local game state, to show its result
+ * until the server returns the command for execution.
+ * @param pc The predicted command.
+ */
+static void ExecutePredictedCommand(PredictedCommand *pc)
+{
+	if (pc->executed) return;
+	pc->executed = true;
+
+	if (!pc->speculative || !Company::IsValidID(pc->company) || !CanPredictTiles(pc->area)) return;
+
+	if (!_predictions_applied) {
+		SavePredictedState();
+		_predictions_applied = true;
+	}
+
+	TILE_AREA_LOOP(tile, pc->area) {
+		PredictedTile *pt = _predicted_tiles.Append();
+		pt->index = tile;
+		pt->m = _m[tile];
+		pt->me = _me[tile];
+	}
+
+	/* The signals of the changed tracks are not updated, as they may be anywhere on the map. */
+	Backup<CompanyByte> cur_company(_current_company, pc->company, FILE_LINE);
+	SetSignalUpdatesDiscarded(true);
+	DoCommand(&pc->cmd, CommandFlagsToDCFlags(GetCommandFlags(pc->cmd.cmd)) | DC_EXEC);
+	SetSignalUpdatesDiscarded(false);
+	cur_company.Restore();
+}
+
+/**
+ * Undo the speculative commands, so the local game state is the same as
+ * the one of the server again.
+ */
+void NetworkClientRollbackCommands()
+{
+	for (PredictedCommand *pc = _predicted_commands.Begin(); pc != _predicted_commands.End(); pc++) pc->executed = false;
+
+	if (!_predictions_applied) return;
+
+	/* Restore in reverse order, as overlapping commands saved some tiles more than once. */
+	for (const PredictedTile *pt = _predicted_tiles.End(); pt != _predicted_tiles.Begin(); /* nothing */) {
+		pt--;
+		NotifyTileChange(pt->index);
+		_m[pt->index] = pt->m;
+		_me[pt->index] = pt->me;
+		MarkTileDirtyByTile(pt->index);
+	}
+
+	for (CompanyID cid = COMPANY_FIRST; cid < MAX_COMPANIES; cid++) {
+		const PredictedCompany *pc = &_predicted_companies[cid];
+		Company *c = Company::GetIfValid(cid);
+		if (!pc->valid || c == NULL) continue;
+
+		c->money = pc->money;
+		for (uint i = 0; i < EXPENSES_END; i++) c->yearly_expenses[0][i] = pc->expenses[i];
+		c->cur_economy = pc->cur_economy;
+		c->infrastructure = pc->infrastructure;
+		c->clear_limit = pc->clear_limit;
+		InvalidateCompanyWindows(c);
+		DirtyCompanyInfrastructureWindows(c->index);
+	}
+
+	for (const PredictedTown *pt = _predicted_towns.Begin(); pt != _predicted_towns.End(); pt++) {
+		Town *t = Town::GetIfValid(pt->index);
+		if (t == NULL) continue;
+
+		t->have_ratings = pt->have_ratings;
+		MemCpyT(t->ratings, pt->ratings, lengthof(t->ratings));
+	}
+
+	_random = _predicted_random;
+
+	/* The caches of the track layout saw the speculative tracks. */
+	InvalidateReservationCache();
+	InvalidateSignalSegmentCache();
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+
+	_predicted_tiles.Clear();
+	_predicted_towns.Clear();
+	_predictions_applied = false;
+}
+
+/** Execute the speculative commands that are not executed since the last rollback, on top of the current game state. */
+static void ReplayPredictedCommands()
+{
+	for (PredictedCommand *pc = _predicted_commands.Begin(); pc != _predicted_commands.End(); pc++) {
+		ExecutePredictedCommand(pc);
+	}
+}
+
+/**
+ * Remember an own command that is sent to the server to show its result
+ * provisionally. Rail and road construction is executed on the local game
+ * state when the packets are sent, and rolled back before the next frame. The
+ * command cannot be executed right away, as this is called from within
+ * DoCommandP. The tiles other
+ * construction commands change are estimated from the selection the
+ * command was placed with.
+ * @param cp The command that passed its test run and is sent to the server.
+ */
+static void PredictCommand(const CommandPacket *cp)
+{
+	if (cp->tile == 0 || cp->tile >= MapSize() || GetCommandType(cp->cmd) != CMDT_LANDSCAPE_CONSTRUCTION) return;
+
+	PredictedCommand *pc = _predicted_commands.Append();
+	pc->cmd = *cp;
+	pc->cmd.cmd = cp->cmd & CMD_ID_MASK;
+	pc->cmd.callback = NULL;
+	pc->company = cp->company;
+	pc->area = TileArea(cp->tile, 1, 1);
+	pc->sent = _realtime_tick;
+	pc->speculative = GetSpeculativeCommandArea(&pc->cmd, &pc->area);
+	pc->executed = false;
+
+	if (!pc->speculative && (_thd.drawstyle & HT_DRAG_MASK) == HT_RECT && !_thd.diagonal && _thd.pos.x >= 0 && _thd.pos.y >= 0 && _thd.size.x > 0 && _thd.size.y > 0 &&
+			_thd.pos.x + _thd.size.x <= (int)(MapSizeX() * TILE_SIZE) && _thd.pos.y + _thd.size.y <= (int)(MapSizeY() * TILE_SIZE)) {
+		TileArea selection(TileVirtXY(_thd.pos.x, _thd.pos.y), TileVirtXY(_thd.pos.x + _thd.size.x - 1, _thd.pos.y + _thd.size.y - 1));
+		if (selection.Contains(cp->tile)) pc->area = selection;
+	}
+
+	MarkPredictedCommandDirty(pc);
+}
+
+/**
+ * Remove the prediction of an own command, as the server returned it for
+ * execution and its actual result is now in the game state.
+ * @param cp The executed command.
+ */
+void NetworkClientReconcileCommand(const CommandPacket *cp)
+{
+	for (PredictedCommand *pc = _predicted_commands.Begin(); pc != _predicted_commands.End(); pc++) {
+		if (pc->cmd.cmd != (cp->cmd & CMD_ID_MASK) || pc->cmd.tile != cp->tile || pc->cmd.p1 != cp->p1 || pc->cmd.p2 != cp->p2) continue;
+
+		MarkPredictedCommandDirty(pc);
+		_predicted_commands.Erase(pc);
+		return;
+	}
+}
+
+/** Stop showing the predictions of own commands the server did not return, e.g. because it refused them. */
+static void ExpirePredictedCommands()
+{
+	for (PredictedCommand *pc = _predicted_commands.Begin(); pc != _predicted_commands.End(); /* nothing */) {
+		if (_realtime_tick - pc->sent < PREDICTED_COMMAND_TIMEOUT) {
+			pc++;
+			continue;
+		}
+
+		MarkPredictedCommandDirty(pc);
+		_predicted_commands.Erase(pc);
+	}
+}
+
+/**
+ * Check whether a tile is changed by an own command that is sent to the server, but not executed yet.
+ * @param tile The tile to check.
+ * @return True when the tile should be highlighted as pending.
+ */
+bool NetworkIsTilePredicted(TileIndex tile)
+{
+	for (const PredictedCommand *pc = _predicted_commands.Begin(); pc != _predicted_commands.End(); pc++) {
+		if (pc->area.Contains(tile)) return true;
+	}
+	return false;
+}
+
 /**
  * Create a new socket for the client side of the game connection.
  * @param s The socket to connect with.
@@ -134,6 +465,12 @@ ClientNetworkGameSocketHandler::~ClientNetworkGameSocketHandler()
 	ClientNetworkGameSocketHandler::my_client = NULL;
 
 	delete this->savegame;
+
+	/* The game state of the connection is left behind, so nothing has to be rolled back. */
+	_predicted_commands.Clear();
+	_predicted_tiles.Clear();
+	_predicted_towns.Clear();
+	_predictions_applied = false;
 }
 
 NetworkRecvStatus ClientNetworkGameSocketHandler::CloseConnection(NetworkRecvStatus status)
@@ -225,6 +562,9 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 /** Send the packets of this socket handler. */
 /*static */ void ClientNetworkGameSocketHandler::Send()
 {
+	/* Show the provisional result of the commands that were sent since the last frame. */
+	ReplayPredictedCommands();
+
 	my_client->SendPackets();
 	my_client->CheckConnection();
 }
@@ -235,9 +575,13 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
  */
 /* static */ bool ClientNetworkGameSocketHandler::GameLoop()
 {
+	/* The frame continues from the game state of the server, not from our speculation. */
+	NetworkClientRollbackCommands();
+
 	_frame_counter++;
 
 	NetworkExecuteLocalCommandQueue();
+	ExpirePredictedCommands();
 
 	extern void StateGameLoop();
 	StateGameLoop();
@@ -245,10 +589,12 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 	/* Check if we are in sync! */
 	if (_sync_frame != 0) {
 		if (_sync_frame == _frame_counter) {
+			/* Compare the hashes of the game state too; they tell which part of the game diverged. */
+			bool in_sync = _sync_state_hash.Verify();
 #ifdef NETWORK_SEND_DOUBLE_SEED
-			if (_sync_seed_1 != _random.state[0] || _sync_seed_2 != _random.state[1]) {
+			if (!in_sync || _sync_seed_1 != _random.state[0] || _sync_seed_2 != _random.state[1]) {
 #else
-			if (_sync_seed_1 != _random.state[0]) {
+			if (!in_sync || _sync_seed_1 != _random.state[0]) {
 #endif
 				NetworkError(STR_NETWORK_ERROR_DESYNC);
 				DEBUG(desync, 1, "sync_err: %08x; %02x", _date, _date_fract);
@@ -272,6 +618,8 @@ void ClientNetworkGameSocketHandler::ClientError(NetworkRecvStatus res)
 		}
 	}
 
+	ReplayPredictedCommands();
+
 	return true;
 }
 
@@ -410,6 +758,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::SendCommand(const CommandPacke
 	my_client->NetworkGameSocketHandler::SendCommand(p, cp);
 
 	my_client->SendPacket(p);
+	PredictCommand(cp);
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
@@ -593,6 +942,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CLIENT_INFO(Pac
 
 	if (this->status < STATUS_AUTHORIZED) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
 	if (this->HasClientQuit()) return NETWORK_RECV_STATUS_CONN_LOST;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	ci = NetworkClientInfo::GetByClientID(client_id);
 	if (ci != NULL) {
@@ -850,6 +1200,9 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_MAP_DONE(Packet
 	/* Say we received the map and loaded it correctly! */
 	SendMapOk();
 
+	/* A relay can hand out its copy of the game now. */
+	if (_network_relay && !NetworkRelayStart()) return NETWORK_RECV_STATUS_CONN_LOST;
+
 	/* New company/spectator (invalid company) or company we want to join is not active
 	 * Switch local company to spectator and await the server's judgement */
 	if (_network_join_as == COMPANY_NEW_COMPANY || !Company::IsValidID(_network_join_as)) {
@@ -885,6 +1238,8 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_FRAME(Packet *p
 #ifdef NETWORK_SEND_DOUBLE_SEED
 		_sync_seed_2 = p->Recv_uint32();
 #endif
+		_sync_state_hash.valid = false;
+		if (_network_relay) NetworkRelayFrameSeed();
 	}
 #endif
 	/* Receive the token. */
@@ -912,6 +1267,9 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_SYNC(Packet *p)
 #ifdef NETWORK_SEND_DOUBLE_SEED
 	_sync_seed_2 = p->Recv_uint32();
 #endif
+	_sync_state_hash.Recv(p);
+
+	if (_network_relay) NetworkRelaySync();
 
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -932,12 +1290,52 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMAND(Packet
 
 	this->incoming_queue.Append(&cp);
 
+	if (_network_relay) {
+		NetworkRelayCommand(&cp);
+		NetworkRelayDistributeCommands();
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
+NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMMANDS(Packet *p)
+{
+	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+
+	uint32 frame = p->Recv_uint32();
+
+	bool my_cmd[UINT8_MAX + 1];
+	memset(my_cmd, 0, sizeof(my_cmd));
+	for (uint own_count = p->Recv_uint8(); own_count > 0; own_count--) {
+		my_cmd[p->Recv_uint8()] = true;
+	}
+
+	for (uint i = 0, count = p->Recv_uint8(); i < count; i++) {
+		CommandPacket cp;
+		const char *err = this->ReceiveCommand(p, &cp);
+		if (err != NULL) {
+			IConsolePrintF(CC_ERROR, "WARNING: %s from server, dropping...", err);
+			return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+		}
+
+		/* The callback is only for the client that sent the command. */
+		cp.frame  = frame;
+		cp.my_cmd = my_cmd[i];
+		if (!cp.my_cmd) cp.callback = NULL;
+
+		this->incoming_queue.Append(&cp);
+		if (_network_relay) NetworkRelayCommand(&cp);
+	}
+
+	if (_network_relay) NetworkRelayDistributeCommands();
+
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CHAT(Packet *p)
 {
 	if (this->status != STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	char name[NETWORK_NAME_LENGTH], msg[NETWORK_CHAT_LENGTH];
 	const NetworkClientInfo *ci = NULL, *ci_to;
@@ -990,6 +1388,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CHAT(Packet *p)
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_ERROR_QUIT(Packet *p)
 {
 	if (this->status < STATUS_AUTHORIZED) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	ClientID client_id = (ClientID)p->Recv_uint32();
 
@@ -1007,6 +1406,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_ERROR_QUIT(Pack
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_QUIT(Packet *p)
 {
 	if (this->status < STATUS_AUTHORIZED) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	ClientID client_id = (ClientID)p->Recv_uint32();
 
@@ -1027,6 +1427,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_QUIT(Packet *p)
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_JOIN(Packet *p)
 {
 	if (this->status < STATUS_AUTHORIZED) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	ClientID client_id = (ClientID)p->Recv_uint32();
 
@@ -1060,6 +1461,8 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_NEWGAME(Packet
 		 * Client ID modulo 16. This way reconnects should be spread
 		 * out a bit. */
 		_network_reconnect = _network_own_client_id % 16;
+		/* A relay has to reconnect, as it quits otherwise. */
+		if (_network_relay && _network_reconnect == 0) _network_reconnect = 1;
 		ShowErrorMessage(STR_NETWORK_MESSAGE_SERVER_REBOOT, INVALID_STRING_ID, WL_CRITICAL);
 	}
 
@@ -1122,6 +1525,7 @@ NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_CONFIG_UPDATE(P
 NetworkRecvStatus ClientNetworkGameSocketHandler::Receive_SERVER_COMPANY_UPDATE(Packet *p)
 {
 	if (this->status < STATUS_ACTIVE) return NETWORK_RECV_STATUS_MALFORMED_PACKET;
+	if (_network_relay) NetworkRelayPacket(p);
 
 	_network_company_passworded = p->Recv_uint16();
 	SetWindowClassesDirty(WC_COMPANY);
@@ -41,6 +41,7 @@ private:
 
 protected:
 	friend void NetworkExecuteLocalCommandQueue();
+	friend void NetworkSyncCommandQueue(CommandQueue *to);
 	friend void NetworkClose(bool close_admins);
 	static ClientNetworkGameSocketHandler *my_client; ///< This is us!
 
@@ -61,6 +62,7 @@ protected:
 	virtual NetworkRecvStatus Receive_SERVER_FRAME(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_SYNC(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_COMMAND(Packet *p);
+	virtual NetworkRecvStatus Receive_SERVER_COMMANDS(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_CHAT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_QUIT(Packet *p);
 	virtual NetworkRecvStatus Receive_SERVER_ERROR_QUIT(Packet *p);
@@ -112,6 +114,7 @@ typedef ClientNetworkGameSocketHandler MyClient;
 
 void NetworkClient_Connected();
 void NetworkClientSetCompanyPassword(const char *password);
+void NetworkClientReconcileCommand(const CommandPacket *cp);
 
 extern CompanyID _network_join_as;
 
@@ -169,20 +169,23 @@ void NetworkSendCommand(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, Comman
 }
 
 /**
- * Sync our local command queue to the command queue of the given
- * socket. This is needed for the case where we receive a command
- * before saving the game for a joining client, but without the
- * execution of those commands. Not syncing those commands means
- * that the client will never get them and as such will be in a
- * desynced state from the time it started with joining.
- * @param cs The client to sync the queue to.
+ * Sync our local command queue to the given command queue. This is
+ * needed for the case where we receive a command before saving the
+ * game for a joining client, but without the execution of those
+ * commands. Not syncing those commands means that the client will
+ * never get them and as such will be in a desynced state from the
+ * time it started with joining.
+ * @param to The queue to sync our local command queue to.
  */
-void NetworkSyncCommandQueue(NetworkClientSocket *cs)
+void NetworkSyncCommandQueue(CommandQueue *to)
 {
-	for (CommandPacket *p = _local_execution_queue.Peek(); p != NULL; p = p->next) {
+	/* A relay has the commands still to be executed in the queue of its connection to the relayed server. */
+	CommandQueue &queue = (_network_server ? _local_execution_queue : ClientNetworkGameSocketHandler::my_client->incoming_queue);
+
+	for (CommandPacket *p = queue.Peek(); p != NULL; p = p->next) {
 		CommandPacket c = *p;
 		c.callback = 0;
-		cs->outgoing_queue.Append(&c);
+		to->Append(&c);
 	}
 }
 
@@ -211,6 +214,7 @@ void NetworkExecuteLocalCommandQueue()
 		_current_company = cp->company;
 		cp->cmd |= CMD_NETWORK_COMMAND;
 		DoCommandP(cp, cp->my_cmd);
+		if (cp->my_cmd && !_network_server) NetworkClientReconcileCommand(cp);
 
 		queue.Pop();
 		free(cp);
@@ -233,25 +237,19 @@ void NetworkFreeLocalCommandQueue()
  * "Send" a particular CommandPacket to all clients.
  * @param cp    The command that has to be distributed.
  * @param owner The client that owns the command,
+ * @param batch [in,out] The batch of commands for the clients; created when NULL.
  */
-static void DistributeCommandPacket(CommandPacket cp, const NetworkClientSocket *owner)
+static void DistributeCommandPacket(CommandPacket cp, const NetworkClientSocket *owner, NetworkCommandBatch **batch)
 {
-	CommandCallback *callback = cp.callback;
 	cp.frame = _frame_counter_max + 1;
 
-	NetworkClientSocket *cs;
-	FOR_ALL_CLIENT_SOCKETS(cs) {
-		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
-			/* Callbacks are only send back to the client who sent them in the
-			 *  first place. This filters that out. */
-			cp.callback = (cs != owner) ? NULL : callback;
-			cp.my_cmd = (cs == owner);
-			cs->outgoing_queue.Append(&cp);
-		}
-	}
+	/* The clients get the command in the batch of this frame. Callbacks
+	 * are only used by the client who sent them in the first place. */
+	if (*batch == NULL) *batch = new NetworkCommandBatch(cp.frame);
+	(*batch)->Append(&cp, owner == NULL ? INVALID_CLIENT_ID : owner->client_id);
 
-	cp.callback = (cs != owner) ? NULL : callback;
-	cp.my_cmd = (cs == owner);
+	if (owner != NULL) cp.callback = NULL;
+	cp.my_cmd = (owner == NULL);
 	_local_execution_queue.Append(&cp);
 }
 
@@ -259,8 +257,9 @@ static void DistributeCommandPacket(CommandPacket cp, const NetworkClientSocket
  * "Send" a particular CommandQueue to all clients.
  * @param queue The queue of commands that has to be distributed.
  * @param owner The client that owns the commands,
+ * @param batch [in,out] The batch of commands for the clients; created when NULL.
  */
-static void DistributeQueue(CommandQueue *queue, const NetworkClientSocket *owner)
+static void DistributeQueue(CommandQueue *queue, const NetworkClientSocket *owner, NetworkCommandBatch **batch)
 {
 #ifdef DEBUG_DUMP_COMMANDS
 	/* When replaying we do not want this limitation. */
@@ -271,7 +270,7 @@ static void DistributeQueue(CommandQueue *queue, const NetworkClientSocket *owne
 
 	CommandPacket *cp;
 	while (--to_go >= 0 && (cp = queue->Pop(true)) != NULL) {
-		DistributeCommandPacket(*cp, owner);
+		DistributeCommandPacket(*cp, owner, batch);
 		NetworkAdminCmdLogging(owner, cp);
 		free(cp);
 	}
@@ -280,14 +279,29 @@ static void DistributeQueue(CommandQueue *queue, const NetworkClientSocket *owne
 /** Distribute the commands of ourself and the clients. */
 void NetworkDistributeCommands()
 {
+	NetworkCommandBatch *batch = NULL;
+
 	/* First send the server's commands. */
-	DistributeQueue(&_local_wait_queue, NULL);
+	DistributeQueue(&_local_wait_queue, NULL, &batch);
 
 	/* Then send the queues of the others. */
 	NetworkClientSocket *cs;
 	FOR_ALL_CLIENT_SOCKETS(cs) {
-		DistributeQueue(&cs->incoming_queue, cs);
+		DistributeQueue(&cs->incoming_queue, cs, &batch);
+	}
+
+	if (batch == NULL) return;
+
+	NetworkMapImageAddCommands(batch);
+
+	/* All clients that follow the commands share the batch. */
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
+			batch->AddRef();
+			*cs->command_batches.Append() = batch;
+		}
 	}
+	batch->Release();
 }
 
 /**
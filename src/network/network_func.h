@@ -18,6 +18,7 @@
 #include "../gfx_type.h"
 #include "../openttd.h"
 #include "../company_type.h"
+#include "../tile_type.h"
 
 #ifdef ENABLE_NETWORK
 
@@ -44,6 +45,8 @@ void NetworkBackgroundLoop();
 void ParseConnectionString(const char **company, const char **port, char *connection_string);
 void NetworkStartDebugLog(NetworkAddress address);
 void NetworkPopulateCompanyStats(NetworkCompanyStats *stats);
+const NetworkCompanyStats *NetworkGetQueryCompanyStats();
+void NetworkInvalidateServerInfo();
 
 void NetworkUpdateClientInfo(ClientID client_id);
 void NetworkClientsToSpectators(CompanyID cid);
@@ -52,6 +55,8 @@ void NetworkClientRequestMove(CompanyID company, const char *pass = "");
 void NetworkClientSendRcon(const char *password, const char *command);
 void NetworkClientSendChat(NetworkAction action, DestType type, int dest, const char *msg, int64 data = 0);
 bool NetworkClientPreferTeamChat(const NetworkClientInfo *cio);
+bool NetworkIsTilePredicted(TileIndex tile);
+void NetworkClientRollbackCommands();
 bool NetworkCompanyIsPassworded(CompanyID company_id);
 bool NetworkMaxCompaniesReached();
 bool NetworkMaxSpectatorsReached();
@@ -65,6 +70,7 @@ void NetworkServerYearlyLoop();
 void NetworkServerSendConfigUpdate();
 void NetworkServerShowStatusToConsole();
 bool NetworkServerStart();
+void NetworkRelayClose();
 void NetworkServerUpdateCompanyPassworded(CompanyID company_id, bool passworded);
 bool NetworkServerChangeClientName(ClientID client_id, const char *new_name);
 
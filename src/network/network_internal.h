@@ -14,8 +14,10 @@
 
 #include "network_func.h"
 #include "core/tcp_game.h"
+#include "network_state_hash.h"
 
 #include "../command_type.h"
+#include "../date_type.h"
 
 #ifdef ENABLE_NETWORK
 
@@ -54,6 +56,12 @@ extern bool _ddc_fastforward;
 #define _ddc_fastforward (false)
 #endif /* DEBUG_DUMP_COMMANDS */
 
+/**
+ * Time in milliseconds, one game day, the answers to the queries of clients
+ * that did not join the game are kept before they are built again.
+ */
+static const uint NETWORK_QUERY_CACHE_TIME = DAY_TICKS * MILLISECONDS_PER_TICK;
+
 typedef class ServerNetworkGameSocketHandler NetworkClientSocket;
 
 /** Status of the clients during joining. */
@@ -124,6 +132,7 @@ extern uint32 _sync_seed_1;
 extern uint32 _sync_seed_2;
 #endif
 extern uint32 _sync_frame;
+extern NetworkStateHash _sync_state_hash;
 extern bool _network_first_time;
 /* Vars needed for the join-GUI */
 extern NetworkJoinStatus _network_join_status;
@@ -163,7 +172,17 @@ struct CommandPacket : CommandContainer {
 void NetworkDistributeCommands();
 void NetworkExecuteLocalCommandQueue();
 void NetworkFreeLocalCommandQueue();
-void NetworkSyncCommandQueue(NetworkClientSocket *cs);
+void NetworkSyncCommandQueue(CommandQueue *to);
+
+/* From network_server.cpp, for relaying the game of a server. */
+bool NetworkRelayStart();
+void NetworkRelayCommand(const CommandPacket *cp);
+void NetworkRelayDistributeCommands();
+void NetworkRelaySync();
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+void NetworkRelayFrameSeed();
+#endif
+void NetworkRelayPacket(const Packet *p);
 
 void NetworkError(StringID error_string);
 void NetworkTextMessage(NetworkAction action, TextColour colour, bool self_send, const char *name, const char *str = "", int64 data = 0);
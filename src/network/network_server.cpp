@@ -18,6 +18,7 @@
 #include "network_server.h"
 #include "network_udp.h"
 #include "network_base.h"
+#include "core/tcp_io_thread.h"
 #include "../console_func.h"
 #include "../company_base.h"
 #include "../command_func.h"
@@ -52,63 +53,225 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
+/** Number of frames after saving the game for a joining client that other joining clients get the same savegame. */
+static const uint32 NETWORK_MAP_IMAGE_FRAMES = DAY_TICKS;
+
+/**
+ * The compressed savegame for the clients that are downloading the map. The
+ * clients that request the map within #NETWORK_MAP_IMAGE_FRAMES frames share
+ * the savegame, so the game is saved and compressed only once for them. The
+ * later ones catch up with the commands that were distributed meanwhile.
+ */
+struct NetworkMapImage {
+	ThreadMutex *mutex;                 ///< Mutex for making threaded saving safe.
+	uint32 frame;                       ///< The frame the game was saved in.
+	SmallVector<Packet *, 256> packets; ///< The packets of the savegame that are written; the last one is #PACKET_SERVER_MAP_DONE.
+	size_t total_size;                  ///< Total size of the compressed savegame.
+	bool finished;                      ///< Whether the whole savegame is written.
+	uint clients;                       ///< Number of clients downloading the savegame.
+	uint refs;                          ///< Number of clients, writers and caches using the savegame.
+
+	/* Only used by the main thread, while the savegame is offered to joining clients. */
+	CommandQueue commands;                          ///< The commands that were still to be executed when the game was saved.
+	SmallVector<NetworkCommandBatch *, 16> batches; ///< The commands that were distributed since the game was saved.
+
+	/** Create the image of the game in the current frame. */
+	NetworkMapImage() : mutex(ThreadMutex::New()), frame(_frame_counter), total_size(0), finished(false), clients(0), refs(1)
+	{
+	}
+
+	/** Free the packets. */
+	~NetworkMapImage()
+	{
+		for (Packet **p = this->packets.Begin(); p != this->packets.End(); p++) delete *p;
+		delete this->mutex;
+	}
+
+	/** Add a user of the image. */
+	void AddRef()
+	{
+		this->mutex->BeginCritical();
+		this->refs++;
+		this->mutex->EndCritical();
+	}
+
+	/**
+	 * Check whether any client is still downloading the image.
+	 * @return True if at least one client downloads the image.
+	 */
+	bool HasClients()
+	{
+		this->mutex->BeginCritical();
+		bool has_clients = this->clients != 0;
+		this->mutex->EndCritical();
+		return has_clients;
+	}
+
+	/** Remove a user of the image, and delete the image when it was the last one. */
+	void Release()
+	{
+		this->mutex->BeginCritical();
+		bool last = --this->refs == 0;
+		this->mutex->EndCritical();
+
+		if (last) delete this;
+	}
+};
+
+/**
+ * Create an empty batch of commands.
+ * @param frame The frame the commands are executed in.
+ */
+NetworkCommandBatch::NetworkCommandBatch(uint32 frame) : frame(frame), refs(1)
+{
+}
+
+/** Free the packets. */
+NetworkCommandBatch::~NetworkCommandBatch()
+{
+	for (Packet **p = this->packets.Begin(); p != this->packets.End(); p++) delete *p;
+}
+
+/**
+ * Add a command to the batch.
+ * @param cp    The command.
+ * @param owner The client that sent the command, or #INVALID_CLIENT_ID when it is of the server.
+ */
+void NetworkCommandBatch::Append(const CommandPacket *cp, ClientID owner)
+{
+	/* Company, command, p1, p2, tile, text and callback. */
+	size_t size = 1 + 4 + 4 + 4 + 4 + strlen(cp->text) + 1 + 1;
+
+	/* Keep room for the frame and the indices of the commands of the client
+	 * they are sent to, in case all of them are of that client. */
+	Packet *p = this->packets.Length() == 0 ? NULL : this->packets[this->packets.Length() - 1];
+	if (p == NULL || p->buffer[sizeof(PacketSize) + 1] == UINT8_MAX ||
+			p->size + size + 4 + 1 + p->buffer[sizeof(PacketSize) + 1] + 1 > SEND_MTU) {
+		p = new Packet(PACKET_SERVER_COMMANDS);
+		p->Send_uint8(0);
+		*this->packets.Append() = p;
+	}
+
+	if (owner != INVALID_CLIENT_ID) {
+		OwnCommand *own = this->own_commands.Append();
+		own->client_id = owner;
+		own->packet = this->packets.Length() - 1;
+		own->index = p->buffer[sizeof(PacketSize) + 1];
+	}
+
+	NetworkGameSocketHandler::SendCommand(p, cp);
+	p->buffer[sizeof(PacketSize) + 1]++;
+}
+
+/** The savegame that clients requesting the map get, if any. */
+static NetworkMapImage *_network_map_image = NULL;
+
+/** Stop offering the last savegame to joining clients. */
+static void ReleaseNetworkMapImage()
+{
+	if (_network_map_image == NULL) return;
+
+	_network_map_image->commands.Free();
+	for (NetworkCommandBatch **iter = _network_map_image->batches.Begin(); iter != _network_map_image->batches.End(); iter++) {
+		(*iter)->Release();
+	}
+	_network_map_image->batches.Clear();
+
+	_network_map_image->Release();
+	_network_map_image = NULL;
+}
+
+/**
+ * Check whether clients requesting the map now can get the last savegame.
+ * @return True if the savegame is recent enough to be shared.
+ */
+static bool CanShareNetworkMapImage()
+{
+	return _network_map_image != NULL && _frame_counter - _network_map_image->frame <= NETWORK_MAP_IMAGE_FRAMES;
+}
+
+/**
+ * Keep distributed commands for the clients that get the last savegame
+ * later, as they will not get the commands otherwise.
+ * @param batch The commands.
+ */
+void NetworkMapImageAddCommands(NetworkCommandBatch *batch)
+{
+	if (_network_map_image == NULL) return;
+
+	batch->AddRef();
+	*_network_map_image->batches.Append() = batch;
+}
+
+/** The commands of the relayed server that are not passed on to the clients of the relay yet. */
+static NetworkCommandBatch *_relay_batch = NULL;
+
+/** The frame of the last sync packet of the relayed server, or 0 when there was none. */
+static uint32 _relay_sync_frame;
+/** The first part of the random state of the relayed server in #_relay_sync_frame. */
+static uint32 _relay_sync_seed_1;
+#ifdef NETWORK_SEND_DOUBLE_SEED
+/** The second part of the random state of the relayed server in #_relay_sync_frame. */
+static uint32 _relay_sync_seed_2;
+#endif
+/** The hashes of the game state of the relayed server in #_relay_sync_frame. */
+static NetworkStateHash _relay_sync_state_hash;
+
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+/** The frame of the last frame packet of the relayed server with its random state, or 0 when there was none. */
+static uint32 _relay_frame_seed_frame;
+/** The first part of the random state of the relayed server in #_relay_frame_seed_frame. */
+static uint32 _relay_frame_seed_1;
+#ifdef NETWORK_SEND_DOUBLE_SEED
+/** The second part of the random state of the relayed server in #_relay_frame_seed_frame. */
+static uint32 _relay_frame_seed_2;
+#endif
+#endif
+
 /** Writing a savegame directly to a number of packets. */
 struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	Packet *current;                    ///< The packet we're currently writing to.
-	size_t total_size;                  ///< Total size of the compressed savegame.
+	NetworkMapImage *image; ///< The image we're writing the packets to.
+	Packet *current;        ///< The packet we're currently writing to.
+	size_t total_size;      ///< Total size of the compressed savegame.
 
 	/**
 	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
+	 * @param image The image we're making the packets for.
 	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(NULL), cs(cs), current(NULL), total_size(0)
+	PacketWriter(NetworkMapImage *image) : SaveFilter(NULL), image(image), current(NULL), total_size(0)
 	{
-		this->cs->savegame_mutex = ThreadMutex::New();
+		this->image->AddRef();
 	}
 
 	/** Make sure everything is cleaned up. */
 	~PacketWriter()
 	{
-		/* Prevent double frees. */
-		if (this->cs != NULL) {
-			if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->BeginCritical();
-			this->cs->savegame = NULL;
-			if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->EndCritical();
-
-			delete this->cs->savegame_mutex;
-			this->cs->savegame_mutex = NULL;
-		}
-
+		this->image->Release();
 		delete this->current;
 	}
 
-	/** Append the current packet to the queue. */
+	/** Append the current packet to the image. */
 	void AppendQueue()
 	{
 		if (this->current == NULL) return;
 
-		Packet **p = &this->cs->savegame_packets;
-		while (*p != NULL) {
-			p = &(*p)->next;
-		}
-		*p = this->current;
-
+		*this->image->packets.Append() = this->current;
 		this->current = NULL;
 	}
 
 	/* virtual */ void Write(byte *buf, size_t size)
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all clients are gone. */
+		if (!this->image->HasClients()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
 		if (this->current == NULL) this->current = new Packet(PACKET_SERVER_MAP_DATA);
 
-		if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->BeginCritical();
+		this->image->mutex->BeginCritical();
 
 		byte *bufe = buf + size;
 		while (buf != bufe) {
 			size_t to_write = min(SEND_MTU - this->current->size, bufe - buf);
+			this->current->Reserve(this->current->size + to_write);
 			memcpy(this->current->buffer + this->current->size, buf, to_write);
 			this->current->size += (PacketSize)to_write;
 			buf += to_write;
@@ -119,17 +282,17 @@ struct PacketWriter : SaveFilter {
 			}
 		}
 
-		if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->EndCritical();
+		this->image->mutex->EndCritical();
 
 		this->total_size += size;
 	}
 
 	/* virtual */ void Finish()
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
+		/* We want to abort the saving when all clients are gone. */
+		if (!this->image->HasClients()) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->BeginCritical();
+		this->image->mutex->BeginCritical();
 
 		/* Make sure the last packet is flushed. */
 		this->AppendQueue();
@@ -138,12 +301,11 @@ struct PacketWriter : SaveFilter {
 		this->current = new Packet(PACKET_SERVER_MAP_DONE);
 		this->AppendQueue();
 
-		/* Fast-track the size to the client. */
-		Packet *p = new Packet(PACKET_SERVER_MAP_SIZE);
-		p->Send_uint32((uint32)this->total_size);
-		this->cs->NetworkTCPSocketHandler::SendPacket(p);
+		/* The clients get the size with their next packets. */
+		this->image->total_size = this->total_size;
+		this->image->finished = true;
 
-		if (this->cs->savegame_mutex != NULL) this->cs->savegame_mutex->EndCritical();
+		this->image->mutex->EndCritical();
 	}
 };
 
@@ -170,26 +332,42 @@ ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : Netwo
 ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 {
 	if (_redirect_console_to_client == this->client_id) _redirect_console_to_client = INVALID_CLIENT_ID;
-	OrderBackup::ResetUser(this->client_id);
+	/* The clients of a relay cannot build depots or give orders, so they have no order backups. */
+	if (!_network_relay) OrderBackup::ResetUser(this->client_id);
 
-	if (this->savegame_mutex != NULL) this->savegame_mutex->BeginCritical();
-	if (this->savegame != NULL) this->savegame->cs = NULL;
-	if (this->savegame_mutex != NULL) this->savegame_mutex->EndCritical();
-
-	/* Make sure the saving is completely cancelled.
-	 * Yes, we need to handle the save finish as well
-	 * as the next connection in this "loop" might
-	 * just be requesting the map and such. */
-	WaitTillSaved();
-	ProcessAsyncSaveFinish();
+	for (NetworkCommandBatch **iter = this->command_batches.Begin(); iter != this->command_batches.End(); iter++) {
+		(*iter)->Release();
+	}
 
-	while (this->savegame_packets != NULL) {
-		Packet *p = this->savegame_packets->next;
-		delete this->savegame_packets;
-		this->savegame_packets = p;
+	if (this->map_image != NULL && this->StopMapDownload()) {
+		/* Make sure the saving is completely cancelled.
+		 * Yes, we need to handle the save finish as well
+		 * as the next connection in this "loop" might
+		 * just be requesting the map and such. */
+		WaitTillSaved();
+		ProcessAsyncSaveFinish();
 	}
+}
+
+/**
+ * Stop using the savegame this client was downloading.
+ * @return True if no client uses the savegame anymore, but it is still being written.
+ */
+bool ServerNetworkGameSocketHandler::StopMapDownload()
+{
+	NetworkMapImage *image = this->map_image;
+	this->map_image = NULL;
+
+	image->mutex->BeginCritical();
+	bool unused = --image->clients == 0;
+	bool abandoned = unused && !image->finished;
+	image->mutex->EndCritical();
 
-	delete this->savegame_mutex;
+	/* An unfinished savegame without clients is not saved any further, so it cannot be shared. */
+	if (abandoned && image == _network_map_image) ReleaseNetworkMapImage();
+	image->Release();
+
+	return abandoned;
 }
 
 Packet *ServerNetworkGameSocketHandler::ReceivePacket()
@@ -205,11 +383,15 @@ Packet *ServerNetworkGameSocketHandler::ReceivePacket()
 	return p;
 }
 
-void ServerNetworkGameSocketHandler::SendPacket(Packet *packet)
+/**
+ * Close the connection after a socket error. Contrary to the connection of a
+ * client this never drops the game, as a relay is a client and a server at once.
+ * @param error Whether we quit under an error condition or not.
+ * @return The new status of the connection.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(bool error)
 {
-	if (this->savegame_mutex != NULL) this->savegame_mutex->BeginCritical();
-	this->NetworkTCPSocketHandler::SendPacket(packet);
-	if (this->savegame_mutex != NULL) this->savegame_mutex->EndCritical();
+	return this->CloseConnection(error ? NETWORK_RECV_STATUS_SERVER_ERROR : NETWORK_RECV_STATUS_CONN_LOST);
 }
 
 NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvStatus status)
@@ -246,6 +428,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::CloseConnection(NetworkRecvSta
 
 	/* We just lost one client :( */
 	if (this->status >= STATUS_AUTHORIZED) _network_game_info.clients_on--;
+	NetworkInvalidateServerInfo();
 	extern byte _network_clients_connected;
 	_network_clients_connected--;
 
@@ -317,9 +500,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendClientInfo(NetworkClientIn
 /** Send the client information about the companies. */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendCompanyInfo()
 {
-	/* Fetch the latest version of the stats */
-	NetworkCompanyStats company_stats[MAX_COMPANIES];
-	NetworkPopulateCompanyStats(company_stats);
+	const NetworkCompanyStats *company_stats = NetworkGetQueryCompanyStats();
 
 	/* Make a list of all clients per company */
 	char clients[MAX_COMPANIES][NETWORK_CLIENTS_LENGTH];
@@ -482,6 +663,7 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 
 	this->status = STATUS_AUTHORIZED;
 	_network_game_info.clients_on++;
+	NetworkInvalidateServerInfo();
 
 	p = new Packet(PACKET_SERVER_WELCOME);
 	p->Send_uint32(this->client_id);
@@ -495,6 +677,16 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 			this->SendClientInfo(new_cs->GetInfo());
 		}
 	}
+
+	if (_network_relay) {
+		/* Also send the info of the relayed server and its clients. */
+		NetworkClientInfo *ci;
+		FOR_ALL_CLIENT_INFOS(ci) {
+			if (ci->client_id < CLIENT_ID_RELAY_FIRST) this->SendClientInfo(ci);
+		}
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	/* Also send the info of the server */
 	return this->SendClientInfo(NetworkClientInfo::GetByClientID(CLIENT_ID_SERVER));
 }
@@ -521,46 +713,78 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
 /** This sends the map to the client */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 {
-	static uint sent_packets; // How many packets we did send succecfully last time
-
 	if (this->status < STATUS_AUTHORIZED) {
 		/* Illegal call, return error and ignore the packet */
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
 	if (this->status == STATUS_AUTHORIZED) {
-		this->savegame = new PacketWriter(this);
+		/* Clients requesting the map shortly after each other get the same savegame. */
+		bool save = !CanShareNetworkMapImage();
+		if (save) {
+			ReleaseNetworkMapImage();
+			_network_map_image = new NetworkMapImage();
+			NetworkSyncCommandQueue(&_network_map_image->commands);
+		}
+
+		NetworkMapImage *image = _network_map_image;
+		this->map_image = image;
+		image->AddRef();
+		image->mutex->BeginCritical();
+		image->clients++;
+		image->mutex->EndCritical();
+		this->map_packet = 0;
+		this->map_size_sent = false;
 
-		/* Now send the _frame_counter and how many packets are coming */
+		/* Now send the frame of the savegame and how many packets are coming */
 		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN);
-		p->Send_uint32(_frame_counter);
+		p->Send_uint32(image->frame);
 		this->SendPacket(p);
 
-		NetworkSyncCommandQueue(this);
+		/* Give the commands that were still to be executed in the frame of the
+		 * savegame, and the ones that were distributed since then. */
+		for (CommandPacket *cp = image->commands.Peek(); cp != NULL; cp = cp->next) {
+			this->outgoing_queue.Append(cp);
+		}
+		for (NetworkCommandBatch **iter = image->batches.Begin(); iter != image->batches.End(); iter++) {
+			(*iter)->AddRef();
+			*this->command_batches.Append() = *iter;
+		}
 		this->status = STATUS_MAP;
 		/* Mark the start of download */
 		this->last_frame = _frame_counter;
 		this->last_frame_server = _frame_counter;
 
-		sent_packets = 4; // We start with trying 4 packets
+		this->map_packets_per_send = 4; // We start with trying 4 packets
 
 		/* Make a dump of the current game */
-		if (SaveWithFilter(this->savegame, true) != SL_OK) usererror("network savedump failed");
+		if (save && SaveWithFilter(new PacketWriter(image), true) != SL_OK) usererror("network savedump failed");
 	}
 
 	if (this->status == STATUS_MAP) {
-		if (this->savegame_mutex != NULL) this->savegame_mutex->BeginCritical();
+		NetworkMapImage *image = this->map_image;
+		image->mutex->BeginCritical();
+
+		if (image->finished && !this->map_size_sent) {
+			/* Fast-track the size to the client. */
+			Packet *p = new Packet(PACKET_SERVER_MAP_SIZE);
+			p->Send_uint32((uint32)image->total_size);
+			this->SendPacket(p);
+			this->map_size_sent = true;
+		}
 
 		bool last_packet = false;
 
-		for (uint i = 0; i < sent_packets && this->savegame_packets != NULL; i++) {
-			Packet *p = this->savegame_packets;
-			last_packet = p->buffer[2] == PACKET_SERVER_MAP_DONE;
+		for (uint i = 0; i < this->map_packets_per_send && this->map_packet < image->packets.Length(); i++) {
+			const Packet *data = image->packets[this->map_packet++];
+			last_packet = data->buffer[2] == PACKET_SERVER_MAP_DONE;
 
-			/* Remove the packet from the savegame queue and put it in the real queue. */
-			this->savegame_packets = p->next;
-			p->next = NULL;
-			this->NetworkTCPSocketHandler::SendPacket(p);
+			/* Copy the packet of the savegame to the real queue. */
+			Packet *p = new Packet((PacketType)data->buffer[2]);
+			p->Reserve(data->size);
+			memcpy(p->buffer, data->buffer, data->size);
+			p->size = data->size;
+			this->SendPacket(p);
 
 			if (last_packet) {
 				/* There is no more data, so break the for */
@@ -568,36 +792,24 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 			}
 		}
 
-		if (this->savegame_mutex != NULL) this->savegame_mutex->EndCritical();
+		bool more_packets = this->map_packet < image->packets.Length();
+		image->mutex->EndCritical();
 
 		if (last_packet) {
 			/* Done reading, make sure saving is done as well */
 			WaitTillSaved();
+			this->StopMapDownload();
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
 			this->status = STATUS_DONE_MAP;
 
-			/* Find the best candidate for joining, i.e. the first joiner. */
+			/* Let everybody that is waiting start joining; they share the next savegame. */
 			NetworkClientSocket *new_cs;
-			NetworkClientSocket *best = NULL;
 			FOR_ALL_CLIENT_SOCKETS(new_cs) {
 				if (new_cs->status == STATUS_MAP_WAIT) {
-					if (best == NULL || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
-						best = new_cs;
-					}
-				}
-			}
-
-			/* Is there someone else to join? */
-			if (best != NULL) {
-				/* Let the first start joining. */
-				best->status = STATUS_AUTHORIZED;
-				best->SendMap();
-
-				/* And update the rest. */
-				FOR_ALL_CLIENT_SOCKETS(new_cs) {
-					if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
+					new_cs->status = STATUS_AUTHORIZED;
+					new_cs->SendMap();
 				}
 			}
 		}
@@ -607,8 +819,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				return NETWORK_RECV_STATUS_CONN_LOST;
 
 			case SPS_ALL_SENT:
-				/* All are sent, increase the sent_packets */
-				if (this->savegame_packets != NULL) sent_packets *= 2;
+				/* All are sent, increase the number of packets to send */
+				if (more_packets) this->map_packets_per_send *= 2;
 				break;
 
 			case SPS_PARTLY_SENT:
@@ -616,8 +828,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				break;
 
 			case SPS_NONE_SENT:
-				/* Not everything is sent, decrease the sent_packets */
-				if (sent_packets > 1) sent_packets /= 2;
+				/* Not everything is sent, decrease the number of packets to send */
+				if (this->map_packets_per_send > 1) this->map_packets_per_send /= 2;
 				break;
 		}
 	}
@@ -645,10 +857,19 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 	p->Send_uint32(_frame_counter);
 	p->Send_uint32(_frame_counter_max);
 #ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
-	p->Send_uint32(_sync_seed_1);
+	/* A relay passes on the random state the relayed server sent with the
+	 * same frame; it does not know the random state of other frames. */
+	if (!_network_relay) {
+		p->Send_uint32(_sync_seed_1);
+#ifdef NETWORK_SEND_DOUBLE_SEED
+		p->Send_uint32(_sync_seed_2);
+#endif
+	} else if (_relay_frame_seed_frame == _frame_counter) {
+		p->Send_uint32(_relay_frame_seed_1);
 #ifdef NETWORK_SEND_DOUBLE_SEED
-	p->Send_uint32(_sync_seed_2);
+		p->Send_uint32(_relay_frame_seed_2);
 #endif
+	}
 #endif
 
 	/* If token equals 0, we need to make a new token and send that. */
@@ -665,12 +886,15 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendFrame()
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendSync()
 {
 	Packet *p = new Packet(PACKET_SERVER_SYNC);
-	p->Send_uint32(_frame_counter);
-	p->Send_uint32(_sync_seed_1);
+	/* A relay passes on the last sync packet of the relayed server; the
+	 * random state of the relay is only checked, not known, in other frames. */
+	p->Send_uint32(_network_relay ? _relay_sync_frame : _frame_counter);
+	p->Send_uint32(_network_relay ? _relay_sync_seed_1 : _sync_seed_1);
 
 #ifdef NETWORK_SEND_DOUBLE_SEED
-	p->Send_uint32(_sync_seed_2);
+	p->Send_uint32(_network_relay ? _relay_sync_seed_2 : _sync_seed_2);
 #endif
+	(_network_relay ? _relay_sync_state_hash : _sync_state_hash).Send(p);
 	this->SendPacket(p);
 	return NETWORK_RECV_STATUS_OKAY;
 }
@@ -691,6 +915,37 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommand(const CommandPacke
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/**
+ * Send the commands of a frame to the client to execute.
+ * @param batch The commands to send.
+ */
+NetworkRecvStatus ServerNetworkGameSocketHandler::SendCommands(const NetworkCommandBatch *batch)
+{
+	for (uint i = 0; i < batch->packets.Length(); i++) {
+		const Packet *data = batch->packets[i];
+
+		Packet *p = new Packet(PACKET_SERVER_COMMANDS);
+		p->Send_uint32(batch->frame);
+
+		/* Tell which of the commands the client sent itself. */
+		byte own[UINT8_MAX];
+		uint own_count = 0;
+		for (const NetworkCommandBatch::OwnCommand *iter = batch->own_commands.Begin(); iter != batch->own_commands.End(); iter++) {
+			if (iter->client_id == this->client_id && iter->packet == i) own[own_count++] = iter->index;
+		}
+		p->Send_uint8(own_count);
+		for (uint j = 0; j < own_count; j++) p->Send_uint8(own[j]);
+
+		/* The number of commands and the commands are the same for all clients. */
+		p->Reserve(p->size + data->size - sizeof(PacketSize) - 1);
+		memcpy(p->buffer + p->size, data->buffer + sizeof(PacketSize) + 1, data->size - sizeof(PacketSize) - 1);
+		p->size += data->size - sizeof(PacketSize) - 1;
+
+		this->SendPacket(p);
+	}
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -870,6 +1125,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_JOIN(Packet *p)
 
 	if (this->HasClientQuit()) return NETWORK_RECV_STATUS_CONN_LOST;
 
+	/* The clients of a relay can only watch the relayed game. */
+	if (_network_relay && playas != COMPANY_SPECTATOR) return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
+
 	/* join another company does not affect these values */
 	switch (playas) {
 		case COMPANY_NEW_COMPANY: // New company
@@ -878,7 +1136,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_JOIN(Packet *p)
 			}
 			break;
 		case COMPANY_SPECTATOR: // Spectator
-			if (NetworkSpectatorCount() >= _settings_client.network.max_spectators) {
+			/* A relay shares the client infos with the clients of the relayed server. */
+			if (NetworkSpectatorCount() >= _settings_client.network.max_spectators || !NetworkClientInfo::CanAllocateItem()) {
 				return this->SendError(NETWORK_ERROR_FULL);
 			}
 			break;
@@ -975,9 +1234,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet *
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	/* Check if someone else is receiving the map */
+	/* Check if someone else is receiving the map, unless the last savegame can be shared. */
 	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status == STATUS_MAP) {
+		if (new_cs->status == STATUS_MAP && !CanShareNetworkMapImage()) {
 			/* Tell the new client to wait */
 			this->status = STATUS_MAP_WAIT;
 			return this->SendWait();
@@ -1004,6 +1263,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_MAP_OK(Packet *
 		this->status = STATUS_PRE_ACTIVE;
 		NetworkHandleCommandQueue(this);
 		this->SendFrame();
+		/* The pools are only hashed at sync checks, so hash the game state for this frame. */
+		if (!_network_relay) _sync_state_hash.Compute();
 		this->SendSync();
 
 		/* This is the frame the client receives
@@ -1047,6 +1308,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMMAND(Packet
 		return this->SendError(NETWORK_ERROR_TOO_MANY_COMMANDS);
 	}
 
+	/* The relayed server does not know the clients of a relay, so they cannot change its game. */
+	if (_network_relay) return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
+
 	CommandPacket cp;
 	const char *err = this->ReceiveCommand(p, &cp);
 
@@ -1344,6 +1608,27 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_CHAT(Packet *p)
 	int64 data = p->Recv_uint64();
 
 	NetworkClientInfo *ci = this->GetInfo();
+
+	/* The relayed server does not know the clients of a relay, so the relay
+	 * sends their chat on in its own name, unless it is for another of its clients. */
+	if (_network_relay && (desttype != DESTTYPE_CLIENT || ServerNetworkGameSocketHandler::GetByClientID((ClientID)dest) == NULL)) {
+		switch (action) {
+			case NETWORK_ACTION_CHAT:
+			case NETWORK_ACTION_CHAT_COMPANY: {
+				char relay_msg[NETWORK_CHAT_LENGTH];
+				seprintf(relay_msg, lastof(relay_msg), "%s: %s", ci->client_name, msg);
+				NetworkClientSendChat(action, desttype, dest, relay_msg, data);
+				break;
+			}
+
+			default:
+				/* Private messages would come back to all clients of the relay. */
+				NetworkServerSendChat(NETWORK_ACTION_SERVER_MESSAGE, DESTTYPE_CLIENT, ci->client_id, "cannot send private messages to clients of the relayed server", CLIENT_ID_SERVER);
+				break;
+		}
+		return NETWORK_RECV_STATUS_OKAY;
+	}
+
 	switch (action) {
 		case NETWORK_ACTION_GIVE_MONEY:
 			if (!Company::IsValidID(ci->client_playas)) break;
@@ -1367,6 +1652,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_SET_PASSWORD(Pa
 		return this->SendError(NETWORK_ERROR_NOT_EXPECTED);
 	}
 
+	/* The clients of a relay are spectators; they have no company password to set. */
+	if (_network_relay) return NETWORK_RECV_STATUS_OKAY;
+
 	char password[NETWORK_PASSWORD_LENGTH];
 	const NetworkClientInfo *ci;
 
@@ -1434,6 +1722,9 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_MOVE(Packet *p)
 
 	CompanyID company_id = (Owner)p->Recv_uint8();
 
+	/* The clients of a relay stay spectators. */
+	if (_network_relay) return company_id == COMPANY_SPECTATOR ? NETWORK_RECV_STATUS_OKAY : this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
+
 	/* Check if the company is valid, we don't allow moving to AI companies */
 	if (company_id != COMPANY_SPECTATOR && !Company::IsValidHumanID(company_id)) return NETWORK_RECV_STATUS_OKAY;
 
@@ -1546,6 +1837,39 @@ void NetworkPopulateCompanyStats(NetworkCompanyStats *stats)
 	}
 }
 
+/** Statistics of the companies for answering the queries of clients that did not join the game. */
+static NetworkCompanyStats _query_company_stats[MAX_COMPANIES];
+/** Value of #_realtime_tick when #_query_company_stats were populated. */
+static uint32 _query_company_stats_time;
+/** Whether #_query_company_stats can be used. */
+static bool _query_company_stats_valid = false;
+
+/**
+ * Get the company stats for answering the queries of clients that did not
+ * join the game, like the server list. Populating them walks all vehicles
+ * and stations, so they are kept for #NETWORK_QUERY_CACHE_TIME.
+ * @return The stats of all companies.
+ */
+const NetworkCompanyStats *NetworkGetQueryCompanyStats()
+{
+	if (!_query_company_stats_valid || _realtime_tick - _query_company_stats_time >= NETWORK_QUERY_CACHE_TIME) {
+		NetworkPopulateCompanyStats(_query_company_stats);
+		_query_company_stats_time = _realtime_tick;
+		_query_company_stats_valid = true;
+	}
+	return _query_company_stats;
+}
+
+/**
+ * Drop the cached answers to the queries of the server and the company
+ * stats, as the clients, the companies or the settings of the server changed.
+ */
+void NetworkInvalidateServerInfo()
+{
+	_query_company_stats_valid = false;
+	NetworkUDPInvalidateServerInfo();
+}
+
 /**
  * Send updated client info of a particular client.
  * @param client_id The client to send it for.
@@ -1564,6 +1888,7 @@ void NetworkUpdateClientInfo(ClientID client_id)
 	}
 
 	NetworkAdminClientUpdate(ci);
+	NetworkInvalidateServerInfo();
 }
 
 /** Check if we want to restart the map */
@@ -1732,6 +2057,7 @@ void NetworkServerSetCompanyPassword(CompanyID company_id, const char *password,
 	}
 
 	strecpy(_network_company_states[company_id].password, password, lastof(_network_company_states[company_id].password));
+	NetworkInvalidateServerInfo();
 	NetworkServerUpdateCompanyPassworded(company_id, !StrEmpty(_network_company_states[company_id].password));
 }
 
@@ -1746,6 +2072,12 @@ static void NetworkHandleCommandQueue(NetworkClientSocket *cs)
 		cs->SendCommand(cp);
 		free(cp);
 	}
+
+	for (NetworkCommandBatch **iter = cs->command_batches.Begin(); iter != cs->command_batches.End(); iter++) {
+		cs->SendCommands(*iter);
+		(*iter)->Release();
+	}
+	cs->command_batches.Clear();
 }
 
 /**
@@ -1759,9 +2091,14 @@ void NetworkServer_Tick(bool send_frame)
 	bool send_sync = false;
 #endif
 
+	/* Joining clients do not catch up from too old a savegame. */
+	if (!CanShareNetworkMapImage()) ReleaseNetworkMapImage();
+
 #ifndef ENABLE_NETWORK_SYNC_EVERY_FRAME
-	if (_frame_counter >= _last_sync_frame + _settings_client.network.sync_freq) {
+	/* A relay passes on the sync packets of the relayed server instead. */
+	if (!_network_relay && _frame_counter >= _last_sync_frame + _settings_client.network.sync_freq) {
 		_last_sync_frame = _frame_counter;
+		_sync_state_hash.Compute();
 		send_sync = true;
 	}
 #endif
@@ -1877,6 +2214,154 @@ void NetworkServer_Tick(bool send_frame)
 	NetworkUDPAdvertise();
 }
 
+/**
+ * This is called every tick if this is a relay, after running the frames
+ * the relayed server allows. The clients of the relay get the frames the
+ * relay may run to, so they never get ahead of the relayed server.
+ */
+void NetworkRelay_Tick()
+{
+	static uint32 last_frame_max = 0;
+
+	NetworkServer_Tick(_frame_counter_max != last_frame_max);
+	last_frame_max = _frame_counter_max;
+}
+
+/**
+ * Start relaying the game of the joined server to spectators, now the relay
+ * has loaded it. The relay is the server of its own clients; they download
+ * the map from the relay's copy of the game and get the frames, commands
+ * and sync packets of the relayed server through the relay, so the relayed
+ * server only serves the relay.
+ * @return True if the relay listens for clients.
+ */
+bool NetworkRelayStart()
+{
+	extern byte _network_clients_connected;
+	_network_clients_connected = 0;
+	_network_game_info.clients_on = 0;
+	_network_client_id = CLIENT_ID_RELAY_FIRST;
+	_relay_sync_frame = 0;
+	_relay_sync_state_hash.valid = false;
+
+	/* Let a separate thread read and write the sockets of the clients. */
+	if (_settings_client.network.threaded_io) StartNetworkIOThread();
+	if (!ServerNetworkGameSocketHandler::Listen(_settings_client.network.server_port)) return false;
+
+	DEBUG(net, 0, "Relaying the game to spectators on port %d", _settings_client.network.server_port);
+	return true;
+}
+
+/** Disconnect the clients of the relay and stop listening for them, as the relay lost the relayed server. */
+void NetworkRelayClose()
+{
+	NetworkClientSocket *cs;
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		cs->SendShutdown();
+		cs->CloseConnection(NETWORK_RECV_STATUS_CONN_LOST);
+	}
+	ServerNetworkGameSocketHandler::CloseListeners();
+
+	if (_relay_batch != NULL) {
+		_relay_batch->Release();
+		_relay_batch = NULL;
+	}
+	ReleaseNetworkMapImage();
+}
+
+/**
+ * Pass a command of the relayed server on to the clients of the relay. The
+ * commands of a frame are collected in one batch that the clients share,
+ * until #NetworkRelayDistributeCommands hands it to them.
+ * @param cp The command received from the relayed server.
+ */
+void NetworkRelayCommand(const CommandPacket *cp)
+{
+	if (_relay_batch != NULL && _relay_batch->frame != cp->frame) NetworkRelayDistributeCommands();
+	if (_relay_batch == NULL) _relay_batch = new NetworkCommandBatch(cp->frame);
+
+	/* Nobody but the relay sent the command, so no client gets its callback. */
+	_relay_batch->Append(cp, INVALID_CLIENT_ID);
+}
+
+/** Hand the collected commands of the relayed server to the clients of the relay. */
+void NetworkRelayDistributeCommands()
+{
+	if (_relay_batch == NULL) return;
+
+	NetworkMapImageAddCommands(_relay_batch);
+
+	/* The clients that requested the map already have the commands that came before. */
+	NetworkClientSocket *cs;
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		if (cs->status >= NetworkClientSocket::STATUS_MAP) {
+			_relay_batch->AddRef();
+			*cs->command_batches.Append() = _relay_batch;
+		}
+	}
+	_relay_batch->Release();
+	_relay_batch = NULL;
+}
+
+/**
+ * Pass the sync packet of the relayed server on to the clients of the relay.
+ * Its contents are in #_sync_frame and #_sync_seed_1, which the relay clears
+ * once it checked its own random state.
+ */
+void NetworkRelaySync()
+{
+	_relay_sync_frame = _sync_frame;
+	_relay_sync_seed_1 = _sync_seed_1;
+#ifdef NETWORK_SEND_DOUBLE_SEED
+	_relay_sync_seed_2 = _sync_seed_2;
+#endif
+	_relay_sync_state_hash = _sync_state_hash;
+
+	NetworkClientSocket *cs;
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		if (cs->status >= NetworkClientSocket::STATUS_PRE_ACTIVE) cs->SendSync();
+	}
+}
+
+#ifdef ENABLE_NETWORK_SYNC_EVERY_FRAME
+/**
+ * Remember the random state the relayed server sent with a frame, so the
+ * clients of the relay get it with the same frame. It is in #_sync_frame
+ * and #_sync_seed_1, which the relay clears once it checked its own random state.
+ */
+void NetworkRelayFrameSeed()
+{
+	_relay_frame_seed_frame = _sync_frame;
+	_relay_frame_seed_1 = _sync_seed_1;
+#ifdef NETWORK_SEND_DOUBLE_SEED
+	_relay_frame_seed_2 = _sync_seed_2;
+#endif
+}
+#endif
+
+/**
+ * Pass a packet of the relayed server about its clients, chat or shutdown on
+ * to the clients of the relay as it is.
+ * @param p The packet received from the relayed server.
+ */
+void NetworkRelayPacket(const Packet *p)
+{
+	/* Chat and company updates are only handled by clients that loaded the map. */
+	PacketType type = (PacketType)p->buffer[sizeof(PacketSize)];
+	NetworkClientSocket::ClientStatus status = (type == PACKET_SERVER_CHAT || type == PACKET_SERVER_COMPANY_UPDATE) ? NetworkClientSocket::STATUS_PRE_ACTIVE : NetworkClientSocket::STATUS_AUTHORIZED;
+
+	NetworkClientSocket *cs;
+	FOR_ALL_CLIENT_SOCKETS(cs) {
+		if (cs->status < status) continue;
+
+		Packet *copy = new Packet(type);
+		copy->Reserve(p->size);
+		memcpy(copy->buffer, p->buffer, p->size);
+		copy->size = p->size;
+		cs->SendPacket(copy);
+	}
+}
+
 /** Yearly "callback". Called whenever the year changes. */
 void NetworkServerYearlyLoop()
 {
@@ -19,6 +19,43 @@
 #include "../thread/thread.h"
 
 class ServerNetworkGameSocketHandler;
+
+/**
+ * The commands distributed in one frame. They are serialised only once, and
+ * the clients share them; each client gets them in one packet per frame,
+ * unless they do not fit in one packet.
+ */
+struct NetworkCommandBatch {
+	/** A command sent by one of the clients; only that client gets its callback. */
+	struct OwnCommand {
+		ClientID client_id; ///< The client that sent the command.
+		uint packet;        ///< Index of the packet with the command.
+		uint8 index;        ///< Index of the command in the packet.
+	};
+
+	uint32 frame;                           ///< The frame the commands are executed in.
+	SmallVector<Packet *, 1> packets;       ///< The serialised commands, with their number in front.
+	SmallVector<OwnCommand, 4> own_commands; ///< The commands that were sent by a client.
+	uint refs;                              ///< Number of clients that did not send the commands yet, plus one while distributing.
+
+	NetworkCommandBatch(uint32 frame);
+	~NetworkCommandBatch();
+
+	void Append(const CommandPacket *cp, ClientID owner);
+
+	/** Add a client that is going to send the commands. */
+	void AddRef()
+	{
+		this->refs++;
+	}
+
+	/** Remove a client that sent the commands, and delete the batch when it was the last one. */
+	void Release()
+	{
+		if (--this->refs == 0) delete this;
+	}
+};
+
 /** Make the code look slightliy nicer/simpler. */
 typedef ServerNetworkGameSocketHandler NetworkClientSocket;
 /** Pool with all client sockets. */
@@ -73,22 +110,25 @@ public:
 	uint32 last_token_frame;     ///< The last frame we received the right token
 	ClientStatus status;         ///< Status of this client
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
+	SmallVector<NetworkCommandBatch *, 4> command_batches; ///< The batches of commands awaiting delivery after #outgoing_queue
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
 
-	Packet *savegame_packets;      ///< Packet queue of the savegame; send these "slowly" to the client.
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
-	ThreadMutex *savegame_mutex;   ///< Mutex for making threaded saving safe.
-	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
+	struct NetworkMapImage *map_image; ///< Savegame the client is downloading; shared with the clients joining shortly after each other.
+	uint map_packet;                   ///< Index of the next packet of the savegame to send.
+	uint map_packets_per_send;         ///< Number of packets of the savegame to send at once; doubled when they could all be sent.
+	bool map_size_sent;                ///< Whether the size of the savegame is sent.
+	NetworkAddress client_address;     ///< IP-address of the client (so he can be banned)
 
 	ServerNetworkGameSocketHandler(SOCKET s);
 	~ServerNetworkGameSocketHandler();
 
 	virtual Packet *ReceivePacket();
-	virtual void SendPacket(Packet *packet);
+	NetworkRecvStatus CloseConnection(bool error = true);
 	NetworkRecvStatus CloseConnection(NetworkRecvStatus status);
 	void GetClientName(char *client_name, size_t size) const;
 
 	NetworkRecvStatus SendMap();
+	bool StopMapDownload();
 	NetworkRecvStatus SendErrorQuit(ClientID client_id, NetworkErrorCode errorno);
 	NetworkRecvStatus SendQuit(ClientID client_id);
 	NetworkRecvStatus SendShutdown();
@@ -103,11 +143,12 @@ public:
 	NetworkRecvStatus SendFrame();
 	NetworkRecvStatus SendSync();
 	NetworkRecvStatus SendCommand(const CommandPacket *cp);
+	NetworkRecvStatus SendCommands(const NetworkCommandBatch *batch);
 	NetworkRecvStatus SendCompanyUpdate();
 	NetworkRecvStatus SendConfigUpdate();
 
 	static void Send();
-	static void AcceptConnection(SOCKET s, const NetworkAddress &address);
+	static ServerNetworkGameSocketHandler *AcceptConnection(SOCKET s, const NetworkAddress &address);
 	static bool AllowConnection();
 
 	/**
@@ -125,7 +166,9 @@ public:
 };
 
 void NetworkServer_Tick(bool send_frame);
+void NetworkRelay_Tick();
 void NetworkServerSetCompanyPassword(CompanyID company_id, const char *password, bool already_hashed = true);
+void NetworkMapImageAddCommands(NetworkCommandBatch *batch);
 
 /**
  * Iterate over all the sockets from a given starting point.
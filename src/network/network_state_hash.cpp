@@ -0,0 +1,172 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_state_hash.cpp Hashes of the game state to find where a client desynced. */
+
+#ifdef ENABLE_NETWORK
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../map_func.h"
+#include "../company_base.h"
+#include "../vehicle_base.h"
+#include "../station_base.h"
+#include "../town.h"
+#include "../industry.h"
+#include "network_state_hash.h"
+
+/** Names of the parts of the game state that are not part of the map, for reporting a desync. */
+static const char * const _state_hash_part_names[] = {
+	"companies",
+	"vehicles",
+	"stations",
+	"towns",
+	"industries",
+};
+assert_compile(lengthof(_state_hash_part_names) == SHP_END - SHP_MAP_END);
+
+/** Initial value of a hash; the offset basis of FNV-1a. */
+static const uint32 STATE_HASH_INIT = 2166136261U;
+
+/**
+ * Add a value to a hash. This is FNV-1a, but on 32 bits at once: every step
+ * is a bijection, so any single difference in the values changes the hash.
+ * @param hash  The hash so far.
+ * @param value The value to add.
+ * @return The new hash.
+ */
+static inline uint32 StateHashAdd(uint32 hash, uint32 value)
+{
+	return (hash ^ value) * 16777619U;
+}
+
+/**
+ * Add a value of money to a hash.
+ * @param hash  The hash so far.
+ * @param value The money to add.
+ * @return The new hash.
+ */
+static inline uint32 StateHashAdd(uint32 hash, Money value)
+{
+	int64 v = value;
+	return StateHashAdd(StateHashAdd(hash, GB(v, 0, 32)), GB(v, 32, 32));
+}
+
+/**
+ * Hash the game state at this moment.
+ */
+void NetworkStateHash::Compute()
+{
+	this->valid = true;
+
+	const uint32 *map_hash = GetMapHash();
+	for (uint i = 0; i < MAP_HASH_PARTS; i++) this->hash[SHP_MAP_BEGIN + i] = map_hash[i];
+
+	uint32 hash = STATE_HASH_INIT;
+	const Company *c;
+	FOR_ALL_COMPANIES(c) {
+		hash = StateHashAdd(hash, c->index);
+		hash = StateHashAdd(hash, c->money);
+		hash = StateHashAdd(hash, c->current_loan);
+	}
+	this->hash[SHP_COMPANIES] = hash;
+
+	hash = STATE_HASH_INIT;
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		hash = StateHashAdd(hash, v->index);
+		hash = StateHashAdd(hash, v->tile);
+		hash = StateHashAdd(hash, v->x_pos);
+		hash = StateHashAdd(hash, v->y_pos);
+		hash = StateHashAdd(hash, v->z_pos | v->direction << 8 | v->vehstatus << 16 | (uint32)v->progress << 24);
+		hash = StateHashAdd(hash, v->cur_speed);
+	}
+	this->hash[SHP_VEHICLES] = hash;
+
+	hash = STATE_HASH_INIT;
+	const Station *st;
+	FOR_ALL_STATIONS(st) {
+		hash = StateHashAdd(hash, st->index);
+		hash = StateHashAdd(hash, st->facilities);
+		for (CargoID cargo = 0; cargo < NUM_CARGO; cargo++) {
+			hash = StateHashAdd(hash, st->goods[cargo].rating | st->goods[cargo].cargo.Count() << 8);
+		}
+	}
+	this->hash[SHP_STATIONS] = hash;
+
+	hash = STATE_HASH_INIT;
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		hash = StateHashAdd(hash, t->index);
+		hash = StateHashAdd(hash, t->num_houses);
+		hash = StateHashAdd(hash, t->population);
+	}
+	this->hash[SHP_TOWNS] = hash;
+
+	hash = STATE_HASH_INIT;
+	const Industry *ind;
+	FOR_ALL_INDUSTRIES(ind) {
+		hash = StateHashAdd(hash, ind->index);
+		hash = StateHashAdd(hash, ind->produced_cargo_waiting[0] | (uint32)ind->produced_cargo_waiting[1] << 16);
+		hash = StateHashAdd(hash, ind->production_rate[0] | ind->production_rate[1] << 8 | ind->prod_level << 16);
+	}
+	this->hash[SHP_INDUSTRIES] = hash;
+}
+
+/**
+ * Compare the hashes with those of our own game state, and report the parts
+ * in which it diverged.
+ * @return True when all hashes match, or no hashes are known.
+ */
+bool NetworkStateHash::Verify() const
+{
+	if (!this->valid) return true;
+
+	NetworkStateHash own;
+	own.Compute();
+
+	bool in_sync = true;
+	for (uint i = 0; i < SHP_END; i++) {
+		if (own.hash[i] == this->hash[i]) continue;
+		in_sync = false;
+
+		if (i < SHP_MAP_END) {
+			uint first = (i - SHP_MAP_BEGIN) * MapSizeY() / MAP_HASH_PARTS;
+			uint last = first + MapSizeY() / MAP_HASH_PARTS - 1;
+			DEBUG(desync, 1, "state_err: map rows %u to %u", first, last);
+			DEBUG(net, 0, "Game state of the map differs in rows %u to %u", first, last);
+		} else {
+			DEBUG(desync, 1, "state_err: %s", _state_hash_part_names[i - SHP_MAP_END]);
+			DEBUG(net, 0, "Game state of the %s differs", _state_hash_part_names[i - SHP_MAP_END]);
+		}
+	}
+	return in_sync;
+}
+
+/**
+ * Write the hashes to a packet.
+ * @param p The packet to write to.
+ */
+void NetworkStateHash::Send(Packet *p) const
+{
+	p->Send_bool(this->valid);
+	for (uint i = 0; i < SHP_END; i++) p->Send_uint32(this->hash[i]);
+}
+
+/**
+ * Read the hashes from a packet.
+ * @param p The packet to read from.
+ */
+void NetworkStateHash::Recv(Packet *p)
+{
+	this->valid = p->Recv_bool();
+	for (uint i = 0; i < SHP_END; i++) this->hash[i] = p->Recv_uint32();
+}
+
+#endif /* ENABLE_NETWORK */
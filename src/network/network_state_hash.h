@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file network_state_hash.h Hashes of the game state to find where a client desynced. */
+
+#ifndef NETWORK_STATE_HASH_H
+#define NETWORK_STATE_HASH_H
+
+#ifdef ENABLE_NETWORK
+
+#include "core/packet.h"
+
+#include "../map_func.h"
+
+/** The subsystems of the game state that are hashed separately. */
+enum StateHashPart {
+	SHP_MAP_BEGIN,                                  ///< The first of the parts of the map, which are consecutive ranges of rows.
+	SHP_MAP_END = SHP_MAP_BEGIN + MAP_HASH_PARTS,
+	SHP_COMPANIES = SHP_MAP_END,                    ///< Money and loans of the companies.
+	SHP_VEHICLES,                                   ///< Positions and speeds of the vehicles.
+	SHP_STATIONS,                                   ///< Ratings and waiting cargo of the stations.
+	SHP_TOWNS,                                      ///< Houses and population of the towns.
+	SHP_INDUSTRIES,                                 ///< Production of the industries.
+	SHP_END,                                        ///< End marker.
+};
+
+/**
+ * Hashes of parts of the game state at a sync check. The server sends them
+ * along with its random state, so a client that desyncs can tell which part
+ * of the game diverged. The hashes of the map are kept up to date on every
+ * change of a tile, see GetMapHash(), so computing them costs next to nothing.
+ */
+struct NetworkStateHash {
+	bool valid;            ///< Whether the hashes are known.
+	uint32 hash[SHP_END];  ///< The hash of each part of the game state.
+
+	void Compute();
+	bool Verify() const;
+
+	void Send(Packet *p) const;
+	void Recv(Packet *p);
+};
+
+#endif /* ENABLE_NETWORK */
+
+#endif /* NETWORK_STATE_HASH_H */
@@ -160,6 +160,43 @@ public:
 	virtual ~ServerNetworkUDPSocketHandler() {}
 };
 
+/** A cached answer to a query of the server, which is sent as is to all clients asking for it. */
+struct CachedServerInfo {
+	Packet *packet; ///< The answer, or NULL when it has to be built.
+	uint32 built;   ///< Value of #_realtime_tick when the answer was built.
+
+	/**
+	 * Get the answer, if it is still recent enough to be sent.
+	 * @return The answer or NULL when it has to be built again.
+	 */
+	Packet *Get() const
+	{
+		if (this->packet == NULL || _realtime_tick - this->built >= NETWORK_QUERY_CACHE_TIME) return NULL;
+		return this->packet;
+	}
+
+	/**
+	 * Replace the answer.
+	 * @param p The new answer.
+	 */
+	void Set(Packet *p)
+	{
+		delete this->packet;
+		this->packet = p;
+		this->built = _realtime_tick;
+	}
+};
+
+static CachedServerInfo _server_info_cache;        ///< Answer to #PACKET_UDP_CLIENT_FIND_SERVER.
+static CachedServerInfo _server_detail_info_cache; ///< Answer to #PACKET_UDP_CLIENT_DETAIL_INFO.
+
+/** Drop the cached answers to the queries of the server, so they are built again for the next query. */
+void NetworkUDPInvalidateServerInfo()
+{
+	_server_info_cache.Set(NULL);
+	_server_detail_info_cache.Set(NULL);
+}
+
 void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, NetworkAddress *client_addr)
 {
 	/* Just a fail-safe.. should never happen */
@@ -167,6 +204,13 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, Networ
 		return;
 	}
 
+	Packet *packet = _server_info_cache.Get();
+	if (packet != NULL) {
+		this->SendPacket(packet, client_addr);
+		DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
+		return;
+	}
+
 	NetworkGameInfo ngi;
 
 	/* Update some game_info */
@@ -191,11 +235,12 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_FIND_SERVER(Packet *p, Networ
 	strecpy(ngi.server_name, _settings_client.network.server_name, lastof(ngi.server_name));
 	strecpy(ngi.server_revision, _openttd_revision, lastof(ngi.server_revision));
 
-	Packet packet(PACKET_UDP_SERVER_RESPONSE);
-	this->SendNetworkGameInfo(&packet, &ngi);
+	packet = new Packet(PACKET_UDP_SERVER_RESPONSE);
+	this->SendNetworkGameInfo(packet, &ngi);
+	_server_info_cache.Set(packet);
 
 	/* Let the client know that we are here */
-	this->SendPacket(&packet, client_addr);
+	this->SendPacket(packet, client_addr);
 
 	DEBUG(net, 2, "[udp] queried from %s", client_addr->GetHostname());
 }
@@ -205,29 +250,33 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_DETAIL_INFO(Packet *p, Networ
 	/* Just a fail-safe.. should never happen */
 	if (!_network_udp_server) return;
 
-	Packet packet(PACKET_UDP_SERVER_DETAIL_INFO);
+	Packet *packet = _server_detail_info_cache.Get();
+	if (packet != NULL) {
+		this->SendPacket(packet, client_addr);
+		return;
+	}
+
+	packet = new Packet(PACKET_UDP_SERVER_DETAIL_INFO);
 
 	/* Send the amount of active companies */
-	packet.Send_uint8 (NETWORK_COMPANY_INFO_VERSION);
-	packet.Send_uint8 ((uint8)Company::GetNumItems());
+	packet->Send_uint8 (NETWORK_COMPANY_INFO_VERSION);
+	packet->Send_uint8 ((uint8)Company::GetNumItems());
 
-	/* Fetch the latest version of the stats */
-	NetworkCompanyStats company_stats[MAX_COMPANIES];
-	NetworkPopulateCompanyStats(company_stats);
+	const NetworkCompanyStats *company_stats = NetworkGetQueryCompanyStats();
 
 	/* The minimum company information "blob" size. */
 	static const uint MIN_CI_SIZE = 54;
 	uint max_cname_length = NETWORK_COMPANY_NAME_LENGTH;
 
-	if (Company::GetNumItems() * (MIN_CI_SIZE + NETWORK_COMPANY_NAME_LENGTH) >= (uint)SEND_MTU - packet.size) {
+	if (Company::GetNumItems() * (MIN_CI_SIZE + NETWORK_COMPANY_NAME_LENGTH) >= (uint)SEND_MTU - packet->size) {
 		/* Assume we can at least put the company information in the packets. */
-		assert(Company::GetNumItems() * MIN_CI_SIZE < (uint)SEND_MTU - packet.size);
+		assert(Company::GetNumItems() * MIN_CI_SIZE < (uint)SEND_MTU - packet->size);
 
 		/* At this moment the company names might not fit in the
 		 * packet. Check whether that is really the case. */
 
 		for (;;) {
-			int free = SEND_MTU - packet.size;
+			int free = SEND_MTU - packet->size;
 			Company *company;
 			FOR_ALL_COMPANIES(company) {
 				char company_name[NETWORK_COMPANY_NAME_LENGTH];
@@ -248,10 +297,11 @@ void ServerNetworkUDPSocketHandler::Receive_CLIENT_DETAIL_INFO(Packet *p, Networ
 	/* Go through all the companies */
 	FOR_ALL_COMPANIES(company) {
 		/* Send the information */
-		this->SendCompanyInformation(&packet, company, &company_stats[company->index], max_cname_length);
+		this->SendCompanyInformation(packet, company, &company_stats[company->index], max_cname_length);
 	}
+	_server_detail_info_cache.Set(packet);
 
-	this->SendPacket(&packet, client_addr);
+	this->SendPacket(packet, client_addr);
 }
 
 /**
@@ -678,6 +728,7 @@ void NetworkUDPClose()
 	_udp_client_socket = NULL;
 	_udp_server_socket = NULL;
 	_udp_master_socket = NULL;
+	NetworkUDPInvalidateServerInfo();
 	_network_udp_mutex->EndCritical();
 
 	_network_udp_server = false;
@@ -24,6 +24,7 @@ void NetworkUDPAdvertise();
 void NetworkUDPRemoveAdvertise(bool blocking);
 void NetworkUDPClose();
 void NetworkBackgroundUDPLoop();
+void NetworkUDPInvalidateServerInfo();
 
 #endif /* ENABLE_NETWORK */
 
@@ -59,6 +59,7 @@
 #include "misc/getoptdata.h"
 #include "game/game.hpp"
 #include "game/game_config.hpp"
+#include "tick_stats.h"
 
 
 
@@ -164,6 +165,7 @@ static void ShowHelp()
 		"  -p password         = Password to join server\n"
 		"  -P password         = Password to join company\n"
 		"  -D [ip][:port]      = Start dedicated server\n"
+		"                        (with -n: relay that game to spectators)\n"
 		"  -l ip[:port]        = Redirect DEBUG()\n"
 #if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(WIN32)
 		"  -f                  = Fork into the background (dedicated only)\n"
@@ -479,6 +481,9 @@ struct AfterNewGRFScan : NewGRFScanCallback {
 			}
 			if (port != NULL) rport = atoi(port);
 
+			/* A relay only watches the game it relays. */
+			if (_network_relay) join_as = COMPANY_SPECTATOR;
+
 			LoadIntroGame();
 			_switch_mode = SM_NONE;
 			NetworkClientConnectGame(NetworkAddress(network_conn, rport), join_as, join_server_password, join_company_password);
@@ -692,6 +697,8 @@ int ttd_main(int argc, char *argv[])
 
 #if defined(ENABLE_NETWORK)
 	if (dedicated) DEBUG(net, 0, "Starting dedicated version %s", _openttd_revision);
+	/* A dedicated server that joins another server relays that server's game to its own clients. */
+	_network_relay = dedicated && scanner->network_conn != NULL;
 	if (_dedicated_forks && !dedicated) _dedicated_forks = false;
 
 #if defined(UNIX) && !defined(__MORPHOS__)
@@ -742,7 +749,7 @@ int ttd_main(int argc, char *argv[])
 	if (blitter == NULL && _ini_blitter != NULL) blitter = strdup(_ini_blitter);
 	_blitter_autodetected = StrEmpty(blitter);
 	/* If we have a 32 bpp base set, try to select the 32 bpp blitter first, but only if we autoprobe the blitter. */
-	if (!_blitter_autodetected || BaseGraphics::GetUsedSet() == NULL || BaseGraphics::GetUsedSet()->blitter == BLT_8BPP || BlitterFactoryBase::SelectBlitter("32bpp-anim") == NULL) {
+	if (!_blitter_autodetected || BaseGraphics::GetUsedSet() == NULL || BaseGraphics::GetUsedSet()->blitter == BLT_8BPP || BlitterFactoryBase::Select32bppAnimBlitter() == NULL) {
 		if (BlitterFactoryBase::SelectBlitter(blitter) == NULL) {
 			StrEmpty(blitter) ?
 				usererror("Failed to autoprobe blitter") :
@@ -842,6 +849,7 @@ int ttd_main(int argc, char *argv[])
 	_video_driver->MainLoop();
 
 	WaitTillSaved();
+	WaitTillSnapshotSaved();
 
 	/* only save config if we have to */
 	if (save_config) {
@@ -1097,6 +1105,16 @@ void SwitchToMode(SwitchMode new_mode)
 		}
 
 		case SM_MENU: // Switch to game intro menu
+#ifdef ENABLE_NETWORK
+			if (_network_relay) {
+				/* A relay has nothing to do without the relayed server, unless that restarts. */
+				NetworkRelayClose();
+				if (_network_reconnect == 0) {
+					_exit_game = true;
+					break;
+				}
+			}
+#endif /* ENABLE_NETWORK */
 			LoadIntroGame();
 			if (BaseSounds::ini_set == NULL && BaseSounds::GetUsedSet()->fallback) {
 				ShowErrorMessage(STR_WARNING_FALLBACK_SOUNDSET, INVALID_STRING_ID, WL_CRITICAL);
@@ -1261,6 +1279,10 @@ static void CheckCaches()
 			assert(memcmp(&st->goods[c].cargo, buff, sizeof(StationCargoList)) == 0);
 		}
 	}
+
+	/* Check the occupancy of the signal blocks. */
+	extern void CheckSignalBlockOccupancy();
+	CheckSignalBlockOccupancy();
 }
 
 /**
@@ -1304,19 +1326,26 @@ void StateGameLoop()
 		 *  for multiplayer compatibility */
 		Backup<CompanyByte> cur_company(_current_company, OWNER_NONE, FILE_LINE);
 
+		TickTimingLap(TSP_OTHER);
 		AnimateAnimatedTiles();
 		IncreaseDate();
+		TickTimingLap(TSP_DATE);
 		RunTileLoop();
+		TickTimingLap(TSP_TILE_LOOP);
 		CallVehicleTicks();
+		TickTimingLap(TSP_VEHICLES);
 		CallLandscapeTick();
 		ClearStorageChanges(true);
+		TickTimingLap(TSP_LANDSCAPE);
 
 		AI::GameLoop();
 		Game::GameLoop();
+		TickTimingLap(TSP_SCRIPTS);
 		UpdateLandscapingLimits();
 
 		CallWindowTickEvent();
 		NewsLoop();
+		TickTimingLap(TSP_OTHER);
 		cur_company.Restore();
 	}
 
@@ -1349,7 +1378,7 @@ static void DoAutosave()
 	}
 
 	DEBUG(sl, 2, "Autosaving to '%s'", buf);
-	if (SaveOrLoad(buf, SL_SAVE, AUTOSAVE_DIR) != SL_OK) {
+	if (SaveOrLoad(buf, SL_SAVE, AUTOSAVE_DIR, true, true) != SL_OK) {
 		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, INVALID_STRING_ID, WL_ERROR);
 	}
 }
@@ -1387,6 +1416,9 @@ void GameLoop()
 	_caret_timer += 3;
 	CursorTick();
 
+	/* Only time the ticks in which the game state advances. */
+	if (_game_mode == GM_NORMAL && _pause_mode == PM_UNPAUSED && !HasModalProgress()) StartTickTiming();
+
 #ifdef ENABLE_NETWORK
 	/* Check for UDP stuff */
 	if (_network_available) NetworkBackgroundLoop();
@@ -1414,6 +1446,8 @@ void GameLoop()
 	StateGameLoop();
 #endif /* ENABLE_NETWORK */
 
+	StopTickTiming(_networking ? TSP_NETWORK : TSP_OTHER);
+
 	if (!_pause_mode && HasBit(_display_opt, DO_FULL_ANIMATION)) DoPaletteAnimations();
 
 	if (!_pause_mode || _game_mode == GM_EDITOR || _settings_game.construction.command_pause_level > CMDPL_NO_CONSTRUCTION) MoveAllTextEffects();
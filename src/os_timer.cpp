@@ -74,3 +74,36 @@ uint64 ottd_rdtsc()
 # endif
 uint64 ottd_rdtsc() {return 0;}
 #endif
+
+/* A real time clock, unlike rdtsc it does not depend on the speed of the CPU. */
+#if defined(WIN32)
+#include <windows.h>
+uint64 ottd_microseconds()
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000 + (uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+#elif defined(UNIX) || defined(__OS2__)
+#include <time.h>
+#include <sys/time.h>
+uint64 ottd_microseconds()
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+#else
+#include <time.h>
+uint64 ottd_microseconds()
+{
+	return (uint64)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+#endif
@@ -0,0 +1,221 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pf_stats.cpp Statistics of the path finder searches and recording/replaying of path finder requests. */
+
+#include "../stdafx.h"
+#include "../train.h"
+#include "../roadveh.h"
+#include "../ship.h"
+#include "../settings_type.h"
+#include "../fileio_func.h"
+#include "../string_func.h"
+#include "../core/bitmath_func.hpp"
+#include "pf_performance_timer.hpp"
+#include "pf_stats.h"
+#include "npf/npf_func.h"
+#include "opf/opf_ship.h"
+#include "yapf/yapf.h"
+
+PathfinderStats _pathfinder_stats[VEH_COMPANY_END]; ///< Statistics of the path finder searches per vehicle type.
+FILE *_pathfinder_record_file = NULL;                 ///< File the path finder requests are recorded to, if any.
+
+/**
+ * Get the time below which the given percentage of the searches finished.
+ * As the times are kept in a histogram, this is the upper bound of the
+ * bucket the percentile falls in.
+ * @param percent The percentile, 0..100.
+ * @return Time in microseconds.
+ */
+uint32 PathfinderStats::GetTimePercentile(uint percent) const
+{
+	if (this->calls == 0) return 0;
+
+	uint64 wanted = ((uint64)this->calls * percent + 99) / 100;
+	uint64 seen = 0;
+	for (uint i = 0; i < PF_STATS_TIME_BUCKETS; i++) {
+		seen += this->time_histogram[i];
+		if (seen >= wanted) return min(1U << i, this->max_us);
+	}
+	return this->max_us;
+}
+
+/**
+ * Add a path finder search to the statistics.
+ * @param type       The type of the vehicle the search was for.
+ * @param nodes      Number of nodes the search expanded.
+ * @param cache_hits Number of node costs taken from the segment cost cache.
+ * @param cost_calcs Number of node costs that had to be calculated.
+ * @param found      Whether a path to the destination was found.
+ * @param aborted    Whether the search stopped at the maximum number of nodes.
+ * @param time_us    Duration of the search in microseconds.
+ */
+void RecordPathfinderSearch(VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, bool found, bool aborted, uint time_us)
+{
+	assert(type < VEH_COMPANY_END);
+	PathfinderStats *stats = &_pathfinder_stats[type];
+
+	stats->calls++;
+	if (!found) stats->not_found++;
+	if (aborted) stats->aborts++;
+	stats->nodes += nodes;
+	stats->cache_hits += cache_hits;
+	stats->cost_calcs += cost_calcs;
+	stats->total_us += time_us;
+	stats->max_us = max(stats->max_us, (uint32)time_us);
+	stats->time_histogram[time_us == 0 ? 0 : min<uint>(FindLastBit(time_us) + 1, PF_STATS_TIME_BUCKETS - 1)]++;
+}
+
+/** Clear the statistics of all vehicle types. */
+void ResetPathfinderStats()
+{
+	memset(_pathfinder_stats, 0, sizeof(_pathfinder_stats));
+}
+
+/**
+ * Check whether a name of a recording is a plain file name. The console
+ * commands can be used over rcon, so they must not reach outside the
+ * savegame directory.
+ * @param filename The name to check.
+ * @return True if the name does not contain a directory.
+ */
+static bool IsValidRecordingName(const char *filename)
+{
+	return !StrEmpty(filename) && strchr(filename, PATHSEPCHAR) == NULL && strchr(filename, '/') == NULL;
+}
+
+/**
+ * Start recording the path finder requests to a file in the savegame directory.
+ * A running recording is stopped first.
+ * @param filename The name of the file to write to, without directory.
+ * @return True if the file could be opened.
+ */
+bool StartPathfinderRecording(const char *filename)
+{
+	StopPathfinderRecording();
+
+	if (!IsValidRecordingName(filename)) return false;
+	_pathfinder_record_file = FioFOpenFile(filename, "w", SAVE_DIR);
+	if (_pathfinder_record_file == NULL) return false;
+
+	fprintf(_pathfinder_record_file, "# type vehicle tile enterdir tracks dest_tile result\n");
+	return true;
+}
+
+/** Stop recording the path finder requests, if a recording is running. */
+void StopPathfinderRecording()
+{
+	if (_pathfinder_record_file == NULL) return;
+
+	fclose(_pathfinder_record_file);
+	_pathfinder_record_file = NULL;
+}
+
+/**
+ * Write a path finder request to the recording.
+ * @param v        The vehicle the path is searched for.
+ * @param tile     The tile the vehicle is about to enter.
+ * @param enterdir The direction the vehicle enters the tile from.
+ * @param tracks   The tracks or trackdirs the vehicle can choose from.
+ * @param result   The track or trackdir the path finder chose.
+ * @see RecordPathfinderRequest
+ */
+void WritePathfinderRequest(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint tracks, uint result)
+{
+	fprintf(_pathfinder_record_file, "%u %u %u %u %u %u %u\n", (uint)v->type, v->index, tile, enterdir, tracks, v->dest_tile, result);
+}
+
+/**
+ * Ask the configured path finder of the vehicle type for a path, without reserving it.
+ * @param v        The vehicle to search for.
+ * @param tile     The tile the vehicle is about to enter.
+ * @param enterdir The direction the vehicle enters the tile from.
+ * @param tracks   The tracks or trackdirs the vehicle can choose from.
+ * @return The chosen track or trackdir.
+ */
+static uint ReplayPathfinderRequest(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint tracks)
+{
+	bool path_found = true;
+	switch (v->type) {
+		case VEH_TRAIN:
+			switch (_settings_game.pf.pathfinder_for_trains) {
+				case VPF_NPF:  return NPFTrainChooseTrack(Train::From(v), tile, enterdir, (TrackBits)tracks, path_found, false, NULL);
+				case VPF_YAPF: return YapfTrainChooseTrack(Train::From(v), tile, enterdir, (TrackBits)tracks, path_found, false, NULL);
+				default: NOT_REACHED();
+			}
+
+		case VEH_ROAD:
+			switch (_settings_game.pf.pathfinder_for_roadvehs) {
+				case VPF_NPF:  return NPFRoadVehicleChooseTrack(RoadVehicle::From(v), tile, enterdir, (TrackdirBits)tracks, path_found);
+				case VPF_YAPF: return YapfRoadVehicleChooseTrack(RoadVehicle::From(v), tile, enterdir, (TrackdirBits)tracks, path_found);
+				default: NOT_REACHED();
+			}
+
+		case VEH_SHIP:
+			switch (_settings_game.pf.pathfinder_for_ships) {
+				case VPF_OPF:  return OPFShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)tracks, path_found);
+				case VPF_NPF:  return NPFShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)tracks, path_found);
+				case VPF_YAPF: return YapfShipChooseTrack(Ship::From(v), tile, enterdir, (TrackBits)tracks, path_found);
+				default: NOT_REACHED();
+			}
+
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Replay recorded path finder requests against the current game and measure
+ * the time the path finders need for them. The vehicles use the destination
+ * of the recording during their request. The recording should be replayed
+ * on a savegame made when it was started, as the vehicles otherwise are at
+ * other places than the requests assume.
+ * @param filename The name of the recording in the savegame directory, without directory.
+ * @param result [out] Summary of the replay.
+ * @return True if the recording could be opened.
+ */
+bool ReplayPathfinderRequests(const char *filename, PathfinderReplayResult *result)
+{
+	if (!IsValidRecordingName(filename)) return false;
+	FILE *f = FioFOpenFile(filename, "r", SAVE_DIR);
+	if (f == NULL) return false;
+
+	memset(result, 0, sizeof(*result));
+
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#') continue;
+
+		uint type, index, tile, enterdir, tracks, dest_tile, recorded;
+		if (sscanf(line, "%u %u %u %u %u %u %u", &type, &index, &tile, &enterdir, &tracks, &dest_tile, &recorded) != 7) continue;
+		result->requests++;
+
+		Vehicle *v = Vehicle::GetIfValid(index);
+		if (v == NULL || v->type != type || type >= VEH_AIRCRAFT || !v->IsPrimaryVehicle() ||
+				tile >= MapSize() || dest_tile >= MapSize() || enterdir >= DIAGDIR_END || tracks == 0) {
+			result->skipped++;
+			continue;
+		}
+
+		TileIndex dest_backup = v->dest_tile;
+		v->dest_tile = dest_tile;
+
+		CPerformanceTimer perf;
+		perf.Start();
+		uint replayed = ReplayPathfinderRequest(v, tile, (DiagDirection)enterdir, tracks);
+		perf.Stop();
+
+		v->dest_tile = dest_backup;
+
+		result->time_us += perf.Get(1000000);
+		if (replayed != recorded) result->different++;
+	}
+
+	fclose(f);
+	return true;
+}
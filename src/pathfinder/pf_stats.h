@@ -0,0 +1,73 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pf_stats.h Statistics of the path finder searches and recording/replaying of path finder requests. */
+
+#ifndef PF_STATS_H
+#define PF_STATS_H
+
+#include "../vehicle_type.h"
+#include "../tile_type.h"
+#include "../direction_type.h"
+
+/**
+ * Number of buckets of the histogram of search times. Bucket 0 holds the
+ * searches that took less than 1 microsecond, bucket i the searches that
+ * took at least 2^(i-1) but less than 2^i microseconds.
+ */
+static const uint PF_STATS_TIME_BUCKETS = 24;
+
+/** Statistics of the path finder searches of one vehicle type. */
+struct PathfinderStats {
+	uint32 calls;      ///< Number of searches.
+	uint32 not_found;  ///< Number of searches that did not find a path to the destination.
+	uint32 aborts;     ///< Number of searches that were aborted because they reached the maximum number of nodes.
+	uint64 nodes;      ///< Total number of expanded nodes.
+	uint64 cache_hits; ///< Total number of node costs that were taken from the segment cost cache.
+	uint64 cost_calcs; ///< Total number of node costs that had to be calculated.
+	uint64 total_us;   ///< Total time of all searches in microseconds.
+	uint32 max_us;     ///< Time of the longest search in microseconds.
+	uint32 time_histogram[PF_STATS_TIME_BUCKETS]; ///< Number of searches per time bucket.
+
+	uint32 GetTimePercentile(uint percent) const;
+};
+
+/** Result of replaying recorded path finder requests. */
+struct PathfinderReplayResult {
+	uint requests;  ///< Number of requests in the recording.
+	uint skipped;   ///< Number of requests whose vehicle does not exist in the current game.
+	uint different; ///< Number of replayed requests that gave another result than the recorded one.
+	uint64 time_us; ///< Total time of the replayed requests in microseconds.
+};
+
+extern PathfinderStats _pathfinder_stats[VEH_COMPANY_END];
+extern FILE *_pathfinder_record_file;
+
+void RecordPathfinderSearch(VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, bool found, bool aborted, uint time_us);
+void ResetPathfinderStats();
+
+bool StartPathfinderRecording(const char *filename);
+void StopPathfinderRecording();
+void WritePathfinderRequest(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint tracks, uint result);
+bool ReplayPathfinderRequests(const char *filename, PathfinderReplayResult *result);
+
+/**
+ * Log a path finder request to the recording, if one is active.
+ * @param v        The vehicle the path is searched for.
+ * @param tile     The tile the vehicle is about to enter.
+ * @param enterdir The direction the vehicle enters the tile from.
+ * @param tracks   The tracks or trackdirs the vehicle can choose from.
+ * @param result   The track or trackdir the path finder chose.
+ */
+static inline void RecordPathfinderRequest(const Vehicle *v, TileIndex tile, DiagDirection enterdir, uint tracks, uint result)
+{
+	if (_pathfinder_record_file != NULL) WritePathfinderRequest(v, tile, enterdir, tracks, result);
+}
+
+#endif /* PF_STATS_H */
@@ -20,6 +20,12 @@
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
  *  path finder.
+ *
+ *  Node lists are expensive to create as they own large hash tables
+ *  and node arrays. Therefore path finders take them from a pool with
+ *  Acquire() and hand them back with Release(); a returned node list
+ *  keeps its memory and is reset in time proportional to the number
+ *  of nodes it contained, so the next search can reuse it.
  */
 template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
 class CNodeList_HashTableT {
@@ -48,12 +54,29 @@ protected:
 	CPriorityQueue        m_open_queue;
 	/** new open node under construction */
 	Titem                *m_new_node;
+	/** number of memory allocations done for the current search */
+	int                   m_num_allocs;
+	/** number of node array blocks that were allocated when the current search started */
+	uint                  m_num_blocks;
+	/** next node list in the pool of unused node lists */
+	CNodeList_HashTableT *m_next_free;
+
+	/** pool of unused node lists */
+	static CNodeList_HashTableT *s_free_lists;
+	/** number of node lists in the pool */
+	static uint                  s_num_free_lists;
+	/** maximum number of node lists kept in the pool; more are freed */
+	static const uint            MAX_FREE_LISTS = 4;
+
 public:
 	/** default constructor */
 	CNodeList_HashTableT()
 		: m_open_queue(2048)
 	{
 		m_new_node = NULL;
+		m_num_allocs = 0;
+		m_num_blocks = 0;
+		m_next_free = NULL;
 	}
 
 	/** destructor */
@@ -61,6 +84,61 @@ public:
 	{
 	}
 
+	/**
+	 * Take a node list from the pool or create a new one if the pool is empty.
+	 * @note Only to be called from the main thread; the node list may then be
+	 *       used by any thread, as long as only one uses it at a time.
+	 * @return An empty node list.
+	 */
+	static CNodeList_HashTableT& Acquire()
+	{
+		CNodeList_HashTableT *nodes = s_free_lists;
+		if (nodes != NULL) {
+			s_free_lists = nodes->m_next_free;
+			s_num_free_lists--;
+			nodes->m_next_free = NULL;
+			nodes->m_num_allocs = 0;
+		} else {
+			nodes = new CNodeList_HashTableT();
+			nodes->m_num_allocs = 1;
+		}
+		nodes->m_num_blocks = nodes->m_arr.NumBlocks();
+		return *nodes;
+	}
+
+	/**
+	 * Return a node list obtained by Acquire() to the pool.
+	 * @note Only to be called from the main thread.
+	 * @param nodes The node list; it may not be used anymore.
+	 */
+	static void Release(CNodeList_HashTableT& nodes)
+	{
+		if (s_num_free_lists >= MAX_FREE_LISTS) {
+			delete &nodes;
+			return;
+		}
+		nodes.Reset();
+		nodes.m_next_free = s_free_lists;
+		s_free_lists = &nodes;
+		s_num_free_lists++;
+	}
+
+	/** forget all nodes, but keep the memory for the next search */
+	inline void Reset()
+	{
+		m_arr.Reset();
+		m_open.Reset();
+		m_closed.Reset();
+		m_open_queue.Clear();
+		m_new_node = NULL;
+	}
+
+	/** return number of memory allocations done for the current search (node list itself and node array blocks) */
+	inline int AllocCount() const
+	{
+		return m_num_allocs + (int)(m_arr.NumBlocks() - m_num_blocks);
+	}
+
 	/** return number of open nodes */
 	inline int OpenCount()
 	{
@@ -163,4 +241,10 @@ public:
 	}
 };
 
+template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
+CNodeList_HashTableT<Titem_, Thash_bits_open_, Thash_bits_closed_> *CNodeList_HashTableT<Titem_, Thash_bits_open_, Thash_bits_closed_>::s_free_lists = NULL;
+
+template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
+uint CNodeList_HashTableT<Titem_, Thash_bits_open_, Thash_bits_closed_>::s_num_free_lists = 0;
+
 #endif /* NODELIST_HPP */
@@ -52,6 +52,22 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
  */
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, struct PBSTileInfo *target);
 
+/**
+ * Run the searches of YapfTrainChooseTrack for the given trains concurrently on the worker threads.
+ * The next YapfTrainChooseTrack call for each of these trains uses the result, provided that the
+ * reservation of the train then ends at the given origin and the train still has the same destination.
+ * The map is not modified until all searches have finished, which is the case when this function returns.
+ * @param trains  the trains that are expected to need a path this tick
+ * @param origins for each train the end of its reservation when it will ask for the path
+ * @param count   number of trains
+ */
+void YapfTrainPrefetchPaths(const Train * const *trains, const struct PBSTileInfo *origins, uint count);
+
+/**
+ * Discard the results of YapfTrainPrefetchPaths that were not used.
+ */
+void YapfTrainClearPrefetchedPaths();
+
 /**
  * Used when user sends road vehicle to the nearest depot or if road vehicle needs servicing using YAPF.
  * @param v            vehicle that needs to go to some depot
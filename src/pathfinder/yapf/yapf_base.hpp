@@ -14,8 +14,10 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "../pf_stats.h"
 
 extern int _total_pf_time_us;
+extern int _total_pf_allocs;
 
 /**
  * CYapfBaseT - A-star type path finder base class.
@@ -58,7 +60,7 @@ public:
 	typedef typename Node::Key Key;            ///< key to hash tables
 
 
-	NodeList             m_nodes;              ///< node list multi-container
+	NodeList            &m_nodes;              ///< node list multi-container, taken from the pool of node lists
 protected:
 	Node                *m_pBestDestNode;      ///< pointer to the destination node found at last round
 	Node                *m_pBestIntermediateNode; ///< here should be node closest to the destination if path not found
@@ -68,6 +70,10 @@ protected:
 
 	int                  m_stats_cost_calcs;   ///< stats - how many node's costs were calculated
 	int                  m_stats_cache_hits;   ///< stats - how many node's costs were reused from cache
+	bool                 m_concurrent;         ///< the search runs on a worker thread, so don't touch any shared statistics
+	bool                 m_stats_found;        ///< stats - whether the last search found the destination
+	bool                 m_stats_aborted;      ///< stats - whether the last search reached the maximum number of nodes
+	int                  m_stats_time_us;      ///< stats - duration of the last search
 
 public:
 	CPerformanceTimer    m_perf_cost;          ///< stats - total CPU time of this run
@@ -81,19 +87,27 @@ public:
 public:
 	/** default constructor */
 	inline CYapfBaseT()
-		: m_pBestDestNode(NULL)
+		: m_nodes(NodeList::Acquire())
+		, m_pBestDestNode(NULL)
 		, m_pBestIntermediateNode(NULL)
 		, m_settings(&_settings_game.pf.yapf)
 		, m_max_search_nodes(PfGetSettings().max_search_nodes)
 		, m_veh(NULL)
 		, m_stats_cost_calcs(0)
 		, m_stats_cache_hits(0)
+		, m_concurrent(false)
+		, m_stats_found(false)
+		, m_stats_aborted(false)
+		, m_stats_time_us(0)
 		, m_num_steps(0)
 	{
 	}
 
-	/** default destructor */
-	~CYapfBaseT() {}
+	/** default destructor - hands the node list back to the pool */
+	~CYapfBaseT()
+	{
+		NodeList::Release(m_nodes);
+	}
 
 protected:
 	/** to access inherited path finder */
@@ -103,6 +117,12 @@ protected:
 	}
 
 public:
+	/** mark the search as running concurrently with other searches */
+	inline void SetConcurrent(bool concurrent)
+	{
+		m_concurrent = concurrent;
+	}
+
 	/** return current settings (can be custom - company based - but later) */
 	inline const YAPFSettings& PfGetSettings() const
 	{
@@ -122,10 +142,8 @@ public:
 	{
 		m_veh = v;
 
-#ifndef NO_DEBUG_MESSAGES
 		CPerformanceTimer perf;
 		perf.Start();
-#endif /* !NO_DEBUG_MESSAGES */
 
 		Yapf().PfSetStartupNodes();
 		bool bDestFound = true;
@@ -152,13 +170,20 @@ public:
 			}
 		}
 
+		bool bAborted = !bDestFound;
 		bDestFound &= (m_pBestDestNode != NULL);
 
-#ifndef NO_DEBUG_MESSAGES
 		perf.Stop();
-		if (_debug_yapf_level >= 2) {
-			int t = perf.Get(1000000);
+		m_stats_found = bDestFound;
+		m_stats_aborted = bAborted;
+		m_stats_time_us = perf.Get(1000000);
+		if (!m_concurrent) RecordStats();
+
+#ifndef NO_DEBUG_MESSAGES
+		if (_debug_yapf_level >= 2 && !m_concurrent) {
+			int t = m_stats_time_us;
 			_total_pf_time_us += t;
+			_total_pf_allocs += m_nodes.AllocCount();
 
 			if (_debug_yapf_level >= 3) {
 				UnitID veh_idx = (m_veh != NULL) ? m_veh->unitnumber : 0;
@@ -167,8 +192,8 @@ public:
 				int cost = bDestFound ? m_pBestDestNode->m_cost : -1;
 				int dist = bDestFound ? m_pBestDestNode->m_estimate - m_pBestDestNode->m_cost : -1;
 
-				DEBUG(yapf, 3, "[YAPF%c]%c%4d- %d us - %d rounds - %d open - %d closed - CHR %4.1f%% - C %d D %d - c%d(sc%d, ts%d, o%d) -- ",
-					ttc, bDestFound ? '-' : '!', veh_idx, t, m_num_steps, m_nodes.OpenCount(), m_nodes.ClosedCount(),
+				DEBUG(yapf, 3, "[YAPF%c]%c%4d- %d us - %d rounds - %d open - %d closed - %d allocs - CHR %4.1f%% - C %d D %d - c%d(sc%d, ts%d, o%d) -- ",
+					ttc, bDestFound ? '-' : '!', veh_idx, t, m_num_steps, m_nodes.OpenCount(), m_nodes.ClosedCount(), m_nodes.AllocCount(),
 					cache_hit_ratio, cost, dist, m_perf_cost.Get(1000000), m_perf_slope_cost.Get(1000000),
 					m_perf_ts_cost.Get(1000000), m_perf_other_cost.Get(1000000)
 				);
@@ -178,6 +203,15 @@ public:
 		return bDestFound;
 	}
 
+	/**
+	 * Add the last search to the path finder statistics. Searches that ran
+	 * concurrently have to be recorded by the main thread once they finished.
+	 */
+	inline void RecordStats() const
+	{
+		RecordPathfinderSearch(VehicleType::EXPECTED_TYPE, m_nodes.ClosedCount(), m_stats_cache_hits, m_stats_cost_calcs, m_stats_found, m_stats_aborted, m_stats_time_us);
+	}
+
 	/**
 	 * If path was found return the best node that has reached the destination. Otherwise
 	 *  return the best visited node (which was nearest to the destination).
@@ -142,6 +142,12 @@ struct CSegmentCostCacheT
 		m_heap.Clear();
 	}
 
+	/** find a segment without adding it to the cache */
+	inline const Tsegment *Find(const Key& key) const
+	{
+		return m_map.Find(key);
+	}
+
 	inline Tsegment& Get(Key& key, bool *found)
 	{
 		Tsegment *item = m_map.Find(key);
@@ -176,8 +182,9 @@ public:
 
 protected:
 	Cache&      m_global_cache;
+	bool        m_global_cache_read_only; ///< only copy complete segments out of the global cache, never add to it
 
-	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()) {};
+	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()), m_global_cache_read_only(false) {};
 
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -194,8 +201,9 @@ protected:
 		/* some statistics */
 		if (last_date != _date) {
 			last_date = _date;
-			DEBUG(yapf, 2, "Pf time today: %5d ms", _total_pf_time_us / 1000);
+			DEBUG(yapf, 2, "Pf time today: %5d ms - %d node list allocations", _total_pf_time_us / 1000, _total_pf_allocs);
 			_total_pf_time_us = 0;
+			_total_pf_allocs = 0;
 		}
 
 		/* delete the cache sometimes... */
@@ -217,6 +225,15 @@ public:
 			return Tlocal::PfNodeCacheFetch(n);
 		}
 		CacheKey key(n.GetKey());
+		if (m_global_cache_read_only) {
+			/* Use a private copy, so the node stays valid even if the global cache gets flushed. */
+			const CachedData *cached = m_global_cache.Find(key);
+			if (cached == NULL || cached->m_cost < 0) return Tlocal::PfNodeCacheFetch(n);
+			CachedData *copy = new (Tlocal::m_local_cache.Append()) CachedData(*cached);
+			copy->SetHashNext(NULL);
+			Yapf().ConnectNodeToCachedData(n, *copy);
+			return true;
+		}
 		bool found;
 		CachedData& item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
@@ -230,6 +247,15 @@ public:
 	inline void PfNodeCacheFlush(Node& n)
 	{
 	}
+
+	/**
+	 * Do not modify the global cache during the search. This allows multiple
+	 *  searches to run concurrently as long as nobody else touches the cache.
+	 */
+	inline void SetGlobalCacheReadOnly(bool read_only)
+	{
+		m_global_cache_read_only = read_only;
+	}
 };
 
 #endif /* YAPF_COSTCACHE_HPP */
@@ -63,7 +63,7 @@ struct CYapfNodeT {
 		m_estimate = 0;
 	}
 
-	inline Node *GetHashNext() {return m_hash_next;}
+	inline Node *GetHashNext() const {return m_hash_next;}
 	inline void SetHashNext(Node *pNext) {m_hash_next = pNext;}
 	inline TileIndex GetTile() const {return m_key.m_tile;}
 	inline Trackdir GetTrackdir() const {return m_key.m_td;}
@@ -165,7 +165,7 @@ struct CYapfRailSegment
 		return m_key.GetTile();
 	}
 
-	inline CYapfRailSegment *GetHashNext()
+	inline CYapfRailSegment *GetHashNext() const
 	{
 		return m_hash_next;
 	}
@@ -17,6 +17,9 @@
 #include "yapf_costrail.hpp"
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
+#include "../../thread/thread_pool.h"
+
+#include <map>
 
 #define DEBUG_YAPF_CACHE 0
 
@@ -36,6 +39,7 @@ template <typename Tpf> void DumpState(Tpf &pf1, Tpf &pf2)
 #endif
 
 int _total_pf_time_us = 0;
+int _total_pf_allocs = 0;
 
 template <class Types>
 class CYapfReserveTrack
@@ -401,8 +405,112 @@ public:
 		return 't';
 	}
 
+	/** A search for ChooseRailTrack() that was run before the train asked for it. */
+	struct PrefetchedSearch {
+		Tpf          pf;         ///< pathfinder holding the result of the search
+		const Train *v;          ///< the train the search was run for
+		PBSTileInfo  origin;     ///< origin of the search, i.e. the end of the train's reservation
+		Order        order;      ///< current order of the train when the search was started
+		TileIndex    dest_tile;  ///< destination tile of the train when the search was started
+		uint32       reservation_changes; ///< number of reservation changes on the map when the search was started
+		bool         path_found; ///< whether the search found a path
+	};
+
+	typedef std::map<VehicleID, PrefetchedSearch *> PrefetchedSearches;
+
+	/** searches run by stPrefetchRailTracks() that were not used yet */
+	static PrefetchedSearches& stPrefetchedSearches()
+	{
+		static PrefetchedSearches searches;
+		return searches;
+	}
+
+	/** worker thread part of stPrefetchRailTracks() */
+	static void stRunPrefetchedSearch(void *item)
+	{
+		PrefetchedSearch *s = (PrefetchedSearch *)item;
+		s->path_found = s->pf.FindPath(s->v);
+	}
+
+	/**
+	 * Run the searches of ChooseRailTrack() for the given trains and origins concurrently. The map
+	 *  must not be modified while the searches run, so all of them see the same state of the game.
+	 */
+	static void stPrefetchRailTracks(const Train * const *trains, const PBSTileInfo *origins, uint count)
+	{
+		PrefetchedSearches &searches = stPrefetchedSearches();
+		SmallVector<void *, 64> items;
+
+		for (uint i = 0; i < count; i++) {
+			const Train *v = trains[i];
+			PrefetchedSearch *s = new PrefetchedSearch();
+			s->v = v;
+			s->origin = origins[i];
+			s->order = v->current_order;
+			s->dest_tile = v->dest_tile;
+			s->reservation_changes = _reservation_changes;
+			s->path_found = false;
+
+			s->pf.SetOrigin(s->origin.tile, s->origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
+			s->pf.SetDestination(v);
+			s->pf.SetGlobalCacheReadOnly(true);
+			s->pf.SetConcurrent(true);
+
+			searches[v->index] = s;
+			*items.Append() = s;
+		}
+
+		ThreadPool::Get()->Run(&stRunPrefetchedSearch, items.Begin(), items.Length());
+	}
+
+	/** throw away all prefetched searches that were not used */
+	static void stClearPrefetchedRailTracks()
+	{
+		PrefetchedSearches &searches = stPrefetchedSearches();
+		for (typename PrefetchedSearches::iterator it = searches.begin(); it != searches.end(); ++it) {
+			delete it->second;
+		}
+		searches.clear();
+	}
+
+	/**
+	 * Take the prefetched search of the given train, if there is one that is still valid.
+	 *  It is only valid if the search would have started from the same origin and with
+	 *  the same destination, and no reservation changed since the search was started, as
+	 *  the search avoids the track other trains reserved.
+	 */
+	static PrefetchedSearch *stTakePrefetchedSearch(const Train *v)
+	{
+		PrefetchedSearches &searches = stPrefetchedSearches();
+		typename PrefetchedSearches::iterator it = searches.find(v->index);
+		if (it == searches.end()) return NULL;
+
+		PrefetchedSearch *s = it->second;
+		searches.erase(it);
+
+		PBSTileInfo origin = FollowTrainReservation(v);
+		if (s->v == v && s->reservation_changes == _reservation_changes &&
+				s->origin.tile == origin.tile && s->origin.trackdir == origin.trackdir &&
+				s->dest_tile == v->dest_tile && s->order.Equals(v->current_order)) {
+			return s;
+		}
+
+		delete s;
+		return NULL;
+	}
+
 	static Trackdir stChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 	{
+		PrefetchedSearch *s = stTakePrefetchedSearch(v);
+		if (s != NULL) {
+			/* The statistics are not thread safe, so the search is added when it is used instead of when it ran. */
+			s->pf.RecordStats();
+			path_found = s->path_found;
+			Trackdir result = s->pf.ChooseRailTrackFromBestNode(path_found, reserve_track, target);
+			delete s;
+			return result;
+		}
+
 		/* create pathfinder instance */
 		Tpf pf1;
 #if !DEBUG_YAPF_CACHE
@@ -424,8 +532,6 @@ public:
 
 	inline Trackdir ChooseRailTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 	{
-		if (target != NULL) target->tile = INVALID_TILE;
-
 		/* set origin and destination nodes */
 		PBSTileInfo origin = FollowTrainReservation(v);
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
@@ -434,6 +540,14 @@ public:
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
+		return ChooseRailTrackFromBestNode(path_found, reserve_track, target);
+	}
+
+	/** Second half of ChooseRailTrack(): get the next trackdir from the finished search and reserve the path. */
+	inline Trackdir ChooseRailTrackFromBestNode(bool &path_found, bool reserve_track, PBSTileInfo *target)
+	{
+		if (target != NULL) target->tile = INVALID_TILE;
+
 		/* if path not found - return INVALID_TRACKDIR */
 		Trackdir next_trackdir = INVALID_TRACKDIR;
 		Node *pNode = Yapf().GetBestNode();
@@ -548,6 +662,23 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
 }
 
+void YapfTrainPrefetchPaths(const Train * const *trains, const PBSTileInfo *origins, uint count)
+{
+	if (count == 0) return;
+
+	if (_settings_game.pf.forbid_90_deg) {
+		CYapfRail2::stPrefetchRailTracks(trains, origins, count);
+	} else {
+		CYapfRail1::stPrefetchRailTracks(trains, origins, count);
+	}
+}
+
+void YapfTrainClearPrefetchedPaths()
+{
+	CYapfRail1::stClearPrefetchedRailTracks();
+	CYapfRail2::stClearPrefetchedRailTracks();
+}
+
 bool YapfTrainCheckReverse(const Train *v)
 {
 	const Train *last_veh = v->Last();
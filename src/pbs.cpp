@@ -13,6 +13,80 @@
 #include "viewport_func.h"
 #include "vehicle_func.h"
 #include "pathfinder/follow_track.hpp"
+#include "core/smallvec_type.hpp"
+
+uint32 _reservation_area_versions[1 << RESERVATION_AREA_BITS]; ///< Number of reservation changes per map area, see NotifyReservationChange.
+uint32 _reservation_changes; ///< Number of reservation changes on the whole map, see NotifyReservationChange.
+
+/** The map areas a walk along a reservation read reservations from, with their versions at that time. */
+struct ReservationAreaList {
+	static const uint MAX_AREAS = 32; ///< Walks through more areas are not remembered.
+
+	uint count;                ///< Number of areas the walk passed, can be more than #MAX_AREAS.
+	uint16 areas[MAX_AREAS];   ///< The areas.
+	uint32 versions[MAX_AREAS]; ///< Versions of the areas when the walk passed them.
+
+	/**
+	 * Note that the reservation of a tile was read.
+	 * @param t The tile.
+	 */
+	inline void Add(TileIndex t)
+	{
+		uint area = GetReservationArea(t);
+		if (this->count > 0 && this->count <= MAX_AREAS && this->areas[this->count - 1] == area) return;
+		if (this->count < MAX_AREAS) {
+			this->areas[this->count] = area;
+			this->versions[this->count] = _reservation_area_versions[area];
+		}
+		this->count++;
+	}
+
+	/**
+	 * Check whether no reservation changed in any of the areas since the walk.
+	 * @return True if the result of the walk is still valid.
+	 */
+	inline bool IsUpToDate() const
+	{
+		if (this->count > MAX_AREAS) return false;
+		for (uint i = 0; i < this->count; i++) {
+			if (_reservation_area_versions[this->areas[i]] != this->versions[i]) return false;
+		}
+		return true;
+	}
+};
+
+/** The remembered end of the reservation of a train, see FollowTrainReservation. */
+struct CachedReservationEnd {
+	uint32 cache_version;      ///< Value of #_reservation_cache_version when the entry was made, 0 if unused.
+	TileIndex tile;            ///< Tile the walk started at.
+	Trackdir trackdir;         ///< Trackdir the walk started with.
+	Owner owner;               ///< Owner of the train.
+	RailTypes railtypes;       ///< Rail types the train can use.
+	bool forbid_90deg;         ///< Whether 90 degree turns were forbidden.
+	PBSTileInfo res;           ///< End of the reservation.
+	ReservationAreaList areas; ///< Areas the walk depended on.
+};
+
+/**
+ * Version of the cached reservation ends. It changes whenever the track layout
+ * may have changed, i.e. after every executed command, which invalidates all
+ * cached entries at once.
+ */
+static uint32 _reservation_cache_version = 1;
+static SmallVector<CachedReservationEnd, 64> _reservation_cache; ///< Cached reservation ends, indexed by vehicle index.
+
+/**
+ * Forget all cached reservation ends. Has to be called whenever the track
+ * layout, signals or ownership of tracks may have changed.
+ */
+void InvalidateReservationCache()
+{
+	if (++_reservation_cache_version == 0) {
+		/* Wrapped around; make sure old entries can't become valid again. */
+		_reservation_cache.Clear();
+		_reservation_cache_version = 1;
+	}
+}
 
 /**
  * Get the reserved trackbits for any tile, regardless of type.
@@ -173,8 +247,11 @@ void UnreserveRailTrack(TileIndex tile, Track t)
 }
 
 
-/** Follow a reservation starting from a specific tile to the end. */
-static PBSTileInfo FollowReservation(Owner o, RailTypes rts, TileIndex tile, Trackdir trackdir, bool ignore_oneway = false)
+/**
+ * Follow a reservation starting from a specific tile to the end.
+ * @param areas If not NULL, the map areas whose reservations were read are added to this list.
+ */
+static PBSTileInfo FollowReservation(Owner o, RailTypes rts, TileIndex tile, Trackdir trackdir, bool ignore_oneway = false, ReservationAreaList *areas = NULL)
 {
 	TileIndex start_tile = tile;
 	Trackdir  start_trackdir = trackdir;
@@ -183,11 +260,13 @@ static PBSTileInfo FollowReservation(Owner o, RailTypes rts, TileIndex tile, Tra
 	/* Start track not reserved? This can happen if two trains
 	 * are on the same tile. The reservation on the next tile
 	 * is not ours in this case, so exit. */
+	if (areas != NULL) areas->Add(tile);
 	if (!HasReservedTracks(tile, TrackToTrackBits(TrackdirToTrack(trackdir)))) return PBSTileInfo(tile, trackdir, false);
 
 	/* Do not disallow 90 deg turns as the setting might have changed between reserving and now. */
 	CFollowTrackRail ft(o, rts);
 	while (ft.Follow(tile, trackdir)) {
+		if (areas != NULL) areas->Add(ft.m_new_tile);
 		TrackdirBits reserved = ft.m_new_td_bits & TrackBitsToTrackdirBits(GetReservedTrackbits(ft.m_new_tile));
 
 		/* No reservation --> path end found */
@@ -197,6 +276,7 @@ static PBSTileInfo FollowReservation(Owner o, RailTypes rts, TileIndex tile, Tra
 				TileIndexDiff diff = TileOffsByDiagDir(ft.m_exitdir);
 				while (ft.m_tiles_skipped-- > 0) {
 					ft.m_new_tile -= diff;
+					if (areas != NULL) areas->Add(ft.m_new_tile);
 					if (HasStationReservation(ft.m_new_tile)) {
 						tile = ft.m_new_tile;
 						trackdir = DiagDirToDiagTrackdir(ft.m_exitdir);
@@ -268,6 +348,49 @@ static Vehicle *FindTrainOnTrackEnum(Vehicle *v, void *data)
 	return NULL;
 }
 
+/**
+ * Follow the reservation of a train to its end and check whether the end is
+ * a safe waiting position. The result is remembered for the train and reused
+ * as long as the train did not move, no command was executed and no
+ * reservation changed in the areas of the map the reservation passes.
+ * @note Not thread safe; only to be called from the main thread.
+ * @param v The train.
+ * @param tile The tile the train is on.
+ * @param trackdir The trackdir of the train on its tile.
+ * @return The end of the reservation.
+ */
+static PBSTileInfo FollowTrainReservationEnd(const Train *v, TileIndex tile, Trackdir trackdir)
+{
+	RailTypes rts = GetRailTypeInfo(v->railtype)->compatible_railtypes;
+	bool forbid_90deg = _settings_game.pf.forbid_90_deg;
+
+	while (_reservation_cache.Length() <= v->index) _reservation_cache.Append()->cache_version = 0;
+	CachedReservationEnd *entry = &_reservation_cache[v->index];
+
+	if (entry->cache_version == _reservation_cache_version && entry->tile == tile && entry->trackdir == trackdir &&
+			entry->owner == v->owner && entry->railtypes == rts && entry->forbid_90deg == forbid_90deg &&
+			entry->areas.IsUpToDate()) {
+		return entry->res;
+	}
+
+	entry->areas.count = 0;
+	PBSTileInfo res = FollowReservation(v->owner, rts, tile, trackdir, false, &entry->areas);
+	res.okay = IsSafeWaitingPosition(v, res.tile, res.trackdir, true, forbid_90deg);
+
+	if (entry->areas.count <= ReservationAreaList::MAX_AREAS) {
+		entry->cache_version = _reservation_cache_version;
+		entry->tile = tile;
+		entry->trackdir = trackdir;
+		entry->owner = v->owner;
+		entry->railtypes = rts;
+		entry->forbid_90deg = forbid_90deg;
+		entry->res = res;
+	} else {
+		entry->cache_version = 0;
+	}
+	return res;
+}
+
 /**
  * Follow a train reservation to the last tile.
  *
@@ -285,8 +408,7 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 	if (IsRailDepotTile(tile) && !GetDepotReservationTrackBits(tile)) return PBSTileInfo(tile, trackdir, false);
 
 	FindTrainOnTrackInfo ftoti;
-	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
-	ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
+	ftoti.res = FollowTrainReservationEnd(v, tile, trackdir);
 	if (train_on_res != NULL) {
 		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
 		if (ftoti.best != NULL) *train_on_res = ftoti.best->First();
@@ -358,26 +480,20 @@ Train *GetTrainForReservation(TileIndex tile, Track track)
 }
 
 /**
- * Determine whether a certain track on a tile is a safe position to end a path.
+ * Determine whether the tile behind a certain track makes it a safe position to end a path.
  *
  * @param v the vehicle to test for
+ * @param railtypes the rail types the vehicle can use
  * @param tile The tile
  * @param trackdir The trackdir to test
  * @param include_line_end Should end-of-line tiles be considered safe?
  * @param forbid_90deg Don't allow trains to make 90 degree turns
  * @return True if it is a safe position
  */
-bool IsSafeWaitingPosition(const Train *v, TileIndex tile, Trackdir trackdir, bool include_line_end, bool forbid_90deg)
+static bool IsSafeWaitingPositionByNextTile(const Train *v, RailTypes railtypes, TileIndex tile, Trackdir trackdir, bool include_line_end, bool forbid_90deg)
 {
-	if (IsRailDepotTile(tile)) return true;
-
-	if (IsTileType(tile, MP_RAILWAY)) {
-		/* For non-pbs signals, stop on the signal tile. */
-		if (HasSignalOnTrackdir(tile, trackdir) && !IsPbsSignal(GetSignalType(tile, TrackdirToTrack(trackdir)))) return true;
-	}
-
 	/* Check next tile. For perfomance reasons, we check for 90 degree turns ourself. */
-	CFollowTrackRail ft(v, GetRailTypeInfo(v->railtype)->compatible_railtypes);
+	CFollowTrackRail ft(v, railtypes);
 
 	/* End of track? */
 	if (!ft.Follow(tile, trackdir)) {
@@ -404,6 +520,35 @@ bool IsSafeWaitingPosition(const Train *v, TileIndex tile, Trackdir trackdir, bo
 	return false;
 }
 
+/**
+ * Determine whether a certain track on a tile is a safe position to end a path.
+ *
+ * @param v the vehicle to test for
+ * @param tile The tile
+ * @param trackdir The trackdir to test
+ * @param include_line_end Should end-of-line tiles be considered safe?
+ * @param forbid_90deg Don't allow trains to make 90 degree turns
+ * @return True if it is a safe position
+ */
+bool IsSafeWaitingPosition(const Train *v, TileIndex tile, Trackdir trackdir, bool include_line_end, bool forbid_90deg)
+{
+	if (IsRailDepotTile(tile)) return true;
+
+	if (IsTileType(tile, MP_RAILWAY)) {
+		/* For non-pbs signals, stop on the signal tile. */
+		if (HasSignalOnTrackdir(tile, trackdir) && !IsPbsSignal(GetSignalType(tile, TrackdirToTrack(trackdir)))) return true;
+	}
+
+	/* The next tile only depends on the track layout, so it is remembered with the signal blocks. */
+	RailTypes railtypes = GetRailTypeInfo(v->railtype)->compatible_railtypes;
+	bool safe;
+	if (GetRememberedSafeWaitingPosition(tile, trackdir, v->owner, railtypes, include_line_end, forbid_90deg, &safe)) return safe;
+
+	safe = IsSafeWaitingPositionByNextTile(v, railtypes, tile, trackdir, include_line_end, forbid_90deg);
+	RememberSafeWaitingPosition(tile, trackdir, v->owner, railtypes, include_line_end, forbid_90deg, safe);
+	return safe;
+}
+
 /**
  * Check if a safe position is free.
  *
@@ -17,6 +17,36 @@
 #include "track_type.h"
 #include "vehicle_type.h"
 
+/** Number of bits of the index of the map areas whose reservation changes are tracked. */
+static const uint RESERVATION_AREA_BITS = 12;
+
+extern uint32 _reservation_area_versions[1 << RESERVATION_AREA_BITS];
+extern uint32 _reservation_changes;
+
+/**
+ * Get the area of the map a tile belongs to for tracking reservation changes.
+ * Areas are groups of tiles hashed together, so they do not need to be adjacent.
+ * @param t The tile.
+ * @return The index of the area.
+ */
+static inline uint GetReservationArea(TileIndex t)
+{
+	return (t >> 2) & ((1 << RESERVATION_AREA_BITS) - 1);
+}
+
+/**
+ * Note that the reservation of a tile changed. Cached ends of reservations
+ * that pass through the area of the tile are then no longer used.
+ * @param t The tile.
+ */
+static inline void NotifyReservationChange(TileIndex t)
+{
+	_reservation_area_versions[GetReservationArea(t)]++;
+	_reservation_changes++;
+}
+
+void InvalidateReservationCache();
+
 TrackBits GetReservedTrackbits(TileIndex t);
 
 void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool b);
@@ -1548,6 +1548,7 @@ CommandCost CmdConvertRail(TileIndex tile, DoCommandFlag flags, uint32 p1, uint3
 				}
 
 				SetRailType(tile, totype);
+				InvalidateSignalSegmentCache(tile);
 				MarkTileDirtyByTile(tile);
 				/* update power of train on this tile */
 				FindVehicleOnPos(tile, &affected_trains, &UpdateTrainPowerProc);
@@ -1619,6 +1620,8 @@ CommandCost CmdConvertRail(TileIndex tile, DoCommandFlag flags, uint32 p1, uint3
 
 					SetRailType(tile, totype);
 					SetRailType(endtile, totype);
+					InvalidateSignalSegmentCache(tile);
+					InvalidateSignalSegmentCache(endtile);
 
 					FindVehicleOnPos(tile, &affected_trains, &UpdateTrainPowerProc);
 					FindVehicleOnPos(endtile, &affected_trains, &UpdateTrainPowerProc);
@@ -2856,8 +2859,10 @@ static VehicleEnterTileStatus VehicleEnter_Track(Vehicle *u, TileIndex tile, int
 			v->track = TRACK_BIT_DEPOT,
 			v->vehstatus |= VS_HIDDEN; // hide it
 			v->direction = ReverseDir(v->direction);
+			UpdateSignalBlockOccupancy(v);
 			if (v->Next() == NULL) VehicleEnterDepot(v->First());
 			v->tile = tile;
+			UpdateSignalBlockOccupancy(v);
 
 			InvalidateWindowData(WC_VEHICLE_DEPOT, v->tile);
 			return VETSB_ENTERED_WORMHOLE;
@@ -2868,6 +2873,7 @@ static VehicleEnterTileStatus VehicleEnter_Track(Vehicle *u, TileIndex tile, int
 			if ((v = v->Next()) != NULL) {
 				v->vehstatus &= ~VS_HIDDEN;
 				v->track = (DiagDirToAxis(dir) == AXIS_X ? TRACK_BIT_X : TRACK_BIT_Y);
+				UpdateSignalBlockOccupancy(v);
 			}
 		}
 	}
@@ -18,6 +18,7 @@
 #include "track_func.h"
 #include "tile_map.h"
 #include "signal_type.h"
+#include "pbs.h"
 
 
 /** Different types of Rail-related tiles */
@@ -84,6 +85,7 @@ static inline bool HasSignals(TileIndex t)
 static inline void SetHasSignals(TileIndex tile, bool signals)
 {
 	assert(IsPlainRailTile(tile));
+	NotifyTileChange(tile);
 	SB(_m[tile].m5, 6, 1, signals);
 }
 
@@ -125,6 +127,7 @@ static inline RailType GetRailType(TileIndex t)
  */
 static inline void SetRailType(TileIndex t, RailType r)
 {
+	NotifyTileChange(t);
 	SB(_m[t].m3, 0, 4, r);
 }
 
@@ -148,6 +151,7 @@ static inline TrackBits GetTrackBits(TileIndex tile)
 static inline void SetTrackBits(TileIndex t, TrackBits b)
 {
 	assert(IsPlainRailTile(t));
+	NotifyTileChange(t);
 	SB(_m[t].m5, 0, 6, b);
 }
 
@@ -212,9 +216,11 @@ static inline void SetTrackReservation(TileIndex t, TrackBits b)
 	assert(IsPlainRailTile(t));
 	assert(b != INVALID_TRACK_BIT);
 	assert(!TracksOverlap(b));
+	NotifyTileChange(t);
 	Track track = RemoveFirstTrack(&b);
 	SB(_m[t].m2, 8, 3, track == INVALID_TRACK ? 0 : track + 1);
 	SB(_m[t].m2, 11, 1, (byte)(b != TRACK_BIT_NONE));
+	NotifyReservationChange(t);
 }
 
 /**
@@ -271,7 +277,9 @@ static inline bool HasDepotReservation(TileIndex t)
 static inline void SetDepotReservation(TileIndex t, bool b)
 {
 	assert(IsRailDepot(t));
+	NotifyTileChange(t);
 	SB(_m[t].m5, 4, 1, (byte)b);
+	NotifyReservationChange(t);
 }
 
 /**
@@ -301,6 +309,7 @@ static inline SignalType GetSignalType(TileIndex t, Track track)
 static inline void SetSignalType(TileIndex t, Track track, SignalType s)
 {
 	assert(GetRailTileType(t) == RAIL_TILE_SIGNALS);
+	NotifyTileChange(t);
 	byte pos = (track == TRACK_LOWER || track == TRACK_RIGHT) ? 4 : 0;
 	SB(_m[t].m2, pos, 3, s);
 	if (track == INVALID_TRACK) SB(_m[t].m2, 4, 3, s);
@@ -324,6 +333,7 @@ static inline bool IsOnewaySignal(TileIndex t, Track track)
 
 static inline void CycleSignalSide(TileIndex t, Track track)
 {
+	NotifyTileChange(t);
 	byte sig;
 	byte pos = (track == TRACK_LOWER || track == TRACK_RIGHT) ? 4 : 6;
 
@@ -340,6 +350,7 @@ static inline SignalVariant GetSignalVariant(TileIndex t, Track track)
 
 static inline void SetSignalVariant(TileIndex t, Track track, SignalVariant v)
 {
+	NotifyTileChange(t);
 	byte pos = (track == TRACK_LOWER || track == TRACK_RIGHT) ? 7 : 3;
 	SB(_m[t].m2, pos, 1, v);
 	if (track == INVALID_TRACK) SB(_m[t].m2, 7, 1, v);
@@ -362,6 +373,7 @@ enum SignalState {
  */
 static inline void SetSignalStates(TileIndex tile, uint state)
 {
+	NotifyTileChange(tile);
 	SB(_m[tile].m4, 4, 4, state);
 }
 
@@ -393,6 +405,7 @@ static inline SignalState GetSingleSignalState(TileIndex t, byte signalbit)
  */
 static inline void SetPresentSignals(TileIndex tile, uint signals)
 {
+	NotifyTileChange(tile);
 	SB(_m[tile].m3, 4, 4, signals);
 }
 
@@ -513,6 +526,7 @@ enum RailGroundType {
 
 static inline void SetRailGroundType(TileIndex t, RailGroundType rgt)
 {
+	NotifyTileChange(t);
 	SB(_m[t].m4, 0, 4, rgt);
 }
 
@@ -529,6 +543,7 @@ static inline bool IsSnowRailGround(TileIndex t)
 
 static inline void MakeRailNormal(TileIndex t, Owner o, TrackBits b, RailType r)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_RAILWAY);
 	SetTileOwner(t, o);
 	_m[t].m2 = 0;
@@ -542,6 +557,7 @@ static inline void MakeRailNormal(TileIndex t, Owner o, TrackBits b, RailType r)
 
 static inline void MakeRailDepot(TileIndex t, Owner o, DepotID did, DiagDirection d, RailType r)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_RAILWAY);
 	SetTileOwner(t, o);
 	_m[t].m2 = did;
@@ -17,6 +17,7 @@
 #include "rail_type.h"
 #include "road_func.h"
 #include "tile_map.h"
+#include "pbs.h"
 
 
 /** The different types of road tiles. */
@@ -151,6 +152,7 @@ static inline RoadBits GetAllRoadBits(TileIndex tile)
 static inline void SetRoadBits(TileIndex t, RoadBits r, RoadType rt)
 {
 	assert(IsNormalRoad(t)); // XXX incomplete
+	NotifyTileChange(t);
 	switch (rt) {
 		default: NOT_REACHED();
 		case ROADTYPE_ROAD: SB(_m[t].m5, 0, 4, r); break;
@@ -176,6 +178,7 @@ static inline RoadTypes GetRoadTypes(TileIndex t)
 static inline void SetRoadTypes(TileIndex t, RoadTypes rt)
 {
 	assert(IsTileType(t, MP_ROAD) || IsTileType(t, MP_STATION) || IsTileType(t, MP_TUNNELBRIDGE));
+	NotifyTileChange(t);
 	SB(_me[t].m7, 6, 2, rt);
 }
 
@@ -219,6 +222,7 @@ static inline Owner GetRoadOwner(TileIndex t, RoadType rt)
  */
 static inline void SetRoadOwner(TileIndex t, RoadType rt, Owner o)
 {
+	NotifyTileChange(t);
 	switch (rt) {
 		default: NOT_REACHED();
 		case ROADTYPE_ROAD: SB(IsNormalRoadTile(t) ? _m[t].m1 : _me[t].m7, 0, 5, o); break;
@@ -283,6 +287,7 @@ static inline void SetDisallowedRoadDirections(TileIndex t, DisallowedRoadDirect
 {
 	assert(IsNormalRoad(t));
 	assert(drd < DRD_END);
+	NotifyTileChange(t);
 	SB(_m[t].m5, 4, 2, drd);
 }
 
@@ -363,7 +368,9 @@ static inline bool HasCrossingReservation(TileIndex t)
 static inline void SetCrossingReservation(TileIndex t, bool b)
 {
 	assert(IsLevelCrossingTile(t));
+	NotifyTileChange(t);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	NotifyReservationChange(t);
 }
 
 /**
@@ -398,6 +405,7 @@ static inline bool IsCrossingBarred(TileIndex t)
 static inline void SetCrossingBarred(TileIndex t, bool barred)
 {
 	assert(IsLevelCrossing(t));
+	NotifyTileChange(t);
 	SB(_m[t].m5, 5, 1, barred ? 1 : 0);
 }
 
@@ -439,6 +447,7 @@ static inline bool IsOnSnow(TileIndex t)
  */
 static inline void ToggleSnow(TileIndex t)
 {
+	NotifyTileChange(t);
 	ToggleBit(_me[t].m7, 5);
 }
 
@@ -471,6 +480,7 @@ static inline Roadside GetRoadside(TileIndex tile)
  */
 static inline void SetRoadside(TileIndex tile, Roadside s)
 {
+	NotifyTileChange(tile);
 	SB(_m[tile].m6, 3, 3, s);
 }
 
@@ -491,6 +501,7 @@ static inline bool HasRoadWorks(TileIndex t)
  */
 static inline bool IncreaseRoadWorksCounter(TileIndex t)
 {
+	NotifyTileChange(t);
 	AB(_me[t].m7, 0, 4, 1);
 
 	return GB(_me[t].m7, 0, 4) == 15;
@@ -520,6 +531,7 @@ static inline void StartRoadWorks(TileIndex t)
 static inline void TerminateRoadWorks(TileIndex t)
 {
 	assert(HasRoadWorks(t));
+	NotifyTileChange(t);
 	SetRoadside(t, (Roadside)(GetRoadside(t) - ROADSIDE_GRASS_ROAD_WORKS + ROADSIDE_GRASS));
 	/* Stop the counter */
 	SB(_me[t].m7, 0, 4, 0);
@@ -552,6 +564,7 @@ RoadBits GetAnyRoadBits(TileIndex tile, RoadType rt, bool straight_tunnel_bridge
  */
 static inline void MakeRoadNormal(TileIndex t, RoadBits bits, RoadTypes rot, TownID town, Owner road, Owner tram)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_ROAD);
 	SetTileOwner(t, road);
 	_m[t].m2 = town;
@@ -576,6 +589,7 @@ static inline void MakeRoadNormal(TileIndex t, RoadBits bits, RoadTypes rot, Tow
  */
 static inline void MakeRoadCrossing(TileIndex t, Owner road, Owner tram, Owner rail, Axis roaddir, RailType rat, RoadTypes rot, uint town)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_ROAD);
 	SetTileOwner(t, rail);
 	_m[t].m2 = town;
@@ -597,6 +611,7 @@ static inline void MakeRoadCrossing(TileIndex t, Owner road, Owner tram, Owner r
  */
 static inline void MakeRoadDepot(TileIndex t, Owner owner, DepotID did, DiagDirection dir, RoadType rt)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_ROAD);
 	SetTileOwner(t, owner);
 	_m[t].m2 = did;
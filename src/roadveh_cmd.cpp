@@ -14,6 +14,7 @@
 #include "command_func.h"
 #include "news_func.h"
 #include "pathfinder/npf/npf_func.h"
+#include "pathfinder/pf_stats.h"
 #include "station_base.h"
 #include "company_func.h"
 #include "articulated_vehicles.h"
@@ -932,6 +933,7 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 
 		default: NOT_REACHED();
 	}
+	RecordPathfinderRequest(v, tile, enterdir, trackdirs, best_track);
 	v->HandlePathfindingResult(path_found);
 
 found_best_track:;
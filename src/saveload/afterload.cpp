@@ -2737,6 +2737,13 @@ bool AfterLoadGame()
 	AfterLoadLabelMaps();
 	AfterLoadCompanyStats();
 
+	/* Tracks of trains were converted above without counting them in the signal blocks. */
+	{
+		Train *t;
+		FOR_ALL_TRAINS(t) UpdateSignalBlockOccupancy(t);
+		InvalidateSignalSegmentCache();
+	}
+
 	GamelogPrintDebug(1);
 
 	InitializeWindowsAndCaches();
@@ -72,30 +72,31 @@ const SaveLoad *GetLinkGraphDesc()
 /* Edges and nodes are saved in the correct order, so we don't need to save their ids. */
 
 /**
- * SaveLoad desc for a link graph node.
+ * SaveLoad desc for a link graph node, before the nodes were saved as arrays.
  */
 static const SaveLoad _node_desc[] = {
-	 SLE_CONDVAR(Node, supply,    SLE_UINT32, SL_COMPONENTS, SL_MAX_VERSION),
-	 SLE_CONDVAR(Node, demand,    SLE_UINT32, SL_COMPONENTS, SL_MAX_VERSION),
-	 SLE_CONDVAR(Node, station,   SLE_UINT16, SL_COMPONENTS, SL_MAX_VERSION),
+	 SLE_CONDVAR(Node, supply,    SLE_UINT32, SL_COMPONENTS, SL_COMPACT_LINKGRAPH - 1),
+	 SLE_CONDVAR(Node, demand,    SLE_UINT32, SL_COMPONENTS, SL_COMPACT_LINKGRAPH - 1),
+	 SLE_CONDVAR(Node, station,   SLE_UINT16, SL_COMPONENTS, SL_COMPACT_LINKGRAPH - 1),
 	 SLE_END()
 };
 
 /**
- * SaveLoad desc for a link graph edge.
+ * SaveLoad desc for a link graph edge, before only the real edges were saved.
  */
 static const SaveLoad _edge_desc[] = {
-	 SLE_CONDVAR(Edge, distance,  SLE_UINT32, SL_COMPONENTS, SL_MAX_VERSION),
-	 SLE_CONDVAR(Edge, capacity,  SLE_UINT32, SL_COMPONENTS, SL_MAX_VERSION),
-	 SLE_CONDVAR(Edge, next_edge, SLE_UINT32,        SL_MCF, SL_MAX_VERSION),
+	 SLE_CONDVAR(Edge, distance,  SLE_UINT32, SL_COMPONENTS, SL_COMPACT_LINKGRAPH - 1),
+	 SLE_CONDVAR(Edge, capacity,  SLE_UINT32, SL_COMPONENTS, SL_COMPACT_LINKGRAPH - 1),
+	 SLE_CONDVAR(Edge, next_edge, SLE_UINT32,        SL_MCF, SL_COMPACT_LINKGRAPH - 1),
 	 SLE_END()
 };
 
 /**
- * Save/load a component of a link graph
- * @param comp the component to be saved or loaded
+ * Load a component of a link graph from a savegame that has all edges of
+ * the component, including the ones that only hold a distance.
+ * @param comp the component to be loaded
  */
-static void SaveLoad_LinkGraphComponent(LinkGraphComponent &comp)
+static void Load_LinkGraphComponentMatrix(LinkGraphComponent &comp)
 {
 	uint size = comp.GetSize();
 	for (NodeID from = 0; from < size; ++from) {
@@ -107,6 +108,161 @@ static void SaveLoad_LinkGraphComponent(LinkGraphComponent &comp)
 	}
 }
 
+/**
+ * Save or load a vector as an array.
+ * @param vector The vector; when loading it has to have the size of the array already.
+ * @param conv   The type of the elements in the savegame and in the vector.
+ */
+template <typename T>
+static void SlVector(std::vector<T> &vector, VarType conv)
+{
+	if (!vector.empty()) SlArray(&vector[0], vector.size(), conv);
+}
+
+/**
+ * Get the location the distances of a node to the other nodes are calculated from.
+ * @param node The node.
+ * @return The location of the station of the node, or #INVALID_TILE if the station has been removed.
+ */
+static TileIndex GetNodeLocation(const Node &node)
+{
+	const Station *st = Station::GetIfValid(node.station);
+	return st == NULL ? INVALID_TILE : st->xy;
+}
+
+/**
+ * Save a component of a link graph. Each field of the nodes is saved as an
+ * array, followed by the number of real edges of every node, i.e. the edges
+ * in the list starting at the node, and the destinations and capacities of
+ * those edges in the order of the lists. The distances are not saved, but
+ * calculated from the locations of the stations when loading. Only the few
+ * distances that differ from those, because a station moved or was removed
+ * after the component was created, are saved explicitly.
+ * @param comp the component to be saved
+ */
+static void Save_LinkGraphComponent(LinkGraphComponent &comp)
+{
+	uint size = comp.GetSize();
+	std::vector<uint32> supply(size);
+	std::vector<uint32> demand(size);
+	std::vector<StationID> stations(size);
+	std::vector<TileIndex> locations(size);
+	std::vector<uint32> num_edges(size);
+	std::vector<NodeID> edge_to;
+	std::vector<uint32> edge_capacity;
+
+	for (NodeID from = 0; from < size; ++from) {
+		const Node &node = comp.GetNode(from);
+		supply[from] = node.supply;
+		demand[from] = node.demand;
+		stations[from] = node.station;
+		locations[from] = GetNodeLocation(node);
+
+		for (NodeID to = comp.GetFirstEdge(from); to != INVALID_NODE; to = comp.GetEdge(from, to).next_edge) {
+			num_edges[from]++;
+			edge_to.push_back(to);
+			edge_capacity.push_back(comp.GetEdge(from, to).capacity);
+		}
+	}
+
+	std::vector<NodeID> other_from;
+	std::vector<NodeID> other_to;
+	std::vector<uint32> other_distance;
+	for (NodeID from = 0; from < size; ++from) {
+		for (NodeID to = 0; to < size; ++to) {
+			uint distance = comp.GetEdge(from, to).distance;
+			if (from == to || distance == DistanceManhattan(locations[from], locations[to])) continue;
+			other_from.push_back(from);
+			other_to.push_back(to);
+			other_distance.push_back(distance);
+		}
+	}
+	uint32 num_other = (uint32)other_distance.size();
+
+	SlVector(supply, SLE_UINT32);
+	SlVector(demand, SLE_UINT32);
+	SlVector(stations, SLE_UINT16);
+	SlVector(locations, SLE_UINT32);
+	SlVector(num_edges, SLE_UINT32);
+	SlVector(edge_to, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(edge_capacity, SLE_UINT32);
+	SlArray(&num_other, 1, SLE_UINT32);
+	SlVector(other_from, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(other_to, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(other_distance, SLE_UINT32);
+}
+
+/**
+ * Load a component of a link graph saved by #Save_LinkGraphComponent.
+ * @param comp the component to be loaded
+ */
+static void Load_LinkGraphComponent(LinkGraphComponent &comp)
+{
+	uint size = comp.GetSize();
+	std::vector<uint32> supply(size);
+	std::vector<uint32> demand(size);
+	std::vector<StationID> stations(size);
+	std::vector<TileIndex> locations(size);
+	std::vector<uint32> num_edges(size);
+
+	SlVector(supply, SLE_UINT32);
+	SlVector(demand, SLE_UINT32);
+	SlVector(stations, SLE_UINT16);
+	SlVector(locations, SLE_UINT32);
+	SlVector(num_edges, SLE_UINT32);
+
+	uint total_edges = 0;
+	for (NodeID from = 0; from < size; ++from) {
+		if (num_edges[from] >= size) SlErrorCorrupt("Link graph node with too many edges");
+		total_edges += num_edges[from];
+	}
+
+	std::vector<NodeID> edge_to(total_edges);
+	std::vector<uint32> edge_capacity(total_edges);
+	SlVector(edge_to, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(edge_capacity, SLE_UINT32);
+
+	for (NodeID from = 0; from < size; ++from) {
+		Node &node = comp.GetNode(from);
+		node.supply = supply[from];
+		node.demand = demand[from];
+		node.station = stations[from];
+
+		for (NodeID to = 0; to < size; ++to) {
+			if (to != from) comp.GetEdge(from, to).distance = DistanceManhattan(locations[from], locations[to]);
+		}
+	}
+
+	uint edge = 0;
+	for (NodeID from = 0; from < size; ++from) {
+		NodeID *next = &comp.GetEdge(from, from).next_edge;
+		for (uint i = 0; i < num_edges[from]; i++, edge++) {
+			NodeID to = edge_to[edge];
+			if (to >= size || to == from) SlErrorCorrupt("Invalid link graph edge");
+			comp.GetEdge(from, to).capacity = edge_capacity[edge];
+			*next = to;
+			next = &comp.GetEdge(from, to).next_edge;
+		}
+		*next = INVALID_NODE;
+	}
+
+	uint32 num_other;
+	SlArray(&num_other, 1, SLE_UINT32);
+	if (num_other > (uint64)size * size) SlErrorCorrupt("Too many link graph distances");
+
+	std::vector<NodeID> other_from(num_other);
+	std::vector<NodeID> other_to(num_other);
+	std::vector<uint32> other_distance(num_other);
+	SlVector(other_from, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(other_to, SLE_FILE_U16 | SLE_VAR_U32);
+	SlVector(other_distance, SLE_UINT32);
+
+	for (uint i = 0; i < num_other; i++) {
+		if (other_from[i] >= size || other_to[i] >= size) SlErrorCorrupt("Invalid link graph distance");
+		comp.GetEdge(other_from[i], other_to[i]).distance = other_distance[i];
+	}
+}
+
 /**
  * Save all link graphs.
  */
@@ -115,7 +271,7 @@ static void DoSave_LGRP(void *)
 	for (CargoID cargo = 0; cargo < NUM_CARGO; ++cargo) {
 		LinkGraph &graph = _link_graphs[cargo];
 		SlObject(&graph, GetLinkGraphDesc());
-		SaveLoad_LinkGraphComponent(graph);
+		Save_LinkGraphComponent(graph);
 	}
 }
 
@@ -129,7 +285,11 @@ static void Load_LGRP()
 		assert(graph.GetSize() == 0);
 		SlObject(&graph, GetLinkGraphDesc());
 		graph.SetSize();
-		SaveLoad_LinkGraphComponent(graph);
+		if (IsSavegameVersionBefore(SL_COMPACT_LINKGRAPH)) {
+			Load_LinkGraphComponentMatrix(graph);
+		} else {
+			Load_LinkGraphComponent(graph);
+		}
 		for (uint i = 0; i < graph.GetSize(); ++i) {
 			Node &node = graph.GetNode(i);
 			node.undelivered_supply = node.supply;
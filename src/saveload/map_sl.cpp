@@ -47,153 +47,172 @@ static void Check_MAPS()
 
 static const uint MAP_SL_BUF_SIZE = 4096;
 
-static void Load_MAPT()
+/*
+ * Accessors of the byte sized fields of the tiles. The map chunks hold one
+ * field of all tiles each; these let a single template move the field
+ * between the map and the savegame buffer.
+ */
+struct MapTypeHeightField { static inline byte &Get(TileIndex t) { return _m[t].type_height; } };
+struct Map1Field          { static inline byte &Get(TileIndex t) { return _m[t].m1; } };
+struct Map3Field          { static inline byte &Get(TileIndex t) { return _m[t].m3; } };
+struct Map4Field          { static inline byte &Get(TileIndex t) { return _m[t].m4; } };
+struct Map5Field          { static inline byte &Get(TileIndex t) { return _m[t].m5; } };
+struct Map6Field          { static inline byte &Get(TileIndex t) { return _m[t].m6; } };
+struct Map7Field          { static inline byte &Get(TileIndex t) { return _me[t].m7; } };
+
+/**
+ * Encoding of a byte sized field of the tiles in the map chunks.
+ * @tparam G The accessor of the field.
+ */
+template <class G>
+struct MapByteCoding {
+	static const uint SIZE = 1; ///< Number of bytes of a tile in the chunk.
+	static inline void Decode(TileIndex t, const byte *p) { G::Get(t) = p[0]; }
+	static inline void Encode(TileIndex t, byte *p) { p[0] = G::Get(t); }
+};
+
+/** Encoding of the m2 of the tiles in the map chunks; big endian. */
+struct Map2Coding {
+	static const uint SIZE = 2; ///< Number of bytes of a tile in the chunk.
+	static inline void Decode(TileIndex t, const byte *p) { _m[t].m2 = p[0] << 8 | p[1]; }
+	static inline void Encode(TileIndex t, byte *p) { p[0] = GB(_m[t].m2, 8, 8); p[1] = GB(_m[t].m2, 0, 8); }
+};
+
+/**
+ * Decode a field of all tiles from the data of its map chunk.
+ * @param data The data of the chunk.
+ * @param len The length of the data.
+ * @tparam C The encoding of the field.
+ */
+template <class C>
+static void DecodeMapField(const byte *data, size_t len)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
+	assert(len == size * C::SIZE);
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].type_height = buf[j];
-	}
+	for (TileIndex t = 0; t != size; t++, data += C::SIZE) C::Decode(t, data);
 }
 
-static void Save_MAPT()
+/**
+ * Load a field of all tiles. Each map chunk only touches its own field, so
+ * it is decoded by a thread of its own while the next chunks are read.
+ * @tparam C The encoding of the field.
+ */
+template <class C>
+static void LoadMapField()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	if (SlGetFieldLength() != MapSize() * C::SIZE) SlErrorCorrupt("Invalid map chunk size");
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].type_height;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SlLoadConcurrently(&DecodeMapField<C>);
 }
 
-static void Load_MAP1()
+/**
+ * Save a field of all tiles, straight into the savegame buffer.
+ * @tparam C The encoding of the field.
+ */
+template <class C>
+static void SaveMapField()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
+	SlSetLength(size * C::SIZE);
 	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m1 = buf[j];
+		size_t len;
+		byte *buf = SlGetWriteSpan(&len);
+		TileIndex count = (TileIndex)min<size_t>(len / C::SIZE, size - i);
+
+		if (count == 0) {
+			/* The span ends within the data of this tile. */
+			byte data[C::SIZE];
+			C::Encode(i++, data);
+			for (uint j = 0; j != C::SIZE; j++) SlWriteByte(data[j]);
+			continue;
+		}
+
+		for (TileIndex j = 0; j != count; j++) C::Encode(i + j, buf + j * C::SIZE);
+		SlCommitWriteSpan(count * C::SIZE);
+		i += count;
 	}
 }
 
-static void Save_MAP1()
+static void Load_MAPT()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	LoadMapField<MapByteCoding<MapTypeHeightField> >();
+}
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m1;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+static void Save_MAPT()
+{
+	SaveMapField<MapByteCoding<MapTypeHeightField> >();
+}
+
+static void Load_MAP1()
+{
+	LoadMapField<MapByteCoding<Map1Field> >();
+}
+
+static void Save_MAP1()
+{
+	SaveMapField<MapByteCoding<Map1Field> >();
 }
 
 static void Load_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
+	if (IsSavegameVersionBefore(5)) {
+		/* In those versions the m2 was 8 bits */
+		SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
+		TileIndex size = MapSize();
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE,
-			/* In those versions the m2 was 8 bits */
-			IsSavegameVersionBefore(5) ? SLE_FILE_U8 | SLE_VAR_U16 : SLE_UINT16
-		);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m2 = buf[j];
+		for (TileIndex i = 0; i != size;) {
+			SlArray(buf, MAP_SL_BUF_SIZE, SLE_FILE_U8 | SLE_VAR_U16);
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m2 = buf[j];
+		}
+		return;
 	}
+
+	LoadMapField<Map2Coding>();
 }
 
 static void Save_MAP2()
 {
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size * sizeof(uint16));
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m2;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT16);
-	}
+	SaveMapField<Map2Coding>();
 }
 
 static void Load_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m3 = buf[j];
-	}
+	LoadMapField<MapByteCoding<Map3Field> >();
 }
 
 static void Save_MAP3()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m3;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField<MapByteCoding<Map3Field> >();
 }
 
 static void Load_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m4 = buf[j];
-	}
+	LoadMapField<MapByteCoding<Map4Field> >();
 }
 
 static void Save_MAP4()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m4;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField<MapByteCoding<Map4Field> >();
 }
 
 static void Load_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m5 = buf[j];
-	}
+	LoadMapField<MapByteCoding<Map5Field> >();
 }
 
 static void Save_MAP5()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m5;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField<MapByteCoding<Map5Field> >();
 }
 
 static void Load_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
 	if (IsSavegameVersionBefore(42)) {
+		SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
+		TileIndex size = MapSize();
+
 		for (TileIndex i = 0; i != size;) {
 			/* 1024, otherwise we overflow on 64x64 maps! */
 			SlArray(buf, 1024, SLE_UINT8);
@@ -205,56 +224,33 @@ static void Load_MAP6()
 			}
 		}
 	} else {
-		for (TileIndex i = 0; i != size;) {
-			SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].m6 = buf[j];
-		}
+		LoadMapField<MapByteCoding<Map6Field> >();
 	}
 }
 
 static void Save_MAP6()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m6;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField<MapByteCoding<Map6Field> >();
 }
 
 static void Load_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _me[i++].m7 = buf[j];
-	}
+	LoadMapField<MapByteCoding<Map7Field> >();
 }
 
 static void Save_MAP7()
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _me[i++].m7;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
+	SaveMapField<MapByteCoding<Map7Field> >();
 }
 
 extern const ChunkHandler _map_chunk_handlers[] = {
 	{ 'MAPS', Save_MAPS, Load_MAPS, NULL, Check_MAPS, CH_RIFF },
-	{ 'MAPT', Save_MAPT, Load_MAPT, NULL, NULL,       CH_RIFF },
-	{ 'MAPO', Save_MAP1, Load_MAP1, NULL, NULL,       CH_RIFF },
-	{ 'MAP2', Save_MAP2, Load_MAP2, NULL, NULL,       CH_RIFF },
-	{ 'M3LO', Save_MAP3, Load_MAP3, NULL, NULL,       CH_RIFF },
-	{ 'M3HI', Save_MAP4, Load_MAP4, NULL, NULL,       CH_RIFF },
-	{ 'MAP5', Save_MAP5, Load_MAP5, NULL, NULL,       CH_RIFF },
-	{ 'MAPE', Save_MAP6, Load_MAP6, NULL, NULL,       CH_RIFF },
-	{ 'MAP7', Save_MAP7, Load_MAP7, NULL, NULL,       CH_RIFF | CH_LAST },
+	{ 'MAPT', Save_MAPT, Load_MAPT, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'MAPO', Save_MAP1, Load_MAP1, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'MAP2', Save_MAP2, Load_MAP2, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'M3LO', Save_MAP3, Load_MAP3, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'M3HI', Save_MAP4, Load_MAP4, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'MAP5', Save_MAP5, Load_MAP5, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'MAPE', Save_MAP6, Load_MAP6, NULL, NULL,       CH_RIFF | CH_CONCURRENT },
+	{ 'MAP7', Save_MAP7, Load_MAP7, NULL, NULL,       CH_RIFF | CH_CONCURRENT | CH_LAST },
 };
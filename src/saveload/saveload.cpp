@@ -25,8 +25,10 @@
 #include "../debug.h"
 #include "../station_base.h"
 #include "../thread/thread.h"
+#include "../thread/thread_pool.h"
 #include "../town.h"
 #include "../network/network.h"
+#include "../network/network_func.h"
 #include "../window_func.h"
 #include "../strings_func.h"
 #include "../core/endian_func.hpp"
@@ -37,15 +39,30 @@
 #include "../roadstop_base.h"
 #include "../statusbar_gui.h"
 #include "../fileio_func.h"
+#include "../3rdparty/md5/md5.h"
 #include "../gamelog.h"
 #include "../string_func.h"
 #include "../fios.h"
 #include "../error.h"
+#include "../newgrf_config.h"
 
 #include "table/strings.h"
 
 #include "saveload_internal.h"
 #include "saveload_filter.h"
+#include "saveload_profile.h"
+
+#if defined(UNIX) && !defined(__MORPHOS__)
+/* A snapshot of the game can be taken by forking the process. */
+#	define WITH_SAVE_SNAPSHOT
+/* Savegames can be read by mapping them into memory. */
+#	define WITH_MAPPED_LOAD
+#	include <errno.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/wait.h>
+#endif
 
 /*
  * Previous savegame versions, the trunk revision where they were
@@ -239,7 +256,7 @@
  *  173   23967   1.2.0-RC1
  *  174   23973   1.2.x
  */
-extern const uint16 SAVEGAME_VERSION = SL_EXT_RATING; ///< Current savegame version of OpenTTD.
+extern const uint16 SAVEGAME_VERSION = SL_COMPACT_LINKGRAPH; ///< Current savegame version of OpenTTD.
 
 SavegameType _savegame_type; ///< type of savegame we are loading
 
@@ -249,6 +266,9 @@ byte   _sl_minor_version; ///< the minor savegame version, DO NOT USE!
 char _savegame_format[8]; ///< how to compress savegames
 bool _do_autosave;        ///< are we doing an autosave at the moment?
 
+bool _savegame_profiling;          ///< Whether to profile the saving and loading of savegames.
+SaveLoadProfile _savegame_profile; ///< Profile of the last savegame saved or loaded while profiling.
+
 /** What are we currently doing? */
 enum SaveLoadAction {
 	SLA_LOAD,        ///< loading
@@ -269,9 +289,9 @@ static const size_t MEMORY_CHUNK_SIZE = 128 * 1024;
 
 /** A buffer for reading (and buffering) savegame data. */
 struct ReadBuffer {
-	byte buf[MEMORY_CHUNK_SIZE]; ///< Buffer we're going to read from.
-	byte *bufp;                  ///< Location we're at reading the buffer.
-	byte *bufe;                  ///< End of the buffer we can read from.
+	byte buf[MEMORY_CHUNK_SIZE]; ///< Buffer we're going to read from, unless the filter can read in place.
+	const byte *bufp;            ///< Location we're at reading the buffer.
+	const byte *bufe;            ///< End of the buffer we can read from.
 	LoadFilter *reader;          ///< The filter used to actually read.
 	size_t read;                 ///< The amount of read bytes so far from the filter.
 
@@ -283,20 +303,56 @@ struct ReadBuffer {
 	{
 	}
 
-	inline byte ReadByte()
+	/**
+	 * Refill the buffer from the filter once everything in it is read. When
+	 * the filter has the data in memory already, the buffer is simply made to
+	 * point to that memory instead.
+	 */
+	inline void FillBuffer()
 	{
 		if (this->bufp == this->bufe) {
-			size_t len = this->reader->Read(this->buf, lengthof(this->buf));
+			size_t len = SIZE_MAX;
+			const byte *data = this->reader->ReadInPlace(&len);
+			if (data == NULL) {
+				len = this->reader->Read(this->buf, lengthof(this->buf));
+				data = this->buf;
+			}
 			if (len == 0) SlErrorCorrupt("Unexpected end of chunk");
 
 			this->read += len;
-			this->bufp = this->buf;
-			this->bufe = this->buf + len;
+			this->bufp = data;
+			this->bufe = data + len;
 		}
+	}
 
+	inline byte ReadByte()
+	{
+		this->FillBuffer();
 		return *this->bufp++;
 	}
 
+	/**
+	 * Get the unread part of the buffer, so it can be read directly.
+	 * @param len [out] The number of bytes that can be read; at least one.
+	 * @return The begin of the unread part.
+	 */
+	inline const byte *GetReadSpan(size_t *len)
+	{
+		this->FillBuffer();
+		*len = this->bufe - this->bufp;
+		return this->bufp;
+	}
+
+	/**
+	 * Mark the begin of the span returned by #GetReadSpan as read.
+	 * @param len The number of bytes that were read.
+	 */
+	inline void CommitReadSpan(size_t len)
+	{
+		assert(len <= (size_t)(this->bufe - this->bufp));
+		this->bufp += len;
+	}
+
 	/**
 	 * Get the size of the memory dump made so far.
 	 * @return The size.
@@ -319,11 +375,8 @@ struct MemoryDumper {
 	{
 	}
 
-	/**
-	 * Write a single byte into the dumper.
-	 * @param b The byte to write.
-	 */
-	inline void WriteByte(byte b)
+	/** Start a new block when the current one is full. */
+	inline void MakeSpace()
 	{
 		/* Are we at the end of this chunk? */
 		if (this->buf == this->bufe) {
@@ -331,10 +384,40 @@ struct MemoryDumper {
 			*this->blocks.Append() = this->buf;
 			this->bufe = this->buf + MEMORY_CHUNK_SIZE;
 		}
+	}
 
+	/**
+	 * Write a single byte into the dumper.
+	 * @param b The byte to write.
+	 */
+	inline void WriteByte(byte b)
+	{
+		this->MakeSpace();
 		*this->buf++ = b;
 	}
 
+	/**
+	 * Get the free part of the current block, so it can be written directly.
+	 * @param len [out] The number of bytes that can be written; at least one.
+	 * @return The begin of the free part.
+	 */
+	inline byte *GetWriteSpan(size_t *len)
+	{
+		this->MakeSpace();
+		*len = this->bufe - this->buf;
+		return this->buf;
+	}
+
+	/**
+	 * Mark the begin of the span returned by #GetWriteSpan as written.
+	 * @param len The number of bytes that were written.
+	 */
+	inline void CommitWriteSpan(size_t len)
+	{
+		assert(len <= (size_t)(this->bufe - this->buf));
+		this->buf += len;
+	}
+
 	/**
 	 * Flush this dumper into a writer.
 	 * @param writer The filter we want to use.
@@ -354,6 +437,40 @@ struct MemoryDumper {
 		writer->Finish();
 	}
 
+	/**
+	 * Write a part of this dumper into a writer, without finishing the writer.
+	 * @param writer The filter to write to.
+	 * @param begin  Offset of the first byte to write.
+	 * @param end    Offset after the last byte to write.
+	 */
+	void WriteRange(SaveFilter *writer, size_t begin, size_t end) const
+	{
+		while (begin < end) {
+			size_t offset = begin % MEMORY_CHUNK_SIZE;
+			size_t to_write = min(MEMORY_CHUNK_SIZE - offset, end - begin);
+
+			writer->Write(this->blocks[begin / MEMORY_CHUNK_SIZE] + offset, to_write);
+			begin += to_write;
+		}
+	}
+
+	/**
+	 * Add a part of this dumper to a checksum.
+	 * @param checksum The checksum to add to.
+	 * @param begin    Offset of the first byte to add.
+	 * @param end      Offset after the last byte to add.
+	 */
+	void HashRange(Md5 *checksum, size_t begin, size_t end) const
+	{
+		while (begin < end) {
+			size_t offset = begin % MEMORY_CHUNK_SIZE;
+			size_t to_hash = min(MEMORY_CHUNK_SIZE - offset, end - begin);
+
+			checksum->Append(this->blocks[begin / MEMORY_CHUNK_SIZE] + offset, to_hash);
+			begin += to_hash;
+		}
+	}
+
 	/**
 	 * Get the size of the memory dump made so far.
 	 * @return The size.
@@ -364,6 +481,21 @@ struct MemoryDumper {
 	}
 };
 
+/** How a savegame relates to incremental savegames. */
+enum IncrementalSaveMode {
+	ISM_NONE,      ///< A full savegame that is not used by incremental savegames.
+	ISM_BASE,      ///< A full savegame the following incremental savegames are made against.
+	ISM_INCREMENT, ///< An incremental savegame, only containing the changes since the base savegame.
+};
+
+/** Location of a chunk in the uncompressed savegame. */
+struct SavegameChunkRange {
+	uint32 id;       ///< Identifier of the chunk.
+	size_t begin;    ///< Offset of the chunk in the savegame.
+	size_t end;      ///< Offset after the end of the chunk in the savegame.
+	uint first_hash; ///< Index of the hash of the first block of the chunk; only used for the base savegame.
+};
+
 /** The saveload struct, containing reader-writer functions, buffer, version, etc. */
 struct SaveLoadParams {
 	SaveLoadAction action;               ///< are we doing a save or a load atm.
@@ -385,9 +517,13 @@ struct SaveLoadParams {
 
 	byte ff_state;                       ///< The state of fast-forward when saving started.
 	bool saveinprogress;                 ///< Whether there is currently a save in progress.
+
+	IncrementalSaveMode incremental;     ///< How the savegame that is being saved relates to incremental savegames.
 };
 
 static SaveLoadParams _sl; ///< Parameters used for/at saveload.
+static SmallVector<SavegameChunkRange, 64> _sl_chunks; ///< The chunks of the last saved savegame.
+static SmallVector<struct ChunkDecodeJob *, 16> _sl_decode_jobs; ///< The chunks that are decoded concurrently, see #SlLoadConcurrently.
 
 /* these define the chunks */
 extern const ChunkHandler _gamelog_chunk_handlers[];
@@ -535,6 +671,7 @@ void NORETURN SlErrorCorrupt(const char *msg)
 typedef void (*AsyncSaveFinishProc)();                ///< Callback for when the savegame loading is finished.
 static AsyncSaveFinishProc _async_save_finish = NULL; ///< Callback to call when the savegame loading is finished.
 static ThreadObject *_save_thread;                    ///< The thread we're using to compress and write a savegame
+static bool _save_snapshot_process = false;           ///< Whether this is the process writing a snapshot of the game.
 
 /**
  * Called by save thread to tell we finished saving.
@@ -548,11 +685,19 @@ static void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
 	_async_save_finish = proc;
 }
 
+#ifdef WITH_SAVE_SNAPSHOT
+static void ProcessSnapshotFinish();
+#endif
+
 /**
  * Handle async save finishes.
  */
 void ProcessAsyncSaveFinish()
 {
+#ifdef WITH_SAVE_SNAPSHOT
+	ProcessSnapshotFinish();
+#endif
+
 	if (_async_save_finish == NULL) return;
 
 	_async_save_finish();
@@ -584,14 +729,50 @@ void SlWriteByte(byte b)
 	_sl.dumper->WriteByte(b);
 }
 
+/**
+ * Get a part of the savegame buffer to write directly, instead of byte by
+ * byte with #SlWriteByte. Use #SlCommitWriteSpan to tell how much was written.
+ * @param len [out] The number of bytes that can be written; at least one.
+ * @return The begin of the buffer.
+ */
+byte *SlGetWriteSpan(size_t *len)
+{
+	return _sl.dumper->GetWriteSpan(len);
+}
+
+/**
+ * Mark the begin of the span returned by #SlGetWriteSpan as written.
+ * @param len The number of bytes that were written.
+ */
+void SlCommitWriteSpan(size_t len)
+{
+	_sl.dumper->CommitWriteSpan(len);
+}
+
 static inline int SlReadUint16()
 {
+	ReadBuffer *reader = _sl.reader;
+	if (reader->bufe - reader->bufp >= 2) {
+		/* Both bytes are in the buffer; no need to check for a refill per byte. */
+		const byte *p = reader->bufp;
+		reader->bufp += 2;
+		return p[0] << 8 | p[1];
+	}
+
 	int x = SlReadByte() << 8;
 	return x | SlReadByte();
 }
 
 static inline uint32 SlReadUint32()
 {
+	ReadBuffer *reader = _sl.reader;
+	if (reader->bufe - reader->bufp >= 4) {
+		/* All bytes are in the buffer; no need to check for a refill per byte. */
+		const byte *p = reader->bufp;
+		reader->bufp += 4;
+		return (uint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+	}
+
 	uint32 x = SlReadUint16() << 16;
 	return x | SlReadUint16();
 }
@@ -875,10 +1056,26 @@ static void SlCopyBytes(void *ptr, size_t length)
 	switch (_sl.action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD:
-			for (; length != 0; length--) *p++ = SlReadByte();
+			while (length != 0) {
+				size_t len;
+				const byte *buf = _sl.reader->GetReadSpan(&len);
+				len = min(len, length);
+				memcpy(p, buf, len);
+				_sl.reader->CommitReadSpan(len);
+				p += len;
+				length -= len;
+			}
 			break;
 		case SLA_SAVE:
-			for (; length != 0; length--) SlWriteByte(*p++);
+			while (length != 0) {
+				size_t len;
+				byte *buf = _sl.dumper->GetWriteSpan(&len);
+				len = min(len, length);
+				memcpy(buf, p, len);
+				_sl.dumper->CommitWriteSpan(len);
+				p += len;
+				length -= len;
+			}
 			break;
 		default: NOT_REACHED();
 	}
@@ -890,6 +1087,64 @@ size_t SlGetFieldLength()
 	return _sl.obj_len;
 }
 
+/** The data of a chunk that is decoded by a thread of its own. */
+struct ChunkDecodeJob {
+	ChunkDecodeProc *proc; ///< Function decoding the data.
+	byte *data;            ///< The data of the chunk, or \c NULL once it is decoded.
+	size_t len;            ///< Length of the data.
+	ThreadObject *thread;  ///< The thread decoding the data, or \c NULL when there is none.
+};
+
+/**
+ * Decode the data of a chunk and free it.
+ * @param arg The #ChunkDecodeJob.
+ */
+static void ChunkDecodeThread(void *arg)
+{
+	ChunkDecodeJob *job = (ChunkDecodeJob *)arg;
+	job->proc(job->data, job->len);
+	free(job->data);
+	job->data = NULL;
+}
+
+/**
+ * Read the data of the current RIFF chunk and leave decoding it to a thread
+ * of its own, so the next chunks are read while it is being decoded. This is
+ * only allowed from the load procedure of a chunk with #CH_CONCURRENT; the
+ * decoding must not touch anything but the data of this chunk.
+ * @param proc Function decoding the data of the chunk.
+ */
+void SlLoadConcurrently(ChunkDecodeProc *proc)
+{
+	assert(_sl.action == SLA_LOAD && (_sl.block_mode & 0xF) == CH_RIFF);
+
+	/* Register the job first, so the data is freed when reading it fails. */
+	ChunkDecodeJob *job = new ChunkDecodeJob;
+	job->proc = proc;
+	job->len = SlGetFieldLength();
+	job->data = MallocT<byte>(job->len);
+	job->thread = NULL;
+	*_sl_decode_jobs.Append() = job;
+
+	SlCopyBytes(job->data, job->len);
+	if (!ThreadObject::New(&ChunkDecodeThread, job, &job->thread)) ChunkDecodeThread(job);
+}
+
+/** Wait till all chunks that are decoded concurrently are done. */
+static void SlWaitForConcurrentChunks()
+{
+	for (ChunkDecodeJob **it = _sl_decode_jobs.Begin(); it != _sl_decode_jobs.End(); it++) {
+		ChunkDecodeJob *job = *it;
+		if (job->thread != NULL) {
+			job->thread->Join();
+			delete job->thread;
+		}
+		free(job->data);
+		delete job;
+	}
+	_sl_decode_jobs.Clear();
+}
+
 /**
  * Return a signed-long version of the value of a setting
  * @param ptr pointer to the variable
@@ -1712,11 +1967,65 @@ static void SlSaveChunk(const ChunkHandler *ch)
 	}
 }
 
+/**
+ * Clear the profile for a new savegame.
+ * @param save Whether the savegame is going to be saved, otherwise it is loaded.
+ */
+void SaveLoadProfile::Clear(bool save)
+{
+	this->save = save;
+	this->format = NULL;
+	this->chunks.Clear();
+	this->packed_size = 0;
+	this->write_us = 0;
+	this->fix_pointers_us = 0;
+	this->after_load_us = 0;
+}
+
+/**
+ * Save a chunk and add it to the profile.
+ * @param ch The chunkhandler of the chunk.
+ */
+static void SlProfileSaveChunk(const ChunkHandler *ch)
+{
+	size_t start = _sl.dumper->GetSize();
+
+	uint64 start_us = ottd_microseconds();
+	SlSaveChunk(ch);
+	uint32 time_us = (uint32)(ottd_microseconds() - start_us);
+
+	/* Chunks without save procedure are not in the savegame. */
+	if (_sl.dumper->GetSize() == start) return;
+
+	SaveLoadChunkProfile *profile = _savegame_profile.chunks.Append();
+	profile->id = ch->id;
+	profile->size = _sl.dumper->GetSize() - start;
+	profile->packed_size = 0;
+	profile->time_us = time_us;
+}
+
 /** Save all chunks */
 static void SlSaveChunks()
 {
+	_sl_chunks.Clear();
+
 	FOR_ALL_CHUNK_HANDLERS(ch) {
-		SlSaveChunk(ch);
+		size_t begin = _sl.dumper->GetSize();
+
+		if (_savegame_profiling) {
+			SlProfileSaveChunk(ch);
+		} else {
+			SlSaveChunk(ch);
+		}
+
+		/* Chunks without save procedure are not in the savegame. */
+		if (_sl.dumper->GetSize() == begin) continue;
+
+		SavegameChunkRange *range = _sl_chunks.Append();
+		range->id = ch->id;
+		range->begin = begin;
+		range->end = _sl.dumper->GetSize();
+		range->first_hash = 0;
 	}
 
 	/* Terminator */
@@ -1746,8 +2055,31 @@ static void SlLoadChunks()
 
 		ch = SlFindChunkHandler(id);
 		if (ch == NULL) SlErrorCorrupt("Unknown chunk type");
+
+		/* Other chunks may depend on the data of the concurrently decoded ones. */
+		if (!(ch->flags & CH_CONCURRENT)) SlWaitForConcurrentChunks();
+
+		if (!_savegame_profiling) {
+			SlLoadChunk(ch);
+			continue;
+		}
+
+		size_t start = _sl.reader->GetSize();
+
+		/* Include the decoding in the time of the chunk, by not letting it run alongside the next chunk. */
+		uint64 start_us = ottd_microseconds();
 		SlLoadChunk(ch);
+		SlWaitForConcurrentChunks();
+		uint32 time_us = (uint32)(ottd_microseconds() - start_us);
+
+		SaveLoadChunkProfile *profile = _savegame_profile.chunks.Append();
+		profile->id = id;
+		profile->size = _sl.reader->GetSize() - start + sizeof(id);
+		profile->packed_size = 0;
+		profile->time_us = time_us;
 	}
+
+	SlWaitForConcurrentChunks();
 }
 
 /** Load all chunks for savegame checking */
@@ -1823,6 +2155,106 @@ struct FileReader : LoadFilter {
 	}
 };
 
+#ifdef WITH_MAPPED_LOAD
+/**
+ * Reading from a file that is mapped into memory. The data is handed out in
+ * place, so it is not copied into the read buffer first, and the operating
+ * system reads ahead while the savegame is decoded.
+ */
+struct MappedFileReader : LoadFilter {
+	FILE *file;       ///< The file to read from.
+	const byte *data; ///< The mapping of the whole file.
+	size_t size;      ///< The size of the file.
+	size_t begin;     ///< The begin of the savegame in the file.
+	size_t pos;       ///< The position in the file to read from.
+
+	/**
+	 * Create the reader for a mapped file.
+	 * @param file The file to read from.
+	 * @param data The mapping of the whole file.
+	 * @param size The size of the file.
+	 */
+	MappedFileReader(FILE *file, const byte *data, size_t size) : LoadFilter(NULL), file(file), data(data), size(size), begin(ftell(file)), pos(begin)
+	{
+		if (this->begin > this->size) this->begin = this->pos = this->size;
+	}
+
+	/** Make sure everything is cleaned up. */
+	~MappedFileReader()
+	{
+		munmap(const_cast<byte *>(this->data), this->size);
+		fclose(this->file);
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size = min(size, this->size - this->pos);
+		memcpy(buf, this->data + this->pos, size);
+		this->pos += size;
+		return size;
+	}
+
+	/* virtual */ const byte *ReadInPlace(size_t *len)
+	{
+		if (this->pos == this->size) return NULL;
+
+		const byte *data = this->data + this->pos;
+		*len = min(*len, this->size - this->pos);
+		this->pos += *len;
+		return data;
+	}
+
+	/* virtual */ void Reset()
+	{
+		this->pos = this->begin;
+	}
+};
+#endif /* WITH_MAPPED_LOAD */
+
+/**
+ * Check whether a file is in one of the directories games are saved into.
+ * @param filename The full path of the file.
+ * @return True if the file is in a save or autosave directory.
+ */
+static bool IsInSaveDirectory(const char *filename)
+{
+	static const Subdirectory save_dirs[] = { SAVE_DIR, AUTOSAVE_DIR };
+
+	Searchpath sp;
+	FOR_ALL_SEARCHPATHS(sp) {
+		for (uint i = 0; i < lengthof(save_dirs); i++) {
+			char buf[MAX_PATH];
+			FioAppendDirectory(buf, lengthof(buf), sp, save_dirs[i]);
+			if (strncmp(filename, buf, strlen(buf)) == 0) return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Create the filter for reading a savegame from a file. When allowed and
+ * possible the file is mapped into memory, otherwise it is read with stdio.
+ * A savegame that is written while it is mapped makes reading the mapping
+ * fail with SIGBUS, so files games are saved into must not be mapped.
+ * @param file The file to read from.
+ * @param map Whether the file may be mapped into memory.
+ * @return The filter.
+ */
+static LoadFilter *CreateFileReader(FILE *file, bool map)
+{
+#ifdef WITH_MAPPED_LOAD
+	struct stat st;
+	if (map && fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (off_t)(size_t)st.st_size == st.st_size) {
+		void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+		if (data != MAP_FAILED) {
+			madvise(data, st.st_size, MADV_SEQUENTIAL);
+			return new MappedFileReader(file, (const byte *)data, st.st_size);
+		}
+	}
+#endif
+	return new FileReader(file);
+}
+
 /** Yes, simply writing to a file. */
 struct FileWriter : SaveFilter {
 	FILE *file; ///< The file to write to.
@@ -1859,6 +2291,54 @@ struct FileWriter : SaveFilter {
 	}
 };
 
+/** Filter counting the bytes that are read from the savegame, for the profile. */
+struct CountingLoadFilter : LoadFilter {
+	size_t *count; ///< The counter to add the read bytes to.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 * @param count The counter to add the read bytes to.
+	 */
+	CountingLoadFilter(LoadFilter *chain, size_t *count) : LoadFilter(chain), count(count)
+	{
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size_t len = this->chain->Read(buf, size);
+		*this->count += len;
+		return len;
+	}
+
+	/* virtual */ const byte *ReadInPlace(size_t *len)
+	{
+		const byte *buf = this->chain->ReadInPlace(len);
+		if (buf != NULL) *this->count += *len;
+		return buf;
+	}
+};
+
+/** Filter counting the bytes that are written to the savegame, for the profile. */
+struct CountingSaveFilter : SaveFilter {
+	size_t *count; ///< The counter to add the written bytes to.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain, or \c NULL to only count the bytes.
+	 * @param count The counter to add the written bytes to.
+	 */
+	CountingSaveFilter(SaveFilter *chain, size_t *count) : SaveFilter(chain), count(count)
+	{
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		*this->count += size;
+		if (this->chain != NULL) this->chain->Write(buf, size);
+	}
+};
+
 /*******************************************
  ********** START OF LZO CODE **************
  *******************************************/
@@ -1970,6 +2450,11 @@ struct NoCompLoadFilter : LoadFilter {
 	{
 		return this->chain->Read(buf, size);
 	}
+
+	/* virtual */ const byte *ReadInPlace(size_t *len)
+	{
+		return this->chain->ReadInPlace(len);
+	}
 };
 
 /** Filter without any compression. */
@@ -2106,6 +2591,12 @@ struct ZlibSaveFilter : SaveFilter {
 		this->WriteLoop(NULL, 0, Z_FINISH);
 		this->chain->Finish();
 	}
+
+	/* virtual */ void Reset()
+	{
+		if (deflateReset(&this->z) != Z_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
+		this->chain->Reset();
+	}
 };
 
 #endif /* WITH_ZLIB */
@@ -2171,15 +2662,16 @@ struct LZMALoadFilter : LoadFilter {
 /** Filter using LZMA compression. */
 struct LZMASaveFilter : SaveFilter {
 	lzma_stream lzma; ///< Stream state that we are writing to.
+	uint32 preset;    ///< Compression level of the stream.
 
 	/**
 	 * Initialise this filter.
 	 * @param chain             The next filter in this chain.
 	 * @param compression_level The requested level of compression.
 	 */
-	LZMASaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), lzma(_lzma_init)
+	LZMASaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), lzma(_lzma_init), preset(compression_level)
 	{
-		if (lzma_easy_encoder(&this->lzma, compression_level, LZMA_CHECK_CRC32) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
+		if (lzma_easy_encoder(&this->lzma, this->preset, LZMA_CHECK_CRC32) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
 	}
 
 	/** Clean up what we allocated. */
@@ -2225,63 +2717,383 @@ struct LZMASaveFilter : SaveFilter {
 		this->WriteLoop(NULL, 0, LZMA_FINISH);
 		this->chain->Finish();
 	}
-};
-
-#endif /* WITH_LZMA */
-
-/*******************************************
- ************* END OF CODE *****************
- *******************************************/
-
-/** The format for a reader/writer type of a savegame */
-struct SaveLoadFormat {
-	const char *name;                     ///< name of the compressor/decompressor (debug-only)
-	uint32 tag;                           ///< the 4-letter tag by which it is identified in the savegame
 
-	LoadFilter *(*init_load)(LoadFilter *chain);                    ///< Constructor for the load filter.
-	SaveFilter *(*init_write)(SaveFilter *chain, byte compression); ///< Constructor for the save filter.
-
-	byte min_compression;                 ///< the minimum compression level of this format
-	byte default_compression;             ///< the default compression level of this format
-	byte max_compression;                 ///< the maximum compression level of this format
+	/* virtual */ void Reset()
+	{
+		/* Initialising the stream again reuses what it allocated already. */
+		if (lzma_easy_encoder(&this->lzma, this->preset, LZMA_CHECK_CRC32) != LZMA_OK) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "cannot initialize compressor");
+		this->chain->Reset();
+	}
 };
 
-/** The different saveload formats known/understood by OpenTTD. */
-static const SaveLoadFormat _saveload_formats[] = {
-#if defined(WITH_LZO)
-	/* Roughly 75% larger than zlib level 6 at only ~7% of the CPU usage. */
-	{"lzo",    TO_BE32X('OTTD'), CreateLoadFilter<LZOLoadFilter>,    CreateSaveFilter<LZOSaveFilter>,    0, 0, 0},
-#else
-	{"lzo",    TO_BE32X('OTTD'), NULL,                               NULL,                               0, 0, 0},
-#endif
-	/* Roughly 5 times larger at only 1% of the CPU usage over zlib level 6. */
-	{"none",   TO_BE32X('OTTN'), CreateLoadFilter<NoCompLoadFilter>, CreateSaveFilter<NoCompSaveFilter>, 0, 0, 0},
-#if defined(WITH_ZLIB)
-	/* After level 6 the speed reduction is significant (1.5x to 2.5x slower per level), but the reduction in filesize is
-	 * fairly insignificant (~1% for each step). Lower levels become ~5-10% bigger by each level than level 6 while level
-	 * 1 is "only" 3 times as fast. Level 0 results in uncompressed savegames at about 8 times the cost of "none". */
-	{"zlib",   TO_BE32X('OTTZ'), CreateLoadFilter<ZlibLoadFilter>,   CreateSaveFilter<ZlibSaveFilter>,   0, 6, 9},
-#else
-	{"zlib",   TO_BE32X('OTTZ'), NULL,                               NULL,                               0, 0, 0},
-#endif
-#if defined(WITH_LZMA)
-	/* Level 2 compression is speed wise as fast as zlib level 6 compression (old default), but results in ~10% smaller saves.
-	 * Higher compression levels are possible, and might improve savegame size by up to 25%, but are also up to 10 times slower.
-	 * The next significant reduction in file size is at level 4, but that is already 4 times slower. Level 3 is primarily 50%
-	 * slower while not improving the filesize, while level 0 and 1 are faster, but don't reduce savegame size much.
-	 * It's OTTX and not e.g. OTTL because liblzma is part of xz-utils and .tar.xz is prefered over .tar.lzma. */
-	{"lzma",   TO_BE32X('OTTX'), CreateLoadFilter<LZMALoadFilter>,   CreateSaveFilter<LZMASaveFilter>,   0, 2, 9},
-#else
-	{"lzma",   TO_BE32X('OTTX'), NULL,                               NULL,                               0, 0, 0},
-#endif
+/**
+ * Number of bytes of savegame data in one frame of the framed LZMA format.
+ * Every frame is compressed on its own, so the frames can be compressed and
+ * decompressed by several threads at the same time.
+ */
+static const size_t LZMA_FRAME_SIZE = 8 * MEMORY_CHUNK_SIZE;
+
+/** A frame of the framed LZMA format while it is (de)compressed. */
+struct LZMAFrame {
+	byte *data;         ///< The uncompressed data of the frame.
+	size_t size;        ///< Number of bytes in #data.
+	byte *packed;       ///< The compressed data of the frame.
+	size_t packed_size; ///< Number of bytes in #packed.
+	uint32 preset;      ///< Compression level to compress the frame with.
+	bool failed;        ///< Whether liblzma could not (de)compress the frame.
 };
 
 /**
- * Return the savegameformat of the game. Whether it was created with ZLIB compression
- * uncompressed, or another type
- * @param s Name of the savegame format. If NULL it picks the first available one
- * @param compression_level Output for telling what compression level we want.
- * @return Pointer to SaveLoadFormat struct giving all characteristics of this type of savegame
+ * Get the pool for (de)compressing the frames. It is shared by all savegames,
+ * as only one savegame is saved or loaded at a time. It is not the shared pool
+ * of the game, as the savegame may be written by the savegame thread while the
+ * main thread uses that one.
+ * @return The pool.
+ */
+static ThreadPool *GetLZMAFramePool()
+{
+	/* The workers of the pool are not copied into a snapshot process, and the locks of the pool may be held by them. */
+	static ThreadPool *snapshot_pool = NULL;
+	if (_save_snapshot_process) {
+		if (snapshot_pool == NULL) snapshot_pool = new ThreadPool(0);
+		return snapshot_pool;
+	}
+
+	static ThreadPool *pool = NULL;
+	if (pool == NULL) {
+		uint cores = GetCPUCoreCount();
+		pool = new ThreadPool(cores > 1 ? cores - 1 : 0);
+	}
+	return pool;
+}
+
+/**
+ * Get the number of frames that are (de)compressed at once.
+ * @return The number of frames in a batch.
+ */
+static uint GetLZMAFrameBatchSize()
+{
+	return (GetLZMAFramePool()->GetWorkerCount() + 1) * 2;
+}
+
+/**
+ * Compress a frame; job of the thread pool.
+ * @param item The #LZMAFrame to compress.
+ */
+static void CompressLZMAFrame(void *item)
+{
+	LZMAFrame *frame = (LZMAFrame *)item;
+
+	frame->packed_size = 0;
+	frame->failed = lzma_easy_buffer_encode(frame->preset, LZMA_CHECK_CRC32, NULL, frame->data, frame->size, frame->packed, &frame->packed_size, lzma_stream_buffer_bound(LZMA_FRAME_SIZE)) != LZMA_OK;
+}
+
+/**
+ * Decompress a frame; job of the thread pool.
+ * @param item The #LZMAFrame to decompress.
+ */
+static void DecompressLZMAFrame(void *item)
+{
+	LZMAFrame *frame = (LZMAFrame *)item;
+
+	uint64_t memlimit = 1 << 28;
+	size_t in_pos = 0;
+	size_t out_pos = 0;
+	lzma_ret r = lzma_stream_buffer_decode(&memlimit, 0, NULL, frame->packed, &in_pos, frame->packed_size, frame->data, &out_pos, frame->size);
+	frame->failed = r != LZMA_OK || in_pos != frame->packed_size || out_pos != frame->size;
+}
+
+/**
+ * Allocate the buffers of a batch of frames.
+ * @param count Number of frames in the batch.
+ * @return The frames.
+ */
+static LZMAFrame *AllocateLZMAFrames(uint count)
+{
+	LZMAFrame *frames = CallocT<LZMAFrame>(count);
+	for (uint i = 0; i < count; i++) {
+		frames[i].data = MallocT<byte>(LZMA_FRAME_SIZE);
+		frames[i].packed = MallocT<byte>(lzma_stream_buffer_bound(LZMA_FRAME_SIZE));
+	}
+	return frames;
+}
+
+/**
+ * Free the buffers of a batch of frames.
+ * @param frames The frames.
+ * @param count  Number of frames in the batch.
+ */
+static void FreeLZMAFrames(LZMAFrame *frames, uint count)
+{
+	for (uint i = 0; i < count; i++) {
+		free(frames[i].data);
+		free(frames[i].packed);
+	}
+	free(frames);
+}
+
+/**
+ * Filter reading the framed LZMA format. Every frame is preceded by its entry
+ * of the frame index: its compressed and uncompressed size. With these, a batch
+ * of frames is read ahead and decompressed in parallel before the savegame data
+ * of these frames is needed. An entry with both sizes zero ends the savegame.
+ */
+struct LZMAFramedLoadFilter : LoadFilter {
+	LZMAFrame *batch;   ///< The frames of the current batch.
+	uint batch_size;    ///< Maximum number of frames in a batch.
+	uint batch_count;   ///< Number of frames in the current batch.
+	uint current;       ///< Frame of the current batch that is being read.
+	size_t pos;         ///< Position in the data of the current frame.
+	bool end;           ///< Whether the end of the frames has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	LZMAFramedLoadFilter(LoadFilter *chain) : LoadFilter(chain), batch_count(0), current(0), pos(0), end(false)
+	{
+		this->batch_size = GetLZMAFrameBatchSize();
+		this->batch = AllocateLZMAFrames(this->batch_size);
+	}
+
+	/** Clean everything up. */
+	~LZMAFramedLoadFilter()
+	{
+		FreeLZMAFrames(this->batch, this->batch_size);
+	}
+
+	/** Read the next batch of frames from the chain and decompress them. */
+	void ReadBatch()
+	{
+		void **items = AllocaM(void *, this->batch_size);
+		size_t max_packed = lzma_stream_buffer_bound(LZMA_FRAME_SIZE);
+
+		this->batch_count = 0;
+		while (this->batch_count < this->batch_size && !this->end) {
+			uint32 sizes[2];
+			if (this->chain->Read((byte *)sizes, sizeof(sizes)) != sizeof(sizes)) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+
+			LZMAFrame *frame = &this->batch[this->batch_count];
+			frame->packed_size = FROM_BE32(sizes[0]);
+			frame->size = FROM_BE32(sizes[1]);
+			if (frame->packed_size == 0 && frame->size == 0) {
+				this->end = true;
+				break;
+			}
+			if (frame->packed_size == 0 || frame->packed_size > max_packed || frame->size == 0 || frame->size > LZMA_FRAME_SIZE) SlErrorCorrupt("Inconsistent frame size");
+			if (this->chain->Read(frame->packed, frame->packed_size) != frame->packed_size) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+
+			items[this->batch_count++] = frame;
+		}
+
+		GetLZMAFramePool()->Run(&DecompressLZMAFrame, items, this->batch_count);
+
+		for (uint i = 0; i < this->batch_count; i++) {
+			if (this->batch[i].failed) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "liblzma returned error code");
+		}
+		this->current = 0;
+		this->pos = 0;
+	}
+
+	/* virtual */ const byte *ReadInPlace(size_t *len)
+	{
+		if (this->current == this->batch_count) {
+			if (this->end) return NULL;
+			this->ReadBatch();
+			if (this->batch_count == 0) return NULL;
+		}
+
+		/* Hand out the rest of the current frame, straight from the decompressed data. */
+		const LZMAFrame *frame = &this->batch[this->current];
+		const byte *data = frame->data + this->pos;
+		*len = min(*len, frame->size - this->pos);
+		this->pos += *len;
+
+		if (this->pos == frame->size) {
+			this->current++;
+			this->pos = 0;
+		}
+		return data;
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size_t read = 0;
+		while (read < size) {
+			if (this->current == this->batch_count) {
+				if (this->end) break;
+				this->ReadBatch();
+				continue;
+			}
+
+			const LZMAFrame *frame = &this->batch[this->current];
+			size_t len = min(size - read, frame->size - this->pos);
+			memcpy(buf + read, frame->data + this->pos, len);
+			read += len;
+			this->pos += len;
+
+			if (this->pos == frame->size) {
+				this->current++;
+				this->pos = 0;
+			}
+		}
+
+		return read;
+	}
+};
+
+/**
+ * Filter writing the framed LZMA format. The savegame data is cut into frames
+ * which are compressed in parallel batches. As soon as a batch is compressed,
+ * its frames are written in order, each preceded by its entry of the frame
+ * index, so only one batch is kept in memory.
+ */
+struct LZMAFramedSaveFilter : SaveFilter {
+	LZMAFrame *batch;   ///< The frames of the current batch.
+	uint batch_size;    ///< Maximum number of frames in a batch.
+	uint batch_count;   ///< Number of frames in the current batch; the last one may be partially filled.
+	uint32 preset;      ///< Compression level of the frames.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	LZMAFramedSaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), batch_count(0), preset(compression_level)
+	{
+		this->batch_size = GetLZMAFrameBatchSize();
+		this->batch = AllocateLZMAFrames(this->batch_size);
+	}
+
+	/** Clean up what we allocated. */
+	~LZMAFramedSaveFilter()
+	{
+		FreeLZMAFrames(this->batch, this->batch_size);
+	}
+
+	/** Compress the frames of the current batch and write them to the chain. */
+	void WriteBatch()
+	{
+		void **items = AllocaM(void *, this->batch_count);
+		for (uint i = 0; i < this->batch_count; i++) items[i] = &this->batch[i];
+
+		GetLZMAFramePool()->Run(&CompressLZMAFrame, items, this->batch_count);
+
+		for (uint i = 0; i < this->batch_count; i++) {
+			const LZMAFrame *frame = &this->batch[i];
+			if (frame->failed) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "liblzma returned error code");
+
+			uint32 sizes[2] = { TO_BE32((uint32)frame->packed_size), TO_BE32((uint32)frame->size) };
+			this->chain->Write((byte *)sizes, sizeof(sizes));
+			this->chain->Write(frame->packed, frame->packed_size);
+		}
+		this->batch_count = 0;
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		while (size > 0) {
+			LZMAFrame *frame = this->batch_count == 0 ? NULL : &this->batch[this->batch_count - 1];
+			if (frame == NULL || frame->size == LZMA_FRAME_SIZE) {
+				if (this->batch_count == this->batch_size) this->WriteBatch();
+
+				frame = &this->batch[this->batch_count++];
+				frame->size = 0;
+				frame->preset = this->preset;
+			}
+
+			size_t len = min(size, LZMA_FRAME_SIZE - frame->size);
+			memcpy(frame->data + frame->size, buf, len);
+			frame->size += len;
+			buf += len;
+			size -= len;
+		}
+	}
+
+	/* virtual */ void Finish()
+	{
+		this->WriteBatch();
+
+		/* The end of the frames. */
+		uint32 sizes[2] = { 0, 0 };
+		this->chain->Write((byte *)sizes, sizeof(sizes));
+
+		this->chain->Finish();
+	}
+
+	/* virtual */ void Reset()
+	{
+		this->batch_count = 0;
+		this->chain->Reset();
+	}
+};
+
+#endif /* WITH_LZMA */
+
+/*******************************************
+ ************* END OF CODE *****************
+ *******************************************/
+
+static LoadFilter *CreateIncrementalLoadFilter(LoadFilter *chain);
+
+/** The format for a reader/writer type of a savegame */
+struct SaveLoadFormat {
+	const char *name;                     ///< name of the compressor/decompressor (debug-only)
+	uint32 tag;                           ///< the 4-letter tag by which it is identified in the savegame
+
+	LoadFilter *(*init_load)(LoadFilter *chain);                    ///< Constructor for the load filter.
+	SaveFilter *(*init_write)(SaveFilter *chain, byte compression); ///< Constructor for the save filter.
+
+	byte min_compression;                 ///< the minimum compression level of this format
+	byte default_compression;             ///< the default compression level of this format
+	byte max_compression;                 ///< the maximum compression level of this format
+};
+
+/** The different saveload formats known/understood by OpenTTD. */
+static const SaveLoadFormat _saveload_formats[] = {
+#if defined(WITH_LZO)
+	/* Roughly 75% larger than zlib level 6 at only ~7% of the CPU usage. */
+	{"lzo",    TO_BE32X('OTTD'), CreateLoadFilter<LZOLoadFilter>,    CreateSaveFilter<LZOSaveFilter>,    0, 0, 0},
+#else
+	{"lzo",    TO_BE32X('OTTD'), NULL,                               NULL,                               0, 0, 0},
+#endif
+	/* Roughly 5 times larger at only 1% of the CPU usage over zlib level 6. */
+	{"none",   TO_BE32X('OTTN'), CreateLoadFilter<NoCompLoadFilter>, CreateSaveFilter<NoCompSaveFilter>, 0, 0, 0},
+#if defined(WITH_ZLIB)
+	/* After level 6 the speed reduction is significant (1.5x to 2.5x slower per level), but the reduction in filesize is
+	 * fairly insignificant (~1% for each step). Lower levels become ~5-10% bigger by each level than level 6 while level
+	 * 1 is "only" 3 times as fast. Level 0 results in uncompressed savegames at about 8 times the cost of "none". */
+	{"zlib",   TO_BE32X('OTTZ'), CreateLoadFilter<ZlibLoadFilter>,   CreateSaveFilter<ZlibSaveFilter>,   0, 6, 9},
+#else
+	{"zlib",   TO_BE32X('OTTZ'), NULL,                               NULL,                               0, 0, 0},
+#endif
+#if defined(WITH_LZMA)
+	/* The same as lzma below, but the data is cut into frames of 1 MB that are compressed independently. That makes the
+	 * savegame ~2% larger, but (de)compressing it is spread over all processor cores. */
+	{"plzma",  TO_BE32X('OTTP'), CreateLoadFilter<LZMAFramedLoadFilter>, CreateSaveFilter<LZMAFramedSaveFilter>, 0, 2, 9},
+#else
+	{"plzma",  TO_BE32X('OTTP'), NULL,                               NULL,                               0, 0, 0},
+#endif
+#if defined(WITH_LZMA)
+	/* Level 2 compression is speed wise as fast as zlib level 6 compression (old default), but results in ~10% smaller saves.
+	 * Higher compression levels are possible, and might improve savegame size by up to 25%, but are also up to 10 times slower.
+	 * The next significant reduction in file size is at level 4, but that is already 4 times slower. Level 3 is primarily 50%
+	 * slower while not improving the filesize, while level 0 and 1 are faster, but don't reduce savegame size much.
+	 * It's OTTX and not e.g. OTTL because liblzma is part of xz-utils and .tar.xz is prefered over .tar.lzma. */
+	{"lzma",   TO_BE32X('OTTX'), CreateLoadFilter<LZMALoadFilter>,   CreateSaveFilter<LZMASaveFilter>,   0, 2, 9},
+#else
+	{"lzma",   TO_BE32X('OTTX'), NULL,                               NULL,                               0, 0, 0},
+#endif
+	/* Only the changes to a full savegame, compressed with one of the formats above. Only made by autosaves. */
+	{"delta",  TO_BE32X('OTTI'), CreateIncrementalLoadFilter,        NULL,                               0, 0, 0},
+};
+
+/**
+ * Return the savegameformat of the game. Whether it was created with ZLIB compression
+ * uncompressed, or another type
+ * @param s Name of the savegame format. If NULL it picks the first available one
+ * @param compression_level Output for telling what compression level we want.
+ * @return Pointer to SaveLoadFormat struct giving all characteristics of this type of savegame
  */
 static const SaveLoadFormat *GetSavegameFormat(char *s, byte *compression_level)
 {
@@ -2330,6 +3142,479 @@ static const SaveLoadFormat *GetSavegameFormat(char *s, byte *compression_level)
 	return def;
 }
 
+/********************************************
+ ******** START OF INCREMENTAL CODE *********
+ ********************************************/
+
+/** Size of the blocks of the chunks that are compared to find the changes for an incremental savegame. */
+static const size_t INCREMENTAL_BLOCK_SIZE = 1024;
+
+/** Operations of an incremental savegame, which describe the savegame in terms of its base savegame. */
+enum IncrementalOperation {
+	IO_COPY   = 'C', ///< Copy a part of the base savegame; followed by the offset (uint64) and the length (uint32).
+	IO_INSERT = 'I', ///< Insert new data; followed by the length (uint32) and the data.
+	IO_END    = 'E', ///< End of the savegame.
+};
+
+/** Checksum of a block of a chunk of the base savegame. */
+struct IncrementalBlockHash {
+	uint8 digest[16]; ///< MD5 of the block.
+};
+
+/** The full savegame the incremental savegames are made against. */
+struct IncrementalBase {
+	char name[MAX_PATH];                             ///< File name of the savegame without directory, or empty when there is no base savegame.
+	uint increments;                                 ///< Number of incremental savegames that were made against it.
+	size_t file_size;                                ///< Size of the savegame file as written to disk.
+	uint8 file_digest[16];                           ///< MD5 of the savegame file as written to disk.
+	SmallVector<SavegameChunkRange, 64> chunks;      ///< The chunks of the savegame.
+	SmallVector<IncrementalBlockHash, 256> hashes;   ///< MD5 of all blocks of all chunks.
+};
+
+static IncrementalBase _incremental_base;   ///< The base of the incremental savegames.
+static char _incremental_name[MAX_PATH];    ///< File name, without directory, of the savegame that is being saved.
+static char _load_directory[MAX_PATH];      ///< Directory of the savegame that is being loaded, to find the base of incremental savegames.
+
+/**
+ * Get the savegame format with the given tag.
+ * @param tag The tag of the format.
+ * @return The format, or \c NULL if the tag is unknown.
+ */
+static const SaveLoadFormat *GetSavegameFormatByTag(uint32 tag)
+{
+	for (const SaveLoadFormat *slf = &_saveload_formats[0]; slf != endof(_saveload_formats); slf++) {
+		if (slf->tag == tag) return slf;
+	}
+	return NULL;
+}
+
+/**
+ * Read exactly the given number of bytes from a filter.
+ * @param lf  The filter to read from.
+ * @param buf The buffer to read to.
+ * @param len The number of bytes to read.
+ */
+static void ReadExactly(LoadFilter *lf, byte *buf, size_t len)
+{
+	while (len > 0) {
+		size_t read = lf->Read(buf, len);
+		if (read == 0) SlErrorCorrupt("Unexpected end of incremental savegame");
+		buf += read;
+		len -= read;
+	}
+}
+
+/** Filter calculating the size and MD5 of a savegame file as it is written, to identify the base of incremental savegames. */
+struct ChecksumSaveFilter : SaveFilter {
+	IncrementalBase *base; ///< The base to store the size and MD5 in when the file is finished.
+	Md5 checksum;          ///< MD5 of the bytes written so far.
+	size_t size;           ///< Number of bytes written so far.
+	bool finished;         ///< Whether the size and MD5 have been stored.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 * @param base  The base to store the size and MD5 of the file in.
+	 */
+	ChecksumSaveFilter(SaveFilter *chain, IncrementalBase *base) : SaveFilter(chain), base(base), size(0), finished(false)
+	{
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		this->checksum.Append(buf, size);
+		this->size += size;
+		this->chain->Write(buf, size);
+	}
+
+	/* virtual */ void Finish()
+	{
+		if (!this->finished) {
+			this->checksum.Finish(this->base->file_digest);
+			this->base->file_size = this->size;
+			this->finished = true;
+		}
+		this->chain->Finish();
+	}
+};
+
+/** Filter reading an incremental savegame: the base savegame with the changes of the increment applied to it. */
+struct IncrementalLoadFilter : LoadFilter {
+	LoadFilter *base;      ///< The decompressed base savegame.
+	size_t base_pos;       ///< Number of bytes read from the base savegame.
+	size_t base_size;      ///< Size of the file of the base savegame the increment was made against.
+	uint8 base_digest[16]; ///< MD5 of the file of the base savegame the increment was made against.
+	byte op;               ///< The current #IncrementalOperation, or 0 before the first one.
+	size_t remaining;      ///< Number of bytes the current operation has yet to deliver.
+
+	/**
+	 * Initialise this filter by reading the header of the increment and opening the base savegame.
+	 * @param chain The next filter in this chain.
+	 */
+	IncrementalLoadFilter(LoadFilter *chain) : LoadFilter(chain), base(NULL), base_pos(0), op(0), remaining(0)
+	{
+		try {
+			byte header[4 + 1];
+			ReadExactly(this->chain, header, sizeof(header));
+
+			uint32 tag;
+			memcpy(&tag, header, sizeof(tag));
+			const SaveLoadFormat *fmt = GetSavegameFormatByTag(tag);
+			if (fmt == NULL || fmt->init_write == NULL || fmt->init_load == NULL) {
+				SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "Loader for the compression of the incremental savegame is not available.");
+			}
+
+			char name[256];
+			ReadExactly(this->chain, (byte *)name, header[4]);
+			name[header[4]] = '\0';
+			if (StrEmpty(name) || strchr(name, PATHSEPCHAR) != NULL || strchr(name, '/') != NULL) SlErrorCorrupt("Invalid name of base savegame");
+
+			ReadExactly(this->chain, this->base_digest, sizeof(this->base_digest));
+
+			uint32 size[2];
+			ReadExactly(this->chain, (byte *)size, sizeof(size));
+			this->base_size = (size_t)(((uint64)FROM_BE32(size[0]) << 32) | FROM_BE32(size[1]));
+
+			this->OpenBase(name);
+			this->chain = fmt->init_load(this->chain);
+		} catch (...) {
+			/* Only ~LoadFilter runs when the construction fails; it must not delete the chain the caller still owns. */
+			delete this->base;
+			this->chain = NULL;
+			throw;
+		}
+	}
+
+	/** Clean up the base savegame. */
+	~IncrementalLoadFilter()
+	{
+		delete this->base;
+	}
+
+	/**
+	 * Open the base savegame. It is looked for next to the increment and in the autosave directory.
+	 * The whole file is checked against the size and MD5 in the increment before anything of it is
+	 * used, as rotating autosaves may have replaced it since the increment was saved.
+	 * @param name The file name of the base savegame.
+	 */
+	void OpenBase(const char *name)
+	{
+		char path[MAX_PATH];
+		strecpy(path, _load_directory, lastof(path));
+		strecat(path, name, lastof(path));
+
+		size_t file_size;
+		FILE *fh = FioFOpenFile(path, "rb", NO_DIRECTORY, &file_size);
+		if (fh == NULL) fh = FioFOpenFile(name, "rb", AUTOSAVE_DIR, &file_size);
+		if (fh == NULL) {
+			char err_str[64 + MAX_PATH];
+			seprintf(err_str, lastof(err_str), "Base savegame '%s' of the incremental savegame is not available.", name);
+			SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, err_str);
+		}
+
+		long start = ftell(fh);
+		Md5 checksum;
+		size_t left = file_size;
+		while (left > 0) {
+			byte buf[4096];
+			size_t read = fread(buf, 1, min(left, sizeof(buf)), fh);
+			if (read == 0) break;
+			checksum.Append(buf, read);
+			left -= read;
+		}
+		uint8 digest[16];
+		checksum.Finish(digest);
+		if (left != 0 || file_size != this->base_size || memcmp(digest, this->base_digest, sizeof(digest)) != 0 || fseek(fh, start, SEEK_SET) != 0) {
+			fclose(fh);
+			SlErrorCorrupt("The base savegame has been replaced");
+		}
+
+		/* The base savegame is always in a directory games are saved into. */
+		LoadFilter *reader = CreateFileReader(fh, false);
+		uint32 hdr[2];
+		if (reader->Read((byte *)hdr, sizeof(hdr)) != sizeof(hdr)) {
+			delete reader;
+			SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
+		}
+
+		const SaveLoadFormat *fmt = GetSavegameFormatByTag(hdr[0]);
+		if (fmt == NULL || fmt->init_write == NULL || fmt->init_load == NULL || TO_BE32(hdr[1]) >> 16 != _sl_version) {
+			delete reader;
+			SlErrorCorrupt("The base savegame has been replaced");
+		}
+
+		this->base = fmt->init_load(reader);
+	}
+
+	/**
+	 * Read from the base savegame.
+	 * @param buf The buffer to read to, or \c NULL to skip the bytes.
+	 * @param len The number of bytes to read.
+	 */
+	void ReadBase(byte *buf, size_t len)
+	{
+		byte skip[4096];
+		while (len > 0) {
+			byte *dest = (buf == NULL) ? skip : buf;
+			size_t read = this->base->Read(dest, (buf == NULL) ? min(len, sizeof(skip)) : len);
+			if (read == 0) SlErrorCorrupt("Invalid incremental savegame");
+			this->base_pos += read;
+			if (buf != NULL) buf += read;
+			len -= read;
+		}
+	}
+
+	/**
+	 * Start the next operation of the increment.
+	 * @return False if the end of the savegame has been reached.
+	 */
+	bool NextOperation()
+	{
+		if (this->op == IO_END) return false;
+
+		ReadExactly(this->chain, &this->op, 1);
+		switch (this->op) {
+			case IO_COPY: {
+				uint32 args[3];
+				ReadExactly(this->chain, (byte *)args, sizeof(args));
+				size_t offset = (size_t)(((uint64)FROM_BE32(args[0]) << 32) | FROM_BE32(args[1]));
+				if (offset < this->base_pos) SlErrorCorrupt("Invalid incremental savegame");
+				this->ReadBase(NULL, offset - this->base_pos);
+				this->remaining = FROM_BE32(args[2]);
+				return true;
+			}
+
+			case IO_INSERT: {
+				uint32 length;
+				ReadExactly(this->chain, (byte *)&length, sizeof(length));
+				this->remaining = FROM_BE32(length);
+				return true;
+			}
+
+			case IO_END:
+				return false;
+
+			default:
+				SlErrorCorrupt("Invalid incremental savegame");
+		}
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size_t done = 0;
+		while (done < size) {
+			if (this->remaining == 0) {
+				if (!this->NextOperation()) break;
+				continue;
+			}
+
+			size_t len = min(size - done, this->remaining);
+			if (this->op == IO_COPY) {
+				this->ReadBase(buf + done, len);
+			} else {
+				ReadExactly(this->chain, buf + done, len);
+			}
+			done += len;
+			this->remaining -= len;
+		}
+		return done;
+	}
+};
+
+/**
+ * Create the filter for reading an incremental savegame.
+ * @param chain The next filter in this chain.
+ * @return The filter.
+ */
+static LoadFilter *CreateIncrementalLoadFilter(LoadFilter *chain)
+{
+	return new IncrementalLoadFilter(chain);
+}
+
+/** Writer of the operations of an incremental savegame, which merges adjacent operations. */
+struct IncrementalOperationWriter {
+	SaveFilter *sf; ///< The filter to write the operations to.
+	byte op;        ///< The pending #IncrementalOperation, or 0 if there is none.
+	size_t offset;  ///< Offset in the base savegame or the savegame of the pending operation.
+	size_t length;  ///< Length of the pending operation.
+
+	/**
+	 * Create the writer.
+	 * @param sf The filter to write the operations to.
+	 */
+	IncrementalOperationWriter(SaveFilter *sf) : sf(sf), op(0), offset(0), length(0)
+	{
+	}
+
+	/**
+	 * Add an operation; it is merged with the pending one if they are adjacent.
+	 * @param op     The operation.
+	 * @param offset Offset in the base savegame (when copying) or the savegame (when inserting).
+	 * @param length Number of bytes.
+	 */
+	void Add(IncrementalOperation op, size_t offset, size_t length)
+	{
+		if (this->op == op && this->offset + this->length == offset && this->length + length <= UINT32_MAX) {
+			this->length += length;
+			return;
+		}
+		this->Flush();
+		this->op = op;
+		this->offset = offset;
+		this->length = length;
+	}
+
+	/** Write the pending operation. */
+	void Flush()
+	{
+		switch (this->op) {
+			case IO_COPY: {
+				byte buf[1 + 3 * sizeof(uint32)];
+				uint32 args[3] = { TO_BE32((uint32)((uint64)this->offset >> 32)), TO_BE32((uint32)this->offset), TO_BE32((uint32)this->length) };
+				buf[0] = IO_COPY;
+				memcpy(buf + 1, args, sizeof(args));
+				this->sf->Write(buf, sizeof(buf));
+				break;
+			}
+
+			case IO_INSERT: {
+				byte buf[1 + sizeof(uint32)];
+				uint32 length = TO_BE32((uint32)this->length);
+				buf[0] = IO_INSERT;
+				memcpy(buf + 1, &length, sizeof(length));
+				this->sf->Write(buf, sizeof(buf));
+				_sl.dumper->WriteRange(this->sf, this->offset, this->offset + this->length);
+				break;
+			}
+
+			default: break;
+		}
+		this->op = 0;
+	}
+
+	/** Write the pending operation and the end of the savegame. */
+	void Finish()
+	{
+		this->Flush();
+		byte end = IO_END;
+		this->sf->Write(&end, 1);
+	}
+};
+
+/**
+ * Decide how the next autosave relates to incremental savegames.
+ * @return The mode of saving.
+ */
+static IncrementalSaveMode GetIncrementalSaveMode()
+{
+	uint max_increments = _settings_client.gui.incremental_autosaves;
+	/* Rotating autosaves overwrite the base savegame of older increments; keep at least half of them loadable. */
+	if (!_settings_client.gui.keep_all_autosave) max_increments = min<uint>(max_increments, (_settings_client.gui.max_num_autosaves - 1) / 2);
+	if (max_increments == 0) return ISM_NONE;
+
+	if (!StrEmpty(_incremental_base.name) && _incremental_base.increments < max_increments) return ISM_INCREMENT;
+	return ISM_BASE;
+}
+
+/**
+ * Remember the savegame in memory as base of the following incremental savegames.
+ * It is identified by the size and checksum of its file, which the #ChecksumSaveFilter
+ * stored while writing it, and the checksums of the blocks of its chunks are kept to
+ * find the changes later on.
+ */
+static void SetIncrementalBase()
+{
+	IncrementalBase *base = &_incremental_base;
+
+	base->chunks.Clear();
+	base->hashes.Clear();
+	for (const SavegameChunkRange *chunk = _sl_chunks.Begin(); chunk != _sl_chunks.End(); chunk++) {
+		SavegameChunkRange *range = base->chunks.Append();
+		*range = *chunk;
+		range->first_hash = base->hashes.Length();
+
+		for (size_t begin = chunk->begin; begin < chunk->end; begin += INCREMENTAL_BLOCK_SIZE) {
+			Md5 checksum;
+			_sl.dumper->HashRange(&checksum, begin, min(begin + INCREMENTAL_BLOCK_SIZE, chunk->end));
+			checksum.Finish(base->hashes.Append()->digest);
+		}
+	}
+
+	base->increments = 0;
+	strecpy(base->name, _incremental_name, lastof(base->name));
+}
+
+/**
+ * Write the savegame in memory as increment to the base savegame. Blocks of
+ * the chunks that are the same as in the base savegame are copied from it;
+ * everything else is written compressed with the given format.
+ * @param fmt         The savegame format to compress the increment with.
+ * @param compression The compression level to use.
+ */
+static void WriteIncrementalSavegame(const SaveLoadFormat *fmt, byte compression)
+{
+	const IncrementalBase *base = &_incremental_base;
+
+	uint32 hdr[2] = { TO_BE32X('OTTI'), TO_BE32(SAVEGAME_VERSION << 16) };
+	_sl.sf->Write((byte *)hdr, sizeof(hdr));
+
+	uint32 tag = fmt->tag;
+	byte name_length = (byte)min<size_t>(strlen(base->name), 255);
+	char name[256];
+	memcpy(name, base->name, name_length);
+	uint8 digest[16];
+	memcpy(digest, base->file_digest, sizeof(digest));
+	_sl.sf->Write((byte *)&tag, sizeof(tag));
+	_sl.sf->Write(&name_length, 1);
+	_sl.sf->Write((byte *)name, name_length);
+	_sl.sf->Write(digest, sizeof(digest));
+	uint32 size[2] = { TO_BE32((uint32)((uint64)base->file_size >> 32)), TO_BE32((uint32)base->file_size) };
+	_sl.sf->Write((byte *)size, sizeof(size));
+
+	_sl.sf = fmt->init_write(_sl.sf, compression);
+	IncrementalOperationWriter writer(_sl.sf);
+
+	size_t pos = 0;
+	const SavegameChunkRange *next_base_chunk = base->chunks.Begin();
+	for (const SavegameChunkRange *chunk = _sl_chunks.Begin(); chunk != _sl_chunks.End(); chunk++) {
+		if (chunk->begin > pos) writer.Add(IO_INSERT, pos, chunk->begin - pos);
+		pos = chunk->end;
+
+		/* The chunks are in the same order in both savegames, so copies from the base savegame are in order too. */
+		const SavegameChunkRange *base_chunk = next_base_chunk;
+		while (base_chunk != base->chunks.End() && base_chunk->id != chunk->id) base_chunk++;
+		if (base_chunk == base->chunks.End()) {
+			writer.Add(IO_INSERT, chunk->begin, chunk->end - chunk->begin);
+			continue;
+		}
+		next_base_chunk = base_chunk + 1;
+
+		size_t base_length = base_chunk->end - base_chunk->begin;
+		for (size_t offset = 0; offset < chunk->end - chunk->begin; offset += INCREMENTAL_BLOCK_SIZE) {
+			size_t length = min(INCREMENTAL_BLOCK_SIZE, chunk->end - chunk->begin - offset);
+
+			bool same = offset < base_length && min(INCREMENTAL_BLOCK_SIZE, base_length - offset) == length;
+			if (same) {
+				Md5 checksum;
+				uint8 digest[16];
+				_sl.dumper->HashRange(&checksum, chunk->begin + offset, chunk->begin + offset + length);
+				checksum.Finish(digest);
+				same = memcmp(digest, base->hashes[base_chunk->first_hash + offset / INCREMENTAL_BLOCK_SIZE].digest, sizeof(digest)) == 0;
+			}
+
+			if (same) {
+				writer.Add(IO_COPY, base_chunk->begin + offset, length);
+			} else {
+				writer.Add(IO_INSERT, chunk->begin + offset, length);
+			}
+		}
+	}
+	if (_sl.dumper->GetSize() > pos) writer.Add(IO_INSERT, pos, _sl.dumper->GetSize() - pos);
+
+	writer.Finish();
+	_sl.sf->Finish();
+}
+
 /* actual loader/saver function */
 void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settings);
 extern bool AfterLoadGame();
@@ -2340,6 +3625,8 @@ extern bool LoadOldSaveGame(const char *file);
  */
 static inline void ClearSaveLoadState()
 {
+	SlWaitForConcurrentChunks();
+
 	delete _sl.dumper;
 	_sl.dumper = NULL;
 
@@ -2403,15 +3690,55 @@ static void SaveFileError()
 	SaveFileDone();
 }
 
+/**
+ * Determine the size of every chunk in the profile when it is compressed on
+ * its own. Chunks compress a bit worse on their own than as part of the whole
+ * savegame, but it shows which chunks the size of the savegame comes from.
+ * One compressor is reset for every chunk, so its state is allocated only once.
+ * @param fmt         The savegame format to compress with.
+ * @param compression The compression level to use.
+ */
+static void ProfileChunkCompression(const SaveLoadFormat *fmt, byte compression)
+{
+	CountingSaveFilter *counter = new CountingSaveFilter(NULL, NULL);
+	SaveFilter *sf = fmt->init_write(counter, compression);
+
+	size_t offset = 0;
+	for (SaveLoadChunkProfile *profile = _savegame_profile.chunks.Begin(); profile != _savegame_profile.chunks.End(); profile++) {
+		if (profile != _savegame_profile.chunks.Begin()) sf->Reset();
+
+		counter->count = &profile->packed_size;
+		_sl.dumper->WriteRange(sf, offset, offset + profile->size);
+		sf->Finish();
+
+		offset += profile->size;
+	}
+	delete sf;
+}
+
 /**
  * We have written the whole game into memory, _memory_savegame, now find
  * and appropiate compressor and start writing to file.
  */
-static SaveOrLoadResult SaveFileToDisk(bool threaded)
+static void WriteSavegame()
 {
-	try {
-		byte compression;
-		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
+	byte compression;
+	const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
+
+	if (_savegame_profiling) {
+		_savegame_profile.format = fmt->name;
+		ProfileChunkCompression(fmt, compression);
+		_sl.sf = new CountingSaveFilter(_sl.sf, &_savegame_profile.packed_size);
+	}
+
+	uint64 start_us = ottd_microseconds();
+
+	if (_sl.incremental == ISM_INCREMENT) {
+		WriteIncrementalSavegame(fmt, compression);
+		_incremental_base.increments++;
+	} else {
+		/* The increments identify their base by the file as it is written. */
+		if (_sl.incremental == ISM_BASE) _sl.sf = new ChecksumSaveFilter(_sl.sf, &_incremental_base);
 
 		/* We have written our stuff to memory, now write it to file! */
 		uint32 hdr[2] = { fmt->tag, TO_BE32(SAVEGAME_VERSION << 16) };
@@ -2420,6 +3747,23 @@ static SaveOrLoadResult SaveFileToDisk(bool threaded)
 		_sl.sf = fmt->init_write(_sl.sf, compression);
 		_sl.dumper->Flush(_sl.sf);
 
+		if (_sl.incremental == ISM_BASE) SetIncrementalBase();
+	}
+
+	if (_savegame_profiling) _savegame_profile.write_us = (uint32)(ottd_microseconds() - start_us);
+}
+
+/**
+ * Write the game that is saved to memory to the writer, and update the
+ * gui when that is done.
+ * @param threaded Whether this is called by the savegame thread.
+ * @return #SL_OK or #SL_ERROR.
+ */
+static SaveOrLoadResult SaveFileToDisk(bool threaded)
+{
+	try {
+		WriteSavegame();
+
 		ClearSaveLoadState();
 
 		if (threaded) SetAsyncSaveFinish(SaveFileDone);
@@ -2453,6 +3797,198 @@ static void SaveFileToDiskThread(void *arg)
 	SaveFileToDisk(true);
 }
 
+#ifdef WITH_SAVE_SNAPSHOT
+
+/** Result of a savegame written by a snapshot process, passed to the game through a pipe. */
+struct SnapshotResult {
+	StringID error_str;  ///< The error message, or #INVALID_STRING_ID when the savegame was written.
+	char extra_msg[256]; ///< The extra error message of the error.
+};
+
+static pid_t _snapshot_pid;               ///< The process writing the snapshot of the game.
+static int _snapshot_pipe;                ///< The end of the pipe the snapshot process sends its #SnapshotResult to.
+static ThreadObject *_snapshot_thread;    ///< The thread waiting for the snapshot process, or \c NULL when no snapshot is being saved.
+static SnapshotResult _snapshot_result;   ///< The result of the last snapshot process.
+static volatile bool _snapshot_finished;  ///< Whether #_snapshot_result is set and not handled by the game yet.
+
+/**
+ * Close all file descriptors a snapshot process inherited from the game,
+ * except the standard ones and the given ones. Otherwise the sockets of the
+ * network connections would stay open as long as the snapshot process runs.
+ * @param keep1 A file descriptor to keep open.
+ * @param keep2 Another file descriptor to keep open.
+ */
+static void CloseInheritedFiles(int keep1, int keep2)
+{
+	long max_fd = min<long>(sysconf(_SC_OPEN_MAX), 65536);
+	for (int fd = 3; fd < max_fd; fd++) {
+		if (fd != keep1 && fd != keep2) close(fd);
+	}
+}
+
+/**
+ * The work of the snapshot process: save the chunks of its copy of the game
+ * to memory, write them and send the result back. The process has a copy
+ * of the memory of the game, so the game can continue meanwhile.
+ *
+ * Only the thread that forked exists in this process. Anything the other
+ * threads of the game might have locked at that moment, like the thread
+ * pools and the network connections, must not be used here.
+ * @param fd      The end of the pipe to send the #SnapshotResult to.
+ * @param file_fd The file descriptor of the savegame file.
+ */
+static void NORETURN SaveSnapshot(int fd, int file_fd)
+{
+	_save_snapshot_process = true;
+	CloseInheritedFiles(fd, file_fd);
+
+	SnapshotResult result;
+	memset(&result, 0, sizeof(result));
+	result.error_str = INVALID_STRING_ID;
+
+	try {
+		SlSaveChunks();
+		WriteSavegame();
+	} catch (...) {
+		result.error_str = _sl.error_str;
+		if (_sl.extra_msg != NULL) strecpy(result.extra_msg, _sl.extra_msg, lastof(result.extra_msg));
+	}
+
+	if (write(fd, &result, sizeof(result)) != sizeof(result)) _exit(1);
+	/* Do not run any of the cleanup of the game; that is the job of the game itself. */
+	_exit(0);
+}
+
+/** Thread run function for waiting on the snapshot process. */
+static void WaitForSnapshotThread(void *arg)
+{
+	SnapshotResult result;
+	size_t read_len = 0;
+	while (read_len < sizeof(result)) {
+		ssize_t len = read(_snapshot_pipe, (byte *)&result + read_len, sizeof(result) - read_len);
+		if (len > 0) {
+			read_len += len;
+		} else if (len == 0 || errno != EINTR) {
+			break;
+		}
+	}
+	close(_snapshot_pipe);
+	while (waitpid(_snapshot_pid, NULL, 0) == -1 && errno == EINTR) {}
+
+	if (read_len != sizeof(result)) {
+		result.error_str = STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR;
+		strecpy(result.extra_msg, "the snapshot process failed", lastof(result.extra_msg));
+	}
+
+	_snapshot_result = result;
+	_snapshot_finished = true;
+}
+
+/** Update the gui now the snapshot process is done, and show its error, if any. */
+static void ShowSnapshotResult()
+{
+	if (_snapshot_result.error_str != INVALID_STRING_ID) {
+		SetDParam(0, _snapshot_result.error_str);
+		SetDParamStr(1, _snapshot_result.extra_msg);
+		char err_str[512];
+		GetString(err_str, STR_ERROR_GAME_SAVE_FAILED, lastof(err_str));
+		/* Skip the "colour" character */
+		DEBUG(sl, 0, "%s", err_str + 3);
+
+		SetDParamStr(0, err_str);
+		ShowErrorMessage(STR_JUST_RAW_STRING, INVALID_STRING_ID, WL_ERROR);
+	}
+	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_FINISH);
+}
+
+/**
+ * Handle the end of the snapshot process.
+ * @param wait Whether to wait for the snapshot process when it is still saving.
+ */
+static void FinishSnapshot(bool wait)
+{
+	if (_snapshot_thread == NULL || (!wait && !_snapshot_finished)) return;
+
+	_snapshot_thread->Join();
+	delete _snapshot_thread;
+	_snapshot_thread = NULL;
+	_snapshot_finished = false;
+
+	ShowSnapshotResult();
+}
+
+/** Handle the end of the snapshot process, if it has finished. */
+static void ProcessSnapshotFinish()
+{
+	FinishSnapshot(false);
+}
+
+/**
+ * Save the game by a snapshot process, so the game does not have to wait
+ * till all chunks are saved. The process is a fork of the game, so it sees
+ * the game as it was at this moment while the game continues. A separate
+ * thread waits for the process, so saves within the game, like the map
+ * downloads of a server, do not have to wait for the snapshot.
+ * @return False if no snapshot process could be started.
+ */
+static bool SaveWithSnapshot()
+{
+	int fds[2];
+	if (pipe(fds) != 0) return false;
+
+	/* Only file writers are saved by a snapshot, see DoSave. */
+	int file_fd = fileno(static_cast<FileWriter *>(_sl.sf)->file);
+
+	pid_t pid = fork();
+	if (pid == -1) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0) {
+		close(fds[0]);
+		SaveSnapshot(fds[1], file_fd);
+	}
+
+	close(fds[1]);
+	DEBUG(sl, 2, "Saving a snapshot of the game in process %d", (int)pid);
+	_snapshot_pid = pid;
+	_snapshot_pipe = fds[0];
+	_snapshot_finished = false;
+
+	/* The snapshot process writes the savegame; our copy of the file is not needed anymore. */
+	ClearSaveLoadState();
+
+	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_START);
+	if (!ThreadObject::New(&WaitForSnapshotThread, NULL, &_snapshot_thread)) {
+		DEBUG(sl, 1, "Cannot create snapshot thread, waiting for the snapshot process...");
+		WaitForSnapshotThread(NULL);
+		_snapshot_finished = false;
+		ShowSnapshotResult();
+	}
+	return true;
+}
+
+/**
+ * Check whether a snapshot of the game is being saved.
+ * @return True if the snapshot process has not been handled yet.
+ */
+static bool IsSnapshotInProgress()
+{
+	return _snapshot_thread != NULL;
+}
+
+#endif /* WITH_SAVE_SNAPSHOT */
+
+/** Wait till the snapshot process, if any, has written its savegame. */
+void WaitTillSnapshotSaved()
+{
+#ifdef WITH_SAVE_SNAPSHOT
+	FinishSnapshot(true);
+#endif
+}
+
 void WaitTillSaved()
 {
 	if (_save_thread == NULL) return;
@@ -2469,11 +4005,14 @@ void WaitTillSaved()
  * Actually perform the saving of the savegame.
  * General tactic is to first save the game to memory, then write it to file
  * using the writer, either in threaded mode if possible, or single-threaded.
+ * When a snapshot is allowed, both are done by a snapshot of the game
+ * instead, if the operating system supports that.
  * @param writer   The filter to write the savegame to.
  * @param threaded Whether to try to perform the saving asynchroniously.
+ * @param snapshot Whether to try to save a snapshot of the game; the writer has to be a #FileWriter.
  * @return Return the result of the action. #SL_OK or #SL_ERROR
  */
-static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded)
+static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded, bool snapshot = false)
 {
 	assert(!_sl.saveinprogress);
 
@@ -2482,7 +4021,19 @@ static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded)
 
 	_sl_version = SAVEGAME_VERSION;
 
+	/* The profile is made by this thread, so it cannot be saved in the background. */
+	if (_savegame_profiling) {
+		_savegame_profile.Clear(true);
+		threaded = false;
+		snapshot = false;
+	}
+
 	SaveViewportBeforeSaveGame();
+
+#ifdef WITH_SAVE_SNAPSHOT
+	if (snapshot && SaveWithSnapshot()) return SL_OK;
+#endif
+
 	SlSaveChunks();
 
 	SaveFileStart();
@@ -2508,6 +4059,7 @@ SaveOrLoadResult SaveWithFilter(SaveFilter *writer, bool threaded)
 {
 	try {
 		_sl.action = SLA_SAVE;
+		_sl.incremental = ISM_NONE;
 		return DoSave(writer, threaded);
 	} catch (...) {
 		ClearSaveLoadState();
@@ -2583,6 +4135,14 @@ static SaveOrLoadResult DoLoad(LoadFilter *reader, bool load_check)
 		SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, err_str);
 	}
 
+	bool profile = _savegame_profiling && !load_check;
+	if (profile) {
+		_savegame_profile.Clear(false);
+		_savegame_profile.format = fmt->name;
+		_savegame_profile.packed_size = sizeof(hdr);
+		_sl.lf = new CountingLoadFilter(_sl.lf, &_savegame_profile.packed_size);
+	}
+
 	_sl.lf = fmt->init_load(_sl.lf);
 	_sl.reader = new ReadBuffer(_sl.lf);
 	_next_offs = 0;
@@ -2628,7 +4188,10 @@ static SaveOrLoadResult DoLoad(LoadFilter *reader, bool load_check)
 	} else {
 		/* Load chunks and resolve references */
 		SlLoadChunks();
+
+		uint64 start_us = ottd_microseconds();
 		SlFixPointers();
+		if (profile) _savegame_profile.fix_pointers_us = (uint32)(ottd_microseconds() - start_us);
 	}
 
 	ClearSaveLoadState();
@@ -2643,12 +4206,12 @@ static SaveOrLoadResult DoLoad(LoadFilter *reader, bool load_check)
 
 		/* After loading fix up savegame for any internal changes that
 		 * might have occurred since then. If it fails, load back the old game. */
-		if (!AfterLoadGame()) {
-			GamelogStopAction();
-			return SL_REINIT;
-		}
+		uint64 start_us = ottd_microseconds();
+		bool loaded = AfterLoadGame();
+		if (profile) _savegame_profile.after_load_us = (uint32)(ottd_microseconds() - start_us);
 
 		GamelogStopAction();
+		if (!loaded) return SL_REINIT;
 	}
 
 	return SL_OK;
@@ -2677,17 +4240,24 @@ SaveOrLoadResult LoadWithFilter(LoadFilter *reader)
  * @param mode Save or load mode. Load can also be a TTD(Patch) game. Use #SL_LOAD, #SL_OLD_LOAD, #SL_LOAD_CHECK, or #SL_SAVE.
  * @param sb The sub directory to save the savegame in
  * @param threaded True when threaded saving is allowed
+ * @param incremental True when the savegame may be saved as increment to an earlier savegame, see the incremental_autosaves setting
  * @return Return the result of the action. #SL_OK, #SL_ERROR, or #SL_REINIT ("unload" the game)
  */
-SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded)
+SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded, bool incremental)
 {
+	bool saving = _sl.saveinprogress;
+#ifdef WITH_SAVE_SNAPSHOT
+	saving |= IsSnapshotInProgress();
+#endif
+
 	/* An instance of saving is already active, so don't go saving again */
-	if (_sl.saveinprogress && mode == SL_SAVE && threaded) {
+	if (saving && mode == SL_SAVE && threaded) {
 		/* if not an autosave, but a user action, show error message */
 		if (!_do_autosave) ShowErrorMessage(STR_ERROR_SAVE_STILL_IN_PROGRESS, INVALID_STRING_ID, WL_ERROR);
 		return SL_OK;
 	}
 	WaitTillSaved();
+	WaitTillSnapshotSaved();
 
 	/* Load a TTDLX or TTDPatch game */
 	if (mode == SL_OLD_LOAD) {
@@ -2722,9 +4292,9 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 		FILE *fh = (mode == SL_SAVE) ? FioFOpenFile(filename, "wb", sb) : FioFOpenFile(filename, "rb", sb);
 
 		/* Make it a little easier to load savegames from the console */
-		if (fh == NULL && mode != SL_SAVE) fh = FioFOpenFile(filename, "rb", SAVE_DIR);
-		if (fh == NULL && mode != SL_SAVE) fh = FioFOpenFile(filename, "rb", BASE_DIR);
-		if (fh == NULL && mode != SL_SAVE) fh = FioFOpenFile(filename, "rb", SCENARIO_DIR);
+		if (fh == NULL && mode != SL_SAVE && (fh = FioFOpenFile(filename, "rb", SAVE_DIR)) != NULL) sb = SAVE_DIR;
+		if (fh == NULL && mode != SL_SAVE && (fh = FioFOpenFile(filename, "rb", BASE_DIR)) != NULL) sb = BASE_DIR;
+		if (fh == NULL && mode != SL_SAVE && (fh = FioFOpenFile(filename, "rb", SCENARIO_DIR)) != NULL) sb = SCENARIO_DIR;
 
 		if (fh == NULL) {
 			SlError(mode == SL_SAVE ? STR_GAME_SAVELOAD_ERROR_FILE_NOT_WRITEABLE : STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE);
@@ -2732,15 +4302,35 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 
 		if (mode == SL_SAVE) { // SAVE game
 			DEBUG(desync, 1, "save: %08x; %02x; %s", _date, _date_fract, filename);
-			if (_network_server || !_settings_client.gui.threaded_saves) threaded = false;
+			if (!_settings_client.gui.threaded_saves) threaded = false;
+#ifdef ENABLE_NETWORK
+			/* Do not save the provisional results of our own commands. */
+			if (_networking && !_network_server) NetworkClientRollbackCommands();
+#endif /* ENABLE_NETWORK */
+
+			_sl.incremental = incremental ? GetIncrementalSaveMode() : ISM_NONE;
+			if (_sl.incremental == ISM_BASE) {
+				/* The previous base savegame might be overwritten, so it cannot be used anymore. */
+				_incremental_base.name[0] = '\0';
+				const char *name = strrchr(filename, PATHSEPCHAR);
+				strecpy(_incremental_name, name == NULL ? filename : name + 1, lastof(_incremental_name));
+			}
 
-			return DoSave(new FileWriter(fh), threaded);
+			/* A snapshot does not share the savegame state with the map downloads of the server, so the server can use it too.
+			 * The incremental savegames need the chunks of the savegame in this process, so they cannot use a snapshot. */
+			return DoSave(new FileWriter(fh), threaded && !_network_server, threaded && _sl.incremental == ISM_NONE);
 		}
 
 		/* LOAD game */
 		assert(mode == SL_LOAD || mode == SL_LOAD_CHECK);
 		DEBUG(desync, 1, "load: %s", filename);
-		return DoLoad(new FileReader(fh), mode == SL_LOAD_CHECK);
+
+		/* The base savegame of an incremental savegame is looked for in the same directory. */
+		strecpy(_load_directory, filename, lastof(_load_directory));
+		char *name = strrchr(_load_directory, PATHSEPCHAR);
+		*(name == NULL ? _load_directory : name + 1) = '\0';
+		bool map = sb != SAVE_DIR && sb != AUTOSAVE_DIR && !IsInSaveDirectory(filename);
+		return DoLoad(CreateFileReader(fh, map), mode == SL_LOAD_CHECK);
 	} catch (...) {
 		ClearSaveLoadState();
 
@@ -2752,6 +4342,143 @@ SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, boo
 	}
 }
 
+extern bool SafeLoad(const char *filename, int mode, GameMode newgm, Subdirectory subdir, struct LoadFilter *lf = NULL);
+
+/** A savegame that is kept in memory, to restore the game after benchmarking. */
+struct MemorySavegame {
+	byte *data;      ///< The savegame.
+	size_t size;     ///< Number of bytes in #data.
+	size_t capacity; ///< Number of bytes allocated for #data.
+
+	/** Create an empty savegame. */
+	MemorySavegame() : data(NULL), size(0), capacity(0)
+	{
+	}
+
+	/** Free the savegame. */
+	~MemorySavegame()
+	{
+		free(this->data);
+	}
+};
+
+/** Writing a savegame to memory. */
+struct MemorySaveFilter : SaveFilter {
+	MemorySavegame *savegame; ///< The savegame to write to.
+
+	/**
+	 * Create the memory writer.
+	 * @param savegame The savegame to write to; it outlives the filter.
+	 */
+	MemorySaveFilter(MemorySavegame *savegame) : SaveFilter(NULL), savegame(savegame)
+	{
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		MemorySavegame *sg = this->savegame;
+		if (sg->size + size > sg->capacity) {
+			sg->capacity = max(sg->capacity * 2, sg->size + size);
+			sg->data = ReallocT(sg->data, sg->capacity);
+		}
+		memcpy(sg->data + sg->size, buf, size);
+		sg->size += size;
+	}
+};
+
+/** Reading a savegame from memory. */
+struct MemoryLoadFilter : LoadFilter {
+	const MemorySavegame *savegame; ///< The savegame to read from.
+	size_t pos;                     ///< The position in the savegame to read from.
+
+	/**
+	 * Create the memory reader.
+	 * @param savegame The savegame to read from; it outlives the filter.
+	 */
+	MemoryLoadFilter(const MemorySavegame *savegame) : LoadFilter(NULL), savegame(savegame), pos(0)
+	{
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size = min(size, this->savegame->size - this->pos);
+		memcpy(buf, this->savegame->data + this->pos, size);
+		this->pos += size;
+		return size;
+	}
+
+	/* virtual */ void Reset()
+	{
+		this->pos = 0;
+	}
+};
+
+/**
+ * Benchmark the savegame formats that can be written: save the game with
+ * each of them to "benchmark.sav" in the save directory and load it back.
+ * Only the raw loading by #SafeLoad is measured; the steps the game takes
+ * when switching to a loaded game, like running the game start script,
+ * are not done for the benchmarked savegames. The game that was running
+ * before is kept in memory and loaded again afterwards.
+ * @param filename The name of the savegame in the save directory to benchmark, or \c NULL to benchmark the current game.
+ * @param count    Number of times to save and load the game with each format.
+ * @param results  [out] The average results per savegame format.
+ * @return False if saving or loading failed.
+ */
+bool BenchmarkSavegameFormats(const char *filename, uint count, SmallVector<SavegameBenchmarkResult, 8> *results)
+{
+	static const char * const BENCHMARK_FILE = "benchmark.sav";
+
+	GameMode game_mode = _game_mode;
+	MemorySavegame running_game;
+	if (SaveWithFilter(new MemorySaveFilter(&running_game), false) != SL_OK) return false;
+
+	bool success = true;
+	if (filename != NULL) {
+		ResetGRFConfig(true);
+		ResetWindowSystem();
+		success = SafeLoad(filename, SL_LOAD, GM_NORMAL, SAVE_DIR);
+	}
+
+	char format_backup[lengthof(_savegame_format)];
+	strecpy(format_backup, _savegame_format, lastof(format_backup));
+	bool profiling_backup = _savegame_profiling;
+	_savegame_profiling = true;
+
+	for (const SaveLoadFormat *slf = _saveload_formats; success && slf != endof(_saveload_formats); slf++) {
+		if (slf->init_write == NULL) continue;
+		strecpy(_savegame_format, slf->name, lastof(_savegame_format));
+
+		uint64 save_us = 0;
+		uint64 load_us = 0;
+		for (uint i = 0; success && i < count; i++) {
+			uint64 start = ottd_microseconds();
+			success = SaveOrLoad(BENCHMARK_FILE, SL_SAVE, SAVE_DIR, false) == SL_OK;
+			save_us += ottd_microseconds() - start;
+			if (!success) break;
+
+			start = ottd_microseconds();
+			success = SafeLoad(BENCHMARK_FILE, SL_LOAD, GM_NORMAL, SAVE_DIR);
+			load_us += ottd_microseconds() - start;
+		}
+
+		SavegameBenchmarkResult *result = results->Append();
+		result->format = slf->name;
+		result->packed_size = _savegame_profile.packed_size;
+		result->save_us = (uint32)(save_us / max(count, 1U));
+		result->load_us = (uint32)(load_us / max(count, 1U));
+	}
+
+	strecpy(_savegame_format, format_backup, lastof(_savegame_format));
+	_savegame_profiling = profiling_backup;
+
+	/* Only a failure sets the error, so the error of the benchmark is kept when the game is restored. */
+	ResetGRFConfig(true);
+	ResetWindowSystem();
+	bool restored = SafeLoad(NULL, SL_LOAD, game_mode, NO_DIRECTORY, new MemoryLoadFilter(&running_game));
+	return success && restored;
+}
+
 /** Do a save when exiting the game (_settings_client.gui.autosave_on_exit) */
 void DoExitSave()
 {
@@ -46,8 +46,9 @@ enum SavegameType {
 void GenerateDefaultSaveName(char *buf, const char *last);
 void SetSaveLoadError(uint16 str);
 const char *GetSaveLoadErrorString();
-SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded = true);
+SaveOrLoadResult SaveOrLoad(const char *filename, int mode, Subdirectory sb, bool threaded = true, bool incremental = false);
 void WaitTillSaved();
+void WaitTillSnapshotSaved();
 void ProcessAsyncSaveFinish();
 void DoExitSave();
 
@@ -56,6 +57,7 @@ SaveOrLoadResult LoadWithFilter(struct LoadFilter *reader);
 
 typedef void ChunkSaveLoadProc();
 typedef void AutolengthProc(void *arg);
+typedef void ChunkDecodeProc(const byte *data, size_t len);
 
 /** Handlers and description of chunk. */
 struct ChunkHandler {
@@ -93,6 +95,7 @@ enum ChunkType {
 	CH_TYPE_MASK    =  3,
 	CH_LAST         =  8, ///< Last chunk in this array.
 	CH_AUTO_LENGTH  = 16,
+	CH_CONCURRENT   = 32, ///< The chunk may be decoded while the next chunks are read, see #SlLoadConcurrently.
 };
 
 /**
@@ -524,12 +527,15 @@ int SlIterateArray();
 
 void SlAutolength(AutolengthProc *proc, void *arg);
 size_t SlGetFieldLength();
+void SlLoadConcurrently(ChunkDecodeProc *proc);
 void SlSetLength(size_t length);
 size_t SlCalcObjMemberLength(const void *object, const SaveLoad *sld);
 size_t SlCalcObjLength(const void *object, const SaveLoad *sld);
 
 byte SlReadByte();
 void SlWriteByte(byte b);
+byte *SlGetWriteSpan(size_t *len);
+void SlCommitWriteSpan(size_t len);
 
 void SlGlobList(const SaveLoadGlobVarList *sldg);
 void SlArray(void *array, size_t length, VarType conv);
@@ -560,6 +566,8 @@ enum SaveLoadVersions {
 	SL_RESERVATION,
 	SL_CARGOMAP,
 	SL_EXT_RATING,
+	SL_PARALLEL_PF,
+	SL_COMPACT_LINKGRAPH,
 
 	/** Highest possible savegame version. */
 	SL_MAX_VERSION = 255
@@ -39,6 +39,17 @@ struct LoadFilter {
 	 */
 	virtual size_t Read(byte *buf, size_t len) = 0;
 
+	/**
+	 * Read bytes from the savegame without copying them, if this filter
+	 * holds them in memory already.
+	 * @param len [in,out] The maximum number of bytes to read; the number of bytes that were read.
+	 * @return The read bytes, valid till the next read from this filter, or \c NULL when the bytes have to be read with #Read, e.g. at the end of the savegame.
+	 */
+	virtual const byte *ReadInPlace(size_t *len)
+	{
+		return NULL;
+	}
+
 	/**
 	 * Reset this filter to read from the beginning of the file.
 	 */
@@ -91,6 +102,14 @@ struct SaveFilter {
 	{
 		if (this->chain != NULL) this->chain->Finish();
 	}
+
+	/**
+	 * Reset this filter to write a new savegame after the previous one is finished.
+	 */
+	virtual void Reset()
+	{
+		if (this->chain != NULL) this->chain->Reset();
+	}
 };
 
 /**
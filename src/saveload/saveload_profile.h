@@ -0,0 +1,51 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file saveload_profile.h Profiling of saving and loading savegames, and benchmarking of the savegame formats. */
+
+#ifndef SAVELOAD_PROFILE_H
+#define SAVELOAD_PROFILE_H
+
+#include "../core/smallvec_type.hpp"
+
+/** Profile of saving or loading one chunk. */
+struct SaveLoadChunkProfile {
+	uint32 id;          ///< Identifier of the chunk.
+	size_t size;        ///< Size of the chunk before compression.
+	size_t packed_size; ///< Size of the chunk when it is compressed on its own; only known when saving.
+	uint32 time_us;     ///< Time spent saving or loading the chunk in microseconds; when loading this includes the decompression.
+};
+
+/** Profile of the last savegame that was saved or loaded while profiling. */
+struct SaveLoadProfile {
+	bool save;                                    ///< Whether the savegame was saved, otherwise it was loaded.
+	const char *format;                           ///< Name of the format of the savegame.
+	SmallVector<SaveLoadChunkProfile, 64> chunks; ///< Profile of the chunks, in the order of the savegame.
+	size_t packed_size;                           ///< Size of the savegame file.
+	uint32 write_us;                              ///< Time spent compressing and writing the savegame in microseconds.
+	uint32 fix_pointers_us;                       ///< Time spent fixing the pointers after loading in microseconds.
+	uint32 after_load_us;                         ///< Time spent in AfterLoadGame in microseconds.
+
+	void Clear(bool save);
+};
+
+/** Result of benchmarking one savegame format. */
+struct SavegameBenchmarkResult {
+	const char *format; ///< Name of the savegame format.
+	size_t packed_size; ///< Size of the savegame file.
+	uint32 save_us;     ///< Average time of saving the game in microseconds.
+	uint32 load_us;     ///< Average time of the raw loading of the game, without the steps of switching to it, in microseconds.
+};
+
+extern bool _savegame_profiling;
+extern SaveLoadProfile _savegame_profile;
+
+bool BenchmarkSavegameFormats(const char *filename, uint count, SmallVector<SavegameBenchmarkResult, 8> *results);
+
+#endif /* SAVELOAD_PROFILE_H */
@@ -1200,6 +1200,7 @@ static bool UpdateServerPassword(int32 p1)
 		_settings_client.network.server_password[0] = '\0';
 	}
 
+	if (_network_server) NetworkInvalidateServerInfo();
 	return true;
 }
 
@@ -1214,7 +1215,17 @@ static bool UpdateRconPassword(int32 p1)
 
 static bool UpdateClientConfigValues(int32 p1)
 {
-	if (_network_server) NetworkServerSendConfigUpdate();
+	if (_network_server) {
+		NetworkServerSendConfigUpdate();
+		NetworkInvalidateServerInfo();
+	}
+
+	return true;
+}
+
+static bool UpdateServerInfo(int32 p1)
+{
+	if (_network_server) NetworkInvalidateServerInfo();
 
 	return true;
 }
@@ -91,6 +91,7 @@ struct GUISettings {
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	uint8  date_format_in_default_names;     ///< should the default savegame/screenshot name use long dates (31th Dec 2008), short dates (31-12-2008) or ISO dates (2008-12-31)
 	byte   max_num_autosaves;                ///< controls how many autosavegames are made before the game starts to overwrite (names them 0 to max_num_autosaves - 1)
+	byte   incremental_autosaves;            ///< number of autosaves that only contain the changes since the last full autosave, between two full autosaves
 	bool   population_in_label;              ///< show the population of a town in his label?
 	uint8  right_mouse_btn_emulation;        ///< should we emulate right mouse clicking?
 	uint8  scrollwheel_scrolling;            ///< scrolling using the scroll wheel?
@@ -178,6 +179,7 @@ struct NetworkSettings {
 	uint16 max_commands_in_queue;                         ///< how many commands may there be in the incoming queue before dropping the connection?
 	uint16 bytes_per_frame;                               ///< how many bytes may, over a long period, be received per frame?
 	uint16 bytes_per_frame_burst;                         ///< how many bytes may, over a short period, be received?
+	bool   threaded_io;                                   ///< should the server read and write the connections in a separate thread?
 	uint16 max_init_time;                                 ///< maximum amount of time, in game ticks, a client may take to initiate joining
 	uint16 max_join_time;                                 ///< maximum amount of time, in game ticks, a client may take to sync up during joining
 	uint16 max_download_time;                             ///< maximum amount of time, in game ticks, a client may take to download the map
@@ -347,6 +349,8 @@ struct YAPFSettings {
 	uint32 rail_longer_platform_per_tile_penalty;  ///< penalty for longer  station platform than train (per tile)
 	uint32 rail_shorter_platform_penalty;          ///< penalty for shorter station platform than train
 	uint32 rail_shorter_platform_per_tile_penalty; ///< penalty for shorter station platform than train (per tile)
+
+	bool   rail_parallel_search;             ///< search the paths of waiting trains concurrently at the start of a tick
 };
 
 /** Settings related to all pathfinders. */
@@ -16,6 +16,7 @@
 #include "news_func.h"
 #include "company_func.h"
 #include "pathfinder/npf/npf_func.h"
+#include "pathfinder/pf_stats.h"
 #include "depot_base.h"
 #include "station_base.h"
 #include "newgrf_engine.h"
@@ -402,6 +403,7 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 		default: NOT_REACHED();
 	}
 
+	RecordPathfinderRequest(v, tile, enterdir, tracks, track);
 	v->HandlePathfindingResult(path_found);
 	return track;
 }
@@ -17,6 +17,7 @@
 #include "viewport_func.h"
 #include "train.h"
 #include "company_base.h"
+#include "core/smallvec_type.hpp"
 
 
 /** these are the maximums used for updating signal blocks */
@@ -27,6 +28,10 @@ static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _glob
 
 assert_compile(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
 
+/** these are the sizes of the cache of explored signal segments */
+static const uint SIG_CACHE_HASH_BITS = 12;      ///< number of bits of the hash of cached segments
+static const uint SIG_CACHE_MAX_ITEMS = 1 << 16; ///< number of remembered items of all cached segments, the cache is emptied when it gets larger
+
 /** incidating trackbits with given enterdir */
 static const TrackBits _enterdir_to_trackbits[DIAGDIR_END] = {
 	TRACK_BIT_3WAY_NE,
@@ -147,10 +152,13 @@ public:
 	 * Sets the 'overflowed' flag if the set was full
 	 * @param tile tile
 	 * @param dir and dir to add
+	 * @param unique do not add tile & dir when it is already in the set
 	 * @return true iff the item could be added (set wasn't full)
 	 */
-	bool Add(TileIndex tile, Tdir dir)
+	bool Add(TileIndex tile, Tdir dir, bool unique = false)
 	{
+		if (unique && this->IsIn(tile, dir)) return true;
+
 		if (this->IsFull()) {
 			overflowed = true;
 			DEBUG(misc, 0, "SignalSegment too complex. Set %s is full (maximum %d)", name, items);
@@ -187,12 +195,544 @@ static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of
 static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
 
 
-/** Check whether there is a train on rail, not in a depot */
-static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
+/** Current signal block state flags */
+enum SigFlags {
+	SF_NONE   = 0,
+	SF_TRAIN  = 1 << 0, ///< train found in segment
+	SF_EXIT   = 1 << 1, ///< exitsignal found
+	SF_EXIT2  = 1 << 2, ///< two or more exits found
+	SF_GREEN  = 1 << 3, ///< green exitsignal found
+	SF_GREEN2 = 1 << 4, ///< two or more green exits found
+	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
+	SF_PBS    = 1 << 6, ///< pbs signal found
+};
+
+DECLARE_ENUM_AS_BIT_SET(SigFlags)
+
+
+/**
+ * Types of the steps taken while exploring a signal segment that are remembered,
+ * so a later update of the same segment can repeat them without exploring again.
+ */
+enum SegmentItemType {
+	SIT_GLOBSET,        ///< tile side removed from _globset
+	SIT_TRAIN_ON_TILE,  ///< check for any train on the tile, remembered with the signal block
+	SIT_TRAIN_ON_TRACK, ///< check for trains on the tracks of the tile, remembered with the signal block
+	SIT_PRESIGNAL_EXIT, ///< presignal exit in direction out of the segment
+	SIT_SIGNAL,         ///< signal to be updated, added to _tbuset
+};
+
+/** One remembered step of exploring a signal segment */
+struct SegmentItem {
+	TileIndex tile; ///< tile of the step
+	byte type;      ///< type of the step, see SegmentItemType
+	byte data;      ///< DiagDirection, TrackBits or Trackdir, depending on the type
+};
+
+/** A signal segment remembered in the cache, see UpdateSignalsInBuffer() */
+struct CachedSignalSegment {
+	TileIndex tile;    ///< tile of the _globset item the segment was explored from
+	DiagDirection dir; ///< side of the _globset item the segment was explored from
+	Owner owner;       ///< owner whose signals were updated, INVALID_OWNER if the segment was invalidated
+	SigFlags flags;    ///< flags that only depend on the track layout (SF_PBS)
+	uint first;        ///< index of the first step in _segment_items
+	uint last;         ///< index behind the last step in _segment_items
+	uint block;        ///< index of the signal block of the segment in _signal_blocks
+	uint next;         ///< next segment with the same hash, UINT_MAX if none
+};
+
+/**
+ * A signal block, i.e. the tracks between signals. The blocks are the nodes of
+ * the graph of signal blocks, the signals updated by the cached segments are its edges.
+ * Instead of searching the block for trains each time its signals are updated,
+ * the trains in the block are counted as they move, see UpdateSignalBlockOccupancy().
+ */
+struct SignalBlock {
+	Owner owner;  ///< owner of the tracks of the block, INVALID_OWNER if the block was invalidated
+	uint first;   ///< index of the first check for trains of the block in _signal_block_tiles
+	uint checks;  ///< number of checks for trains of the block in _signal_block_tiles
+	uint trains;  ///< number of trains (parts) in the block, counted once for every check they match
+};
+
+/** A check for trains of a signal block, which is also used to remember things about its tile */
+struct SignalBlockTile {
+	TileIndex tile;        ///< tile to check
+	uint block;            ///< index of the block in _signal_blocks
+	byte type;             ///< SIT_TRAIN_ON_TILE or SIT_TRAIN_ON_TRACK
+	byte tracks;           ///< tracks to check for SIT_TRAIN_ON_TRACK
+	byte safe_options;     ///< include_line_end and forbid_90deg of the remembered safe waiting positions
+	uint16 safe_known;     ///< trackdirs of which it is known whether they are safe waiting positions
+	uint16 safe;           ///< trackdirs that are safe waiting positions
+	RailTypes safe_railtypes; ///< rail types of the remembered safe waiting positions
+	uint next;             ///< next check on a tile with the same hash, UINT_MAX if none
+};
+
+static SmallVector<SegmentItem, 256> _segment_recording;      ///< steps of the segment that is being explored
+static SmallVector<SegmentItem, 64> _block_recording;         ///< checks for trains of the segment that is being explored
+static SmallVector<SegmentItem, 1024> _segment_items;         ///< steps of all cached segments
+static SmallVector<CachedSignalSegment, 64> _cached_segments; ///< all cached segments
+static uint _cached_segment_hash[1 << SIG_CACHE_HASH_BITS];   ///< first cached segment for each hash value
+static SmallVector<SignalBlock, 64> _signal_blocks;           ///< signal blocks of all cached segments
+static SmallVector<SignalBlockTile, 256> _signal_block_tiles; ///< checks for trains of all signal blocks
+static uint _signal_block_tile_hash[1 << SIG_CACHE_HASH_BITS]; ///< first check for trains for each hash value of the tiles
+static bool _segment_cache_valid = false;                     ///< whether the cached segments still match the track layout
+
+/**
+ * Forget all cached signal segments. Has to be called whenever the track
+ * layout, signals or ownership of tracks may have changed anywhere on the map.
+ */
+void InvalidateSignalSegmentCache()
+{
+	_segment_cache_valid = false;
+}
+
+/** Empty the cache of signal segments */
+static void ClearSignalSegmentCache()
+{
+	_segment_items.Clear();
+	_cached_segments.Clear();
+	memset(_cached_segment_hash, 0xFF, sizeof(_cached_segment_hash));
+	_signal_blocks.Clear();
+	_signal_block_tiles.Clear();
+	memset(_signal_block_tile_hash, 0xFF, sizeof(_signal_block_tile_hash));
+	_segment_cache_valid = true;
+}
+
+/**
+ * Compute the hash of a tile for the checks for trains of the signal blocks
+ * @param tile the tile
+ * @return hash value
+ */
+static inline uint SignalBlockTileHash(TileIndex tile)
+{
+	return (tile * 0x9E3779B1U) >> (32 - SIG_CACHE_HASH_BITS);
+}
+
+/**
+ * Compute the hash of a _globset item for the cache of signal segments
+ * @param tile tile of the item
+ * @param dir side of the item
+ * @param owner owner whose signals are updated
+ * @return hash value
+ */
+static inline uint SignalSegmentHash(TileIndex tile, DiagDirection dir, Owner owner)
+{
+	uint32 key = (tile << 3 | (dir & 7)) ^ (owner << 24);
+	return (key * 0x9E3779B1U) >> (32 - SIG_CACHE_HASH_BITS);
+}
+
+/**
+ * Remove the checks for trains of invalidated signal blocks from a hash chain
+ * @param tile a tile of the hash chain
+ */
+static void UnlinkInvalidatedSignalBlockTiles(TileIndex tile)
+{
+	uint *i = &_signal_block_tile_hash[SignalBlockTileHash(tile)];
+	while (*i != UINT_MAX) {
+		SignalBlockTile *bt = _signal_block_tiles.Get(*i);
+		if (_signal_blocks[bt->block].owner == INVALID_OWNER) {
+			*i = bt->next;
+		} else {
+			i = &bt->next;
+		}
+	}
+}
+
+/**
+ * Remove invalidated segments from a hash chain of the cached segments
+ * @param hash the hash value of the chain
+ */
+static void UnlinkInvalidatedSignalSegments(uint hash)
+{
+	uint *i = &_cached_segment_hash[hash];
+	while (*i != UINT_MAX) {
+		CachedSignalSegment *seg = _cached_segments.Get(*i);
+		if (seg->owner == INVALID_OWNER) {
+			*i = seg->next;
+		} else {
+			i = &seg->next;
+		}
+	}
+}
+
+/**
+ * Invalidate the signal blocks with checks for trains on a tile
+ * @param tile the tile, only its hash is used so it may be outside the map
+ * @param[out] blocks the invalidated blocks are appended to it
+ */
+static void InvalidateSignalBlocksOnTile(TileIndex tile, SmallVector<uint, 16> *blocks)
+{
+	for (uint i = _signal_block_tile_hash[SignalBlockTileHash(tile)]; i != UINT_MAX; i = _signal_block_tiles[i].next) {
+		const SignalBlockTile *bt = _signal_block_tiles.Get(i);
+		SignalBlock *sb = _signal_blocks.Get(bt->block);
+		if (bt->tile != tile || sb->owner == INVALID_OWNER) continue;
+
+		sb->owner = INVALID_OWNER;
+		sb->trains = 0;
+		*blocks->Append() = bt->block;
+	}
+}
+
+/**
+ * Forget the cached signal segments and signal blocks that might depend on
+ * a tile. Has to be called whenever the track layout, signals, rail type or
+ * ownership of tracks of the tile changed.
+ * The exploration of a segment checks every tile it enters for trains, but it
+ * only looks at the tiles next to them to find where the tracks end, so the
+ * blocks with checks on the tile or next to it are invalidated, together with
+ * all segments of them and the segments that were explored from next to it.
+ * The invalidated entries are only unlinked, their memory is reused when the
+ * cache is emptied because it got too large.
+ * @param tile the changed tile
+ */
+void InvalidateSignalSegmentCache(TileIndex tile)
+{
+	if (!_segment_cache_valid) return;
+
+	SmallVector<uint, 16> blocks;
+	InvalidateSignalBlocksOnTile(tile, &blocks);
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		InvalidateSignalBlocksOnTile(tile + TileOffsByDiagDir(dir), &blocks);
+	}
+
+	/* This also drops what is remembered about the tiles of the blocks. */
+	for (const uint *block = blocks.Begin(); block != blocks.End(); block++) {
+		const SignalBlock *sb = _signal_blocks.Get(*block);
+		for (uint i = sb->first; i != sb->first + sb->checks; i++) {
+			UnlinkInvalidatedSignalBlockTiles(_signal_block_tiles[i].tile);
+		}
+	}
+
+	for (CachedSignalSegment *seg = _cached_segments.Begin(); seg != _cached_segments.End(); seg++) {
+		if (seg->owner == INVALID_OWNER) continue;
+		if (_signal_blocks[seg->block].owner != INVALID_OWNER && DistanceManhattan(seg->tile, tile) > 1) continue;
+
+		uint hash = SignalSegmentHash(seg->tile, seg->dir, seg->owner);
+		seg->owner = INVALID_OWNER;
+		UnlinkInvalidatedSignalSegments(hash);
+	}
+}
+
+/**
+ * Check whether the position of a train matches a check for trains of a signal block
+ * @param bt the check
+ * @param track track of the train on the tile of the check
+ * @return does the check find the train?
+ */
+static inline bool IsTrainOnSignalBlockTile(const SignalBlockTile *bt, TrackBits track)
+{
+	/* The same as HasVehicleOnPos() with TrainOnTileEnum and EnsureNoTrainOnTrackBits() respectively. */
+	if (bt->type == SIT_TRAIN_ON_TILE) return track != TRACK_BIT_DEPOT;
+	return track == bt->tracks || TracksOverlap(track | (TrackBits)bt->tracks);
+}
+
+/** Data for counting the trains matching a check for trains of a signal block */
+struct SignalBlockTileCount {
+	const SignalBlockTile *bt; ///< the check
+	uint trains;               ///< number of trains found
+};
+
+/** Count a train that matches a check for trains of a signal block by its position in the signal blocks */
+static Vehicle *CountTrainsOnSignalBlockTileEnum(Vehicle *v, void *data)
+{
+	SignalBlockTileCount *count = (SignalBlockTileCount *)data;
+	if (v->type != VEH_TRAIN) return NULL;
+
+	const Train *t = Train::From(v);
+	if (t->signal_block_tile == count->bt->tile && IsTrainOnSignalBlockTile(count->bt, t->signal_block_track)) count->trains++;
+	return NULL;
+}
+
+/**
+ * Count the trains that match a check for trains of a signal block
+ * @param bt the check
+ * @return number of trains (parts)
+ */
+static uint CountTrainsOnSignalBlockTile(const SignalBlockTile *bt)
+{
+	SignalBlockTileCount count = { bt, 0 };
+	FindVehicleOnPos(bt->tile, &count, &CountTrainsOnSignalBlockTileEnum);
+	return count.trains;
+}
+
+/**
+ * Add or remove a train at a position to the occupancy of the signal blocks
+ * @param tile tile of the train, INVALID_TILE if none
+ * @param track track of the train
+ * @param delta 1 to add the train, -1 to remove it
+ */
+static void ChangeSignalBlockOccupancy(TileIndex tile, TrackBits track, int delta)
+{
+	if (tile == INVALID_TILE) return;
+
+	for (uint i = _signal_block_tile_hash[SignalBlockTileHash(tile)]; i != UINT_MAX; i = _signal_block_tiles[i].next) {
+		const SignalBlockTile *bt = _signal_block_tiles.Get(i);
+		if (bt->tile == tile && IsTrainOnSignalBlockTile(bt, track)) _signal_blocks[bt->block].trains += delta;
+	}
+}
+
+/**
+ * Update the position of a train (part) in the occupancy of the signal blocks.
+ * Has to be called whenever its tile, its track or its place in the tile hash
+ * of the vehicles changed, as the searches for trains only find it when it is
+ * in the tile hash of its tile.
+ * @param t the train (part)
+ */
+void UpdateSignalBlockOccupancy(Train *t)
+{
+	TileIndex tile = GetVehicleTileInHash(t);
+	TrackBits track = (tile == INVALID_TILE) ? TRACK_BIT_NONE : (TrackBits)t->track;
+	if (tile == t->signal_block_tile && track == t->signal_block_track) return;
+
+	/* Without valid cache the blocks are counted again when they are cached. */
+	if (_segment_cache_valid) {
+		ChangeSignalBlockOccupancy(t->signal_block_tile, t->signal_block_track, -1);
+		ChangeSignalBlockOccupancy(tile, track, 1);
+	}
+
+	t->signal_block_tile = tile;
+	t->signal_block_track = track;
+}
+
+/**
+ * Check whether the trains are counted correctly in the occupancy of the
+ * signal blocks. Mismatches are reported for debugging desyncs.
+ */
+void CheckSignalBlockOccupancy()
+{
+	const Train *t;
+	FOR_ALL_TRAINS(t) {
+		TileIndex tile = GetVehicleTileInHash(t);
+		if (t->signal_block_tile != tile || (tile != INVALID_TILE && t->signal_block_track != t->track)) {
+			DEBUG(desync, 2, "signal block position mismatch: vehicle %i, company %i", t->index, (int)t->owner);
+		}
+	}
+
+	if (!_segment_cache_valid) return;
+
+	uint *trains = CallocT<uint>(_signal_blocks.Length());
+	for (const SignalBlockTile *bt = _signal_block_tiles.Begin(); bt != _signal_block_tiles.End(); bt++) {
+		if (_signal_blocks[bt->block].owner != INVALID_OWNER) trains[bt->block] += CountTrainsOnSignalBlockTile(bt);
+	}
+	for (uint i = 0; i < _signal_blocks.Length(); i++) {
+		if (trains[i] != _signal_blocks[i].trains) {
+			DEBUG(desync, 2, "signal block occupancy mismatch: block %i, company %i, counted %i, found %i", i, (int)_signal_blocks[i].owner, _signal_blocks[i].trains, trains[i]);
+		}
+	}
+	free(trains);
+}
+
+/**
+ * Check whether a check for trains is on a signal, so it can be part of two signal blocks
+ * @param item the check
+ * @return is there a signal?
+ */
+static inline bool IsSignalBlockBoundary(const SegmentItem *item)
+{
+	if (!IsTileType(item->tile, MP_RAILWAY) || IsRailDepot(item->tile)) return false;
+	if (item->type == SIT_TRAIN_ON_TRACK) return HasSignalOnTrack(item->tile, FindFirstTrack((TrackBits)item->data));
+	return HasSignals(item->tile);
+}
+
+/**
+ * Find the signal block of the segment that was just explored, or add it to the cache
+ * @param owner owner whose signals were updated
+ * @return index of the block in _signal_blocks
+ */
+static uint FindOrAddSignalBlock(Owner owner)
+{
+	/* Tracks without signals are part of only one block, so the first of them
+	 * that was checked for trains tells whether the block is known already. */
+	for (const SegmentItem *item = _block_recording.Begin(); item != _block_recording.End(); item++) {
+		if (IsSignalBlockBoundary(item)) continue;
+
+		for (uint i = _signal_block_tile_hash[SignalBlockTileHash(item->tile)]; i != UINT_MAX; i = _signal_block_tiles[i].next) {
+			const SignalBlockTile *bt = _signal_block_tiles.Get(i);
+			if (bt->tile == item->tile && bt->type == item->type && bt->tracks == item->data &&
+					_signal_blocks[bt->block].checks == _block_recording.Length()) {
+				return bt->block;
+			}
+		}
+		break;
+	}
+
+	uint block = _signal_blocks.Length();
+	SignalBlock *sb = _signal_blocks.Append();
+	sb->owner = owner;
+	sb->first = _signal_block_tiles.Length();
+	sb->checks = _block_recording.Length();
+	sb->trains = 0;
+
+	for (const SegmentItem *item = _block_recording.Begin(); item != _block_recording.End(); item++) {
+		uint hash = SignalBlockTileHash(item->tile);
+
+		SignalBlockTile *bt = _signal_block_tiles.Append();
+		bt->tile = item->tile;
+		bt->block = block;
+		bt->type = item->type;
+		bt->tracks = item->data;
+		bt->safe_options = 0;
+		bt->safe_known = 0;
+		bt->safe = 0;
+		bt->safe_railtypes = RAILTYPES_NONE;
+		bt->next = _signal_block_tile_hash[hash];
+		_signal_block_tile_hash[hash] = _signal_block_tiles.Length() - 1;
+
+		sb->trains += CountTrainsOnSignalBlockTile(bt);
+	}
+
+	return block;
+}
+
+/**
+ * Find the check for trains on a tile, to remember things about the tile
+ * @param tile the tile
+ * @param owner owner the remembered things are valid for
+ * @return the first check on the tile, NULL if none
+ */
+static SignalBlockTile *FindSignalBlockTile(TileIndex tile, Owner owner)
+{
+	if (!_segment_cache_valid) return NULL;
+
+	for (uint i = _signal_block_tile_hash[SignalBlockTileHash(tile)]; i != UINT_MAX; i = _signal_block_tiles[i].next) {
+		SignalBlockTile *bt = _signal_block_tiles.Get(i);
+		if (bt->tile == tile) return _signal_blocks[bt->block].owner == owner ? bt : NULL;
+	}
+	return NULL;
+}
+
+/**
+ * Look up whether a trackdir was found to be a safe waiting position before.
+ * Only the part of IsSafeWaitingPosition() that follows the track to the next
+ * tile is remembered, as that only depends on the track layout.
+ * @param tile the tile
+ * @param trackdir the trackdir
+ * @param owner owner of the train
+ * @param railtypes rail types the train can use
+ * @param include_line_end Should end-of-line tiles be considered safe?
+ * @param forbid_90deg Don't allow trains to make 90 degree turns
+ * @param[out] safe whether the position is safe
+ * @return is it known whether the position is safe?
+ */
+bool GetRememberedSafeWaitingPosition(TileIndex tile, Trackdir trackdir, Owner owner, RailTypes railtypes, bool include_line_end, bool forbid_90deg, bool *safe)
+{
+	const SignalBlockTile *bt = FindSignalBlockTile(tile, owner);
+	if (bt == NULL || bt->safe_railtypes != railtypes || bt->safe_options != (include_line_end | forbid_90deg << 1)) return false;
+	if (!HasBit(bt->safe_known, trackdir)) return false;
+
+	*safe = HasBit(bt->safe, trackdir);
+	return true;
+}
+
+/**
+ * Remember whether a trackdir is a safe waiting position, see GetRememberedSafeWaitingPosition().
+ * @param tile the tile
+ * @param trackdir the trackdir
+ * @param owner owner of the train
+ * @param railtypes rail types the train can use
+ * @param include_line_end Should end-of-line tiles be considered safe?
+ * @param forbid_90deg Don't allow trains to make 90 degree turns
+ * @param safe whether the position is safe
+ */
+void RememberSafeWaitingPosition(TileIndex tile, Trackdir trackdir, Owner owner, RailTypes railtypes, bool include_line_end, bool forbid_90deg, bool safe)
+{
+	SignalBlockTile *bt = FindSignalBlockTile(tile, owner);
+	if (bt == NULL) return;
+
+	byte options = include_line_end | forbid_90deg << 1;
+	if (bt->safe_railtypes != railtypes || bt->safe_options != options) {
+		bt->safe_railtypes = railtypes;
+		bt->safe_options = options;
+		bt->safe_known = 0;
+		bt->safe = 0;
+	}
+
+	SetBit(bt->safe_known, trackdir);
+	SB(bt->safe, trackdir, 1, safe);
+}
+
+/**
+ * Find the segment that was explored from the given _globset item
+ * @param tile tile of the item
+ * @param dir side of the item
+ * @param owner owner whose signals are updated
+ * @return the cached segment, NULL if none
+ */
+static const CachedSignalSegment *FindCachedSignalSegment(TileIndex tile, DiagDirection dir, Owner owner)
 {
-	if (v->type != VEH_TRAIN || Train::From(v)->track == TRACK_BIT_DEPOT) return NULL;
+	if (!_segment_cache_valid) ClearSignalSegmentCache();
 
-	return v;
+	for (uint i = _cached_segment_hash[SignalSegmentHash(tile, dir, owner)]; i != UINT_MAX; i = _cached_segments[i].next) {
+		const CachedSignalSegment *seg = _cached_segments.Get(i);
+		if (seg->tile == tile && seg->dir == dir && seg->owner == owner) return seg;
+	}
+	return NULL;
+}
+
+/**
+ * Remember the segment that was just explored from the given _globset item
+ * @param tile tile of the item
+ * @param dir side of the item
+ * @param owner owner whose signals were updated
+ * @param flags result of the exploration
+ * @return the cached segment
+ * @pre the exploration did not overflow any set
+ */
+static const CachedSignalSegment *CacheSignalSegment(TileIndex tile, DiagDirection dir, Owner owner, SigFlags flags)
+{
+	assert(!(flags & SF_FULL));
+	if (_segment_items.Length() + _segment_recording.Length() + _signal_block_tiles.Length() + _block_recording.Length() > SIG_CACHE_MAX_ITEMS) {
+		ClearSignalSegmentCache();
+	}
+
+	uint hash = SignalSegmentHash(tile, dir, owner);
+
+	CachedSignalSegment *seg = _cached_segments.Append();
+	seg->tile = tile;
+	seg->dir = dir;
+	seg->owner = owner;
+	seg->flags = flags & SF_PBS;
+	seg->first = _segment_items.Length();
+	seg->last = seg->first + _segment_recording.Length();
+	seg->block = FindOrAddSignalBlock(owner);
+	seg->next = _cached_segment_hash[hash];
+	_cached_segment_hash[hash] = _cached_segments.Length() - 1;
+
+	MemCpyT(_segment_items.Append(_segment_recording.Length()), _segment_recording.Begin(), _segment_recording.Length());
+	return seg;
+}
+
+/**
+ * Remember a step of exploring the current segment
+ * @param type type of the step
+ * @param tile tile of the step
+ * @param data data of the step
+ */
+static inline void RecordSegmentItem(SegmentItemType type, TileIndex tile, byte data)
+{
+	SegmentItem *item = (type == SIT_TRAIN_ON_TILE || type == SIT_TRAIN_ON_TRACK) ? _block_recording.Append() : _segment_recording.Append();
+	item->tile = tile;
+	item->type = type;
+	item->data = data;
+}
+
+/**
+ * Update the presignal exit flags of a segment for an exit signal
+ * @param tile tile of the signal
+ * @param trackdir trackdir of the signal
+ * @param flags flags of the segment
+ */
+static inline void CheckPresignalExit(TileIndex tile, Trackdir trackdir, SigFlags *flags)
+{
+	/* if we haven't found 2 green exits yet, do special check */
+	if (*flags & SF_GREEN2) return;
+
+	if (*flags & SF_EXIT) *flags |= SF_EXIT2; // found two (or more) exits
+	*flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+	if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+		if (*flags & SF_GREEN) *flags |= SF_GREEN2;
+		*flags |= SF_GREEN;
+	}
 }
 
 
@@ -211,6 +751,9 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
  */
 static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
+	RecordSegmentItem(SIT_GLOBSET, t1, d1);
+	RecordSegmentItem(SIT_GLOBSET, t2, d2);
+
 	_globset.Remove(t1, d1); // it can be in Global but not in Todo
 	_globset.Remove(t2, d2); // remove in all cases
 
@@ -243,23 +786,11 @@ static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
 }
 
 
-/** Current signal block state flags */
-enum SigFlags {
-	SF_NONE   = 0,
-	SF_TRAIN  = 1 << 0, ///< train found in segment
-	SF_EXIT   = 1 << 1, ///< exitsignal found
-	SF_EXIT2  = 1 << 2, ///< two or more exits found
-	SF_GREEN  = 1 << 3, ///< green exitsignal found
-	SF_GREEN2 = 1 << 4, ///< two or more green exits found
-	SF_FULL   = 1 << 5, ///< some of buffers was full, do not continue
-	SF_PBS    = 1 << 6, ///< pbs signal found
-};
-
-DECLARE_ENUM_AS_BIT_SET(SigFlags)
-
-
 /**
  * Search signal block
+ * The steps taken are remembered in _segment_recording, the checks
+ * for trains in _block_recording. Trains are not searched for here,
+ * SF_TRAIN is set from the occupancy of the signal block.
  *
  * @param owner owner whose signals we are updating
  * @return SigFlags
@@ -268,6 +799,9 @@ static SigFlags ExploreSegment(Owner owner)
 {
 	SigFlags flags = SF_NONE;
 
+	_segment_recording.Clear();
+	_block_recording.Clear();
+
 	TileIndex tile;
 	DiagDirection enterdir;
 
@@ -281,13 +815,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 						continue;
 					} else {
 						continue;
@@ -299,11 +833,10 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					RecordSegmentItem(SIT_TRAIN_ON_TRACK, tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -320,18 +853,16 @@ static SigFlags ExploreSegment(Owner owner)
 								flags |= SF_PBS;
 							} else if (!_tbuset.Add(tile, reversedir)) {
 								return flags | SF_FULL;
+							} else {
+								RecordSegmentItem(SIT_SIGNAL, tile, reversedir);
 							}
 						}
 						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
 
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
-							}
+						/* if it is a presignal EXIT in OUR direction, do special check */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
+							RecordSegmentItem(SIT_PRESIGNAL_EXIT, tile, trackdir);
+							CheckPresignalExit(tile, trackdir, &flags);
 						}
 
 						continue;
@@ -355,7 +886,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -364,7 +895,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -374,13 +905,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					RecordSegmentItem(SIT_TRAIN_ON_TILE, tile, TRACK_BIT_NONE);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -399,6 +930,41 @@ static SigFlags ExploreSegment(Owner owner)
 }
 
 
+/**
+ * Repeat the steps of exploring a cached signal segment, without searching
+ * the segment again. The result is the same as that of ExploreSegment().
+ * The trains are not searched for either, the occupancy of the signal
+ * block of the segment tells whether there are any.
+ *
+ * @param seg the cached segment
+ * @return SigFlags
+ */
+static SigFlags ReplaySegment(const CachedSignalSegment *seg)
+{
+	SigFlags flags = seg->flags;
+
+	for (const SegmentItem *item = _segment_items.Get(seg->first); item != _segment_items.Get(seg->last); item++) {
+		switch (item->type) {
+			case SIT_GLOBSET:
+				_globset.Remove(item->tile, (DiagDirection)item->data);
+				break;
+
+			case SIT_PRESIGNAL_EXIT:
+				CheckPresignalExit(item->tile, (Trackdir)item->data, &flags);
+				break;
+
+			case SIT_SIGNAL:
+				_tbuset.Add(item->tile, (Trackdir)item->data);
+				break;
+
+			default: NOT_REACHED();
+		}
+	}
+
+	return flags;
+}
+
+
 /**
  * Update signals around segment in _tbuset
  *
@@ -459,8 +1025,71 @@ static inline void ResetSets()
 }
 
 
+/**
+ * Add the places to start exploring a segment from a _globset item to _tbdset
+ *
+ * @param tile tile of the item
+ * @param dir side of the item
+ * @return false iff there is no track to start from
+ */
+static bool AddSegmentStartToTodoSet(TileIndex tile, DiagDirection dir)
+{
+	/* After updating signal, data stored are always MP_RAILWAY with signals.
+	 * Other situations happen when data are from outside functions -
+	 * modification of railbits (including both rail building and removal),
+	 * train entering/leaving block, train leaving depot...
+	 */
+	switch (GetTileType(tile)) {
+		case MP_TUNNELBRIDGE:
+			/* 'optimization assert' - do not try to update signals when it is not needed */
+			assert(GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL);
+			assert(dir == INVALID_DIAGDIR || dir == ReverseDiagDir(GetTunnelBridgeDirection(tile)));
+			_tbdset.Add(tile, INVALID_DIAGDIR);  // we can safely start from wormhole centre
+			_tbdset.Add(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR);
+			break;
+
+		case MP_RAILWAY:
+			if (IsRailDepot(tile)) {
+				/* 'optimization assert' do not try to update signals in other cases */
+				assert(dir == INVALID_DIAGDIR || dir == GetRailDepotDirection(tile));
+				_tbdset.Add(tile, INVALID_DIAGDIR); // start from depot inside
+				break;
+			}
+			/* FALL THROUGH */
+		case MP_STATION:
+		case MP_ROAD:
+			if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
+				/* only add to set when there is some 'interesting' track */
+				_tbdset.Add(tile, dir);
+				_tbdset.Add(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
+				break;
+			}
+			/* FALL THROUGH */
+		default:
+			/* jump to next tile */
+			tile = tile + TileOffsByDiagDir(dir);
+			dir = ReverseDiagDir(dir);
+			if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
+				_tbdset.Add(tile, dir);
+				break;
+			}
+			/* happens when removing a rail that wasn't connected at one or both sides */
+			return false;
+	}
+
+	assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
+	assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
+
+	return true;
+}
+
+
 /**
  * Updates blocks in _globset buffer
+ * Segments are explored only once as long as the track layout does not change;
+ * later updates of a segment from the same _globset item repeat the steps
+ * remembered in the cache, and take the trains in the segment from the
+ * occupancy of its signal block.
  *
  * @param owner company whose signals we are updating
  * @return state of the first block from _globset
@@ -480,53 +1109,19 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
-		/* After updating signal, data stored are always MP_RAILWAY with signals.
-		 * Other situations happen when data are from outside functions -
-		 * modification of railbits (including both rail building and removal),
-		 * train entering/leaving block, train leaving depot...
-		 */
-		switch (GetTileType(tile)) {
-			case MP_TUNNELBRIDGE:
-				/* 'optimization assert' - do not try to update signals when it is not needed */
-				assert(GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL);
-				assert(dir == INVALID_DIAGDIR || dir == ReverseDiagDir(GetTunnelBridgeDirection(tile)));
-				_tbdset.Add(tile, INVALID_DIAGDIR);  // we can safely start from wormhole centre
-				_tbdset.Add(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR);
-				break;
+		SigFlags flags;
+		const CachedSignalSegment *seg = FindCachedSignalSegment(tile, dir, owner);
+		if (seg != NULL) {
+			flags = ReplaySegment(seg);
+		} else {
+			if (!AddSegmentStartToTodoSet(tile, dir)) continue;
 
-			case MP_RAILWAY:
-				if (IsRailDepot(tile)) {
-					/* 'optimization assert' do not try to update signals in other cases */
-					assert(dir == INVALID_DIAGDIR || dir == GetRailDepotDirection(tile));
-					_tbdset.Add(tile, INVALID_DIAGDIR); // start from depot inside
-					break;
-				}
-				/* FALL THROUGH */
-			case MP_STATION:
-			case MP_ROAD:
-				if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
-					/* only add to set when there is some 'interesting' track */
-					_tbdset.Add(tile, dir);
-					_tbdset.Add(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
-					break;
-				}
-				/* FALL THROUGH */
-			default:
-				/* jump to next tile */
-				tile = tile + TileOffsByDiagDir(dir);
-				dir = ReverseDiagDir(dir);
-				if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
-					_tbdset.Add(tile, dir);
-					break;
-				}
-				/* happens when removing a rail that wasn't connected at one or both sides */
-				continue; // continue the while() loop
+			flags = ExploreSegment(owner);
+			if (!(flags & SF_FULL)) seg = CacheSignalSegment(tile, dir, owner, flags);
 		}
 
-		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
-		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
-
-		SigFlags flags = ExploreSegment(owner);
+		/* Whether there is a train only matters when no set overflowed. */
+		if (seg != NULL && _signal_blocks[seg->block].trains != 0) flags |= SF_TRAIN;
 
 		if (first) {
 			first = false;
@@ -552,6 +1147,7 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 
 
 static Owner _last_owner = INVALID_OWNER; ///< last owner whose track was put into _globset
+static bool _discard_signal_updates = false; ///< whether the buffer is emptied without updating the signals
 
 
 /**
@@ -561,20 +1157,76 @@ static Owner _last_owner = INVALID_OWNER; ///< last owner whose track was put in
 void UpdateSignalsInBuffer()
 {
 	if (!_globset.IsEmpty()) {
-		UpdateSignalsInBuffer(_last_owner);
+		if (_discard_signal_updates) {
+			_globset.Reset();
+		} else {
+			UpdateSignalsInBuffer(_last_owner);
+		}
 		_last_owner = INVALID_OWNER; // invalidate
 	}
 }
 
+/**
+ * Start or stop discarding the updates of the signal buffer, for changes
+ * to the tracks that are undone before the signals matter again. The
+ * signals to update may be anywhere on the map, so they could not be
+ * undone as easily.
+ * @param discard Whether to discard the updates from now on.
+ */
+void SetSignalUpdatesDiscarded(bool discard)
+{
+	/* Updates that were pending before are not discarded. */
+	if (discard) UpdateSignalsInBuffer();
+
+	_globset.Reset();
+	_last_owner = INVALID_OWNER;
+	_discard_signal_updates = discard;
+}
+
 
 /**
- * Add track to signal update buffer
+ * Prepare adding items of a company to the signal update buffer.
+ * Updates for another company that are still pending are done
+ * first, as only the signals of one company are updated in one run.
+ *
+ * @param owner owner whose signals we will update
+ */
+static void SetSignalBufferOwner(Owner owner)
+{
+	if (!_globset.IsEmpty() && owner != _last_owner) UpdateSignalsInBuffer();
+
+	_last_owner = owner;
+}
+
+/**
+ * Add side of tile to signal update buffer, without invalidating the cached segments
+ * Items that are in the buffer already are not added again.
+ *
+ * @param tile tile where we start
+ * @param side side of tile
+ * @param owner owner whose signals we will update
+ */
+static void AddSideToGlobset(TileIndex tile, DiagDirection side, Owner owner)
+{
+	SetSignalBufferOwner(owner);
+
+	_globset.Add(tile, side, true);
+
+	if (_globset.Items() >= SIG_GLOB_UPDATE) {
+		/* too many items, force update */
+		UpdateSignalsInBuffer();
+	}
+}
+
+/**
+ * Add track to signal update buffer, without invalidating the cached segments
+ * Items that are in the buffer already are not added again.
  *
  * @param tile tile where we start
  * @param track track at which ends we will update signals
  * @param owner owner whose signals we will update
  */
-void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
+static void AddTrackToGlobset(TileIndex tile, Track track, Owner owner)
 {
 	static const DiagDirection _search_dir_1[] = {
 		DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_NE, DIAGDIR_SE, DIAGDIR_SW, DIAGDIR_SE
@@ -583,24 +1235,30 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
 		DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NW, DIAGDIR_SW, DIAGDIR_NW, DIAGDIR_NE
 	};
 
-	/* do not allow signal updates for two companies in one run */
-	assert(_globset.IsEmpty() || owner == _last_owner);
-
-	_last_owner = owner;
-
-	_globset.Add(tile, _search_dir_1[track]);
-	_globset.Add(tile, _search_dir_2[track]);
+	AddSideToGlobset(tile, _search_dir_1[track], owner);
+	AddSideToGlobset(tile, _search_dir_2[track], owner);
+}
 
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
+/**
+ * Add track to signal update buffer
+ * The track layout of the tile is assumed to have changed, so the cached segments around it are invalidated.
+ * Items that are in the buffer already are not added again.
+ *
+ * @param tile tile where we start
+ * @param track track at which ends we will update signals
+ * @param owner owner whose signals we will update
+ */
+void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
+{
+	InvalidateSignalSegmentCache(tile);
+	AddTrackToGlobset(tile, track, owner);
 }
 
 
 /**
  * Add side of tile to signal update buffer
+ * The track layout of the tile is assumed to have changed, so the cached segments around it are invalidated.
+ * Items that are in the buffer already are not added again.
  *
  * @param tile tile where we start
  * @param side side of tile
@@ -608,18 +1266,8 @@ void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner)
  */
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 {
-	/* do not allow signal updates for two companies in one run */
-	assert(_globset.IsEmpty() || owner == _last_owner);
-
-	_last_owner = owner;
-
-	_globset.Add(tile, side);
-
-	if (_globset.Items() >= SIG_GLOB_UPDATE) {
-		/* too many items, force update */
-		UpdateSignalsInBuffer(_last_owner);
-		_last_owner = INVALID_OWNER;
-	}
+	InvalidateSignalSegmentCache(tile);
+	AddSideToGlobset(tile, side, owner);
 }
 
 /**
@@ -634,16 +1282,37 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
  */
 SigSegState UpdateSignalsOnSegment(TileIndex tile, DiagDirection side, Owner owner)
 {
-	assert(_globset.IsEmpty());
+	/* The state of only this segment is returned, so do the pending updates first. */
+	UpdateSignalsInBuffer();
+
 	_globset.Add(tile, side);
 
 	return UpdateSignalsInBuffer(owner);
 }
 
 
+/**
+ * Update signals, starting at one side of a tile, with the next update
+ * of the buffer, i.e. at the latest after all vehicles moved this tick.
+ * Updates of the same segment are done only once then. As the signals
+ * stay as they are until then, this may only be used when a train left
+ * the segment, which can not turn any signal red.
+ *
+ * @see UpdateSignalsOnSegment()
+ * @param tile tile where we start
+ * @param side side of tile
+ * @param owner owner whose signals we will update
+ */
+void UpdateSignalsOnSegmentLater(TileIndex tile, DiagDirection side, Owner owner)
+{
+	AddSideToGlobset(tile, side, owner);
+}
+
+
 /**
  * Update signals at segments that are at both ends of
- * given (existent or non-existent) track
+ * given (existent or non-existent) track, like
+ * UpdateSignalsOnSegmentLater() does for one segment.
  *
  * @see UpdateSignalsInBuffer()
  * @param tile tile where we start
@@ -652,8 +1321,5 @@ SigSegState UpdateSignalsOnSegment(TileIndex tile, DiagDirection side, Owner own
  */
 void SetSignalsOnBothDir(TileIndex tile, Track track, Owner owner)
 {
-	assert(_globset.IsEmpty());
-
-	AddTrackToSignalBuffer(tile, track, owner);
-	UpdateSignalsInBuffer(owner);
+	AddTrackToGlobset(tile, track, owner);
 }
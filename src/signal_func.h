@@ -16,6 +16,8 @@
 #include "tile_type.h"
 #include "direction_type.h"
 #include "company_type.h"
+#include "rail_type.h"
+#include "vehicle_type.h"
 
 /**
  * Maps a trackdir to the bit that stores its status in the map arrays, in the
@@ -55,9 +57,17 @@ enum SigSegState {
 };
 
 SigSegState UpdateSignalsOnSegment(TileIndex tile, DiagDirection side, Owner owner);
+void UpdateSignalsOnSegmentLater(TileIndex tile, DiagDirection side, Owner owner);
 void SetSignalsOnBothDir(TileIndex tile, Track track, Owner owner);
 void AddTrackToSignalBuffer(TileIndex tile, Track track, Owner owner);
 void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner);
 void UpdateSignalsInBuffer();
+void SetSignalUpdatesDiscarded(bool discard);
+void InvalidateSignalSegmentCache();
+void InvalidateSignalSegmentCache(TileIndex tile);
+void UpdateSignalBlockOccupancy(Train *t);
+void CheckSignalBlockOccupancy();
+bool GetRememberedSafeWaitingPosition(TileIndex tile, Trackdir trackdir, Owner owner, RailTypes railtypes, bool include_line_end, bool forbid_90deg, bool *safe);
+void RememberSafeWaitingPosition(TileIndex tile, Trackdir trackdir, Owner owner, RailTypes railtypes, bool include_line_end, bool forbid_90deg, bool safe);
 
 #endif /* SIGNAL_FUNC_H */
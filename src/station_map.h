@@ -81,6 +81,7 @@ static inline StationGfx GetStationGfx(TileIndex t)
 static inline void SetStationGfx(TileIndex t, StationGfx gfx)
 {
 	assert(IsTileType(t, MP_STATION));
+	NotifyTileChange(t);
 	_m[t].m5 = gfx;
 }
 
@@ -406,7 +407,9 @@ static inline bool HasStationReservation(TileIndex t)
 static inline void SetRailStationReservation(TileIndex t, bool b)
 {
 	assert(HasStationRail(t));
+	NotifyTileChange(t);
 	SB(_m[t].m6, 2, 1, b ? 1 : 0);
+	NotifyReservationChange(t);
 }
 
 /**
@@ -482,6 +485,7 @@ static inline bool IsCustomStationSpecIndex(TileIndex t)
 static inline void SetCustomStationSpecIndex(TileIndex t, byte specindex)
 {
 	assert(HasStationTileRail(t));
+	NotifyTileChange(t);
 	_m[t].m4 = specindex;
 }
 
@@ -506,6 +510,7 @@ static inline uint GetCustomStationSpecIndex(TileIndex t)
 static inline void SetStationTileRandomBits(TileIndex t, byte random_bits)
 {
 	assert(IsTileType(t, MP_STATION));
+	NotifyTileChange(t);
 	SB(_m[t].m3, 4, 4, random_bits);
 }
 
@@ -532,6 +537,7 @@ static inline byte GetStationTileRandomBits(TileIndex t)
  */
 static inline void MakeStation(TileIndex t, Owner o, StationID sid, StationType st, byte section, WaterClass wc = WATER_CLASS_INVALID)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_STATION);
 	SetTileOwner(t, o);
 	SetWaterClass(t, wc);
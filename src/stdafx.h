@@ -246,6 +246,25 @@
 	#define strdup _strdup
 #endif /* WINCE */
 
+/* Functions that use instructions the rest of the programme is not compiled for, e.g. SSSE3.
+ * GCC and clang need to be told per function; MSVC always accepts the intrinsics. */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+	#define GNU_TARGET(x) __attribute__ ((target (x)))
+	#define WITH_GNU_TARGET
+#else
+	#define GNU_TARGET(x)
+#endif
+
+/* The SSE blitters need an x86 processor, and a compiler that can build them without enabling SSE for everything. */
+#if (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)) && (defined(WITH_GNU_TARGET) || (defined(_MSC_VER) && _MSC_VER >= 1500) || defined(__SSSE3__))
+	#define WITH_SSE
+#endif
+
+/* The AVX2 blitters also need a compiler that knows the AVX2 instructions. */
+#if defined(WITH_SSE) && (defined(WITH_GNU_TARGET) || (defined(_MSC_VER) && _MSC_VER >= 1700) || defined(__AVX2__))
+	#define WITH_AVX2
+#endif
+
 /* NOTE: the string returned by these functions is only valid until the next
  * call to the same function and is not thread- or reentrancy-safe */
 #if !defined(STRGEN) && !defined(SETTINGSGEN)
@@ -0,0 +1,164 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Implementation of the pool of worker threads. */
+
+#include "../stdafx.h"
+#include "../core/alloc_func.hpp"
+#include "thread_pool.h"
+
+/**
+ * Create a pool and start its worker threads.
+ * @param num_workers Number of worker threads to start. Less threads are
+ *                    started if the operating system does not allow more.
+ */
+ThreadPool::ThreadPool(uint num_workers) :
+	workers(NULL),
+	num_workers(0),
+	proc(NULL),
+	items(NULL),
+	count(0),
+	next(0),
+	done(0),
+	exit(false)
+{
+	this->work_mutex = ThreadMutex::New();
+	this->done_mutex = ThreadMutex::New();
+
+	if (num_workers == 0) return;
+	this->workers = MallocT<ThreadObject *>(num_workers);
+	while (this->num_workers < num_workers && ThreadObject::New(&ThreadPool::WorkerThread, this, &this->workers[this->num_workers])) {
+		this->num_workers++;
+	}
+}
+
+/**
+ * Stop all worker threads and wait for them to terminate.
+ */
+ThreadPool::~ThreadPool()
+{
+	this->work_mutex->BeginCritical();
+	this->exit = true;
+	this->work_mutex->SendSignal();
+	this->work_mutex->EndCritical();
+
+	for (uint i = 0; i < this->num_workers; i++) {
+		this->workers[i]->Join();
+		delete this->workers[i];
+	}
+	free(this->workers);
+
+	delete this->work_mutex;
+	delete this->done_mutex;
+}
+
+/**
+ * Take the next unprocessed item of the current batch and process it.
+ * @return False if there were no more items to take.
+ */
+bool ThreadPool::ProcessNextItem()
+{
+	this->work_mutex->BeginCritical();
+	if (this->next >= this->count) {
+		this->work_mutex->EndCritical();
+		return false;
+	}
+	void *item = this->items[this->next++];
+	ThreadPoolJobProc proc = this->proc;
+	this->work_mutex->EndCritical();
+
+	proc(item);
+
+	this->done_mutex->BeginCritical();
+	if (++this->done == this->count) this->done_mutex->SendSignal();
+	this->done_mutex->EndCritical();
+	return true;
+}
+
+/**
+ * Main loop of the worker threads.
+ * @param data The pool the worker belongs to.
+ */
+/* static */ void ThreadPool::WorkerThread(void *data)
+{
+	ThreadPool *pool = (ThreadPool *)data;
+
+	pool->work_mutex->BeginCritical();
+	for (;;) {
+		while (!pool->exit && pool->next >= pool->count) pool->work_mutex->WaitForSignal();
+		if (pool->exit) break;
+
+		/* A signal only wakes one waiting worker; pass it on so all of them join in. */
+		pool->work_mutex->SendSignal();
+		pool->work_mutex->EndCritical();
+
+		while (pool->ProcessNextItem()) {}
+
+		pool->work_mutex->BeginCritical();
+	}
+	/* Pass the exit request on to the next worker. */
+	pool->work_mutex->SendSignal();
+	pool->work_mutex->EndCritical();
+}
+
+/**
+ * Process a batch of items, using all worker threads and the calling thread.
+ * The items have to be independent of each other as they are processed in an
+ * undefined order. Only one batch can be run at a time.
+ * @param proc  Function to call for each item.
+ * @param items The items to process.
+ * @param count Number of items.
+ */
+void ThreadPool::Run(ThreadPoolJobProc proc, void **items, uint count)
+{
+	if (this->num_workers == 0 || count <= 1) {
+		for (uint i = 0; i < count; i++) proc(items[i]);
+		return;
+	}
+
+	this->done_mutex->BeginCritical();
+	this->done = 0;
+	this->done_mutex->EndCritical();
+
+	this->work_mutex->BeginCritical();
+	this->proc = proc;
+	this->items = items;
+	this->count = count;
+	this->next = 0;
+	this->work_mutex->SendSignal();
+	this->work_mutex->EndCritical();
+
+	while (this->ProcessNextItem()) {}
+
+	this->done_mutex->BeginCritical();
+	while (this->done < count) this->done_mutex->WaitForSignal();
+	this->done_mutex->EndCritical();
+
+	this->work_mutex->BeginCritical();
+	this->items = NULL;
+	this->count = 0;
+	this->next = 0;
+	this->work_mutex->EndCritical();
+}
+
+/**
+ * Get the pool shared by the game. It is created on first use with one
+ * worker for each processor core besides the one of the calling thread.
+ * @note Only to be called from the main thread.
+ * @return The shared pool.
+ */
+/* static */ ThreadPool *ThreadPool::Get()
+{
+	static ThreadPool *pool = NULL;
+	if (pool == NULL) {
+		uint cores = GetCPUCoreCount();
+		pool = new ThreadPool(cores > 1 ? cores - 1 : 0);
+	}
+	return pool;
+}
@@ -0,0 +1,62 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.h Pool of worker threads for running batches of independent jobs. */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "thread.h"
+
+/** Definition of the function run for each item of a batch. */
+typedef void (*ThreadPoolJobProc)(void *item);
+
+/**
+ * A fixed set of worker threads that process batches of independent items.
+ * The thread calling #Run takes part in the work and only returns when all
+ * items of the batch have been processed. If no threads can be created, the
+ * whole batch is simply processed by the calling thread.
+ */
+class ThreadPool {
+public:
+	ThreadPool(uint num_workers);
+	~ThreadPool();
+
+	void Run(ThreadPoolJobProc proc, void **items, uint count);
+
+	/**
+	 * Get the number of worker threads, not counting the thread calling #Run.
+	 * @return Number of worker threads.
+	 */
+	inline uint GetWorkerCount() const
+	{
+		return this->num_workers;
+	}
+
+	static ThreadPool *Get();
+
+private:
+	ThreadObject **workers;   ///< The worker threads.
+	uint num_workers;         ///< Number of worker threads that were started.
+
+	ThreadMutex *work_mutex;  ///< Protects the batch state below; workers wait on it for new items.
+	ThreadMutex *done_mutex;  ///< Protects #done; the caller of #Run waits on it.
+
+	ThreadPoolJobProc proc;   ///< Function to run for each item of the current batch.
+	void **items;             ///< Items of the current batch.
+	uint count;               ///< Number of items in the current batch.
+	uint next;                ///< Next item of the current batch to hand out.
+	uint done;                ///< Number of items of the current batch that are finished.
+	bool exit;                ///< The workers should terminate.
+
+	bool ProcessNextItem();
+	static void WorkerThread(void *pool);
+};
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,82 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_stats.cpp Statistics of the time the game loop spends per tick. */
+
+#include "stdafx.h"
+#include "core/math_func.hpp"
+#include "core/bitmath_func.hpp"
+#include "debug.h"
+#include "tick_stats.h"
+
+TickStats _tick_stats; ///< Statistics of the ticks of the game loop.
+
+static bool _tick_timing = false; ///< Whether the current tick is timed.
+static uint64 _tick_start;        ///< Time of the start of the current tick in microseconds.
+static uint64 _tick_lap;          ///< Time of the end of the last part of the current tick in microseconds.
+
+/**
+ * Get the time below which the given percentage of the ticks finished.
+ * As the times are kept in a histogram, this is the upper bound of the
+ * bucket the percentile falls in.
+ * @param percent The percentile, 0..100.
+ * @return Time in microseconds.
+ */
+uint32 TickStats::GetTimePercentile(uint percent) const
+{
+	if (this->ticks == 0) return 0;
+
+	uint64 wanted = ((uint64)this->ticks * percent + 99) / 100;
+	uint64 seen = 0;
+	for (uint i = 0; i < TICK_STATS_TIME_BUCKETS; i++) {
+		seen += this->time_histogram[i];
+		if (seen >= wanted) return min(1U << i, this->max_us);
+	}
+	return this->max_us;
+}
+
+/** Start timing a tick of the game loop. */
+void StartTickTiming()
+{
+	_tick_timing = true;
+	_tick_start = _tick_lap = ottd_microseconds();
+}
+
+/**
+ * Account the time since the previous part of the timed tick to the given part.
+ * Does nothing when the tick is not timed.
+ * @param part The part the time was spent in.
+ */
+void TickTimingLap(TickStatsPart part)
+{
+	if (!_tick_timing) return;
+
+	uint64 now = ottd_microseconds();
+	_tick_stats.part_us[part] += now - _tick_lap;
+	_tick_lap = now;
+}
+
+/**
+ * Stop timing the tick of the game loop and add it to the statistics.
+ * @param part The part the time since the previous part is accounted to.
+ */
+void StopTickTiming(TickStatsPart part)
+{
+	if (!_tick_timing) return;
+
+	TickTimingLap(part);
+	_tick_timing = false;
+
+	uint32 time_us = (uint32)min<uint64>(_tick_lap - _tick_start, UINT32_MAX);
+	TickStats *stats = &_tick_stats;
+	stats->ticks++;
+	stats->total_us += time_us;
+	stats->max_us = max(stats->max_us, time_us);
+	stats->time_histogram[time_us == 0 ? 0 : min<uint>(FindLastBit(time_us) + 1, TICK_STATS_TIME_BUCKETS - 1)]++;
+}
@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_stats.h Statistics of the time the game loop spends per tick. */
+
+#ifndef TICK_STATS_H
+#define TICK_STATS_H
+
+/**
+ * Number of buckets of the histogram of tick durations. Bucket 0 holds the
+ * ticks that took less than 1 microsecond, bucket i the ticks that took at
+ * least 2^(i-1) but less than 2^i microseconds.
+ */
+static const uint TICK_STATS_TIME_BUCKETS = 24;
+
+/** The parts of a tick the time is accounted to. */
+enum TickStatsPart {
+	TSP_NETWORK,   ///< Receiving and sending network packets.
+	TSP_COMMANDS,  ///< Executing the commands of the tick.
+	TSP_DATE,      ///< Animating tiles and increasing the date, including the daily and monthly loops.
+	TSP_TILE_LOOP, ///< The tile loop.
+	TSP_VEHICLES,  ///< The vehicle ticks.
+	TSP_LANDSCAPE, ///< The ticks of towns, industries, stations, companies and link graphs.
+	TSP_SCRIPTS,   ///< The AIs and the game script.
+	TSP_OTHER,     ///< Everything else, like the windows and the news.
+	TSP_END,       ///< End marker.
+};
+
+/** Statistics of the ticks of the game loop in which the game was not paused. */
+struct TickStats {
+	uint32 ticks;                                  ///< Number of timed ticks.
+	uint64 total_us;                               ///< Total time of all ticks in microseconds.
+	uint32 max_us;                                 ///< Time of the longest tick in microseconds.
+	uint32 time_histogram[TICK_STATS_TIME_BUCKETS]; ///< Number of ticks per time bucket.
+	uint64 part_us[TSP_END];                       ///< Total time per part of the ticks in microseconds.
+
+	uint32 GetTimePercentile(uint percent) const;
+};
+
+extern TickStats _tick_stats;
+
+void StartTickTiming();
+void TickTimingLap(TickStatsPart part);
+void StopTickTiming(TickStatsPart part);
+
+#endif /* TICK_STATS_H */
@@ -48,6 +48,7 @@ static inline void SetTileHeight(TileIndex tile, uint height)
 {
 	assert(tile < MapSize());
 	assert(height <= MAX_TILE_HEIGHT);
+	NotifyTileChange(tile);
 	SB(_m[tile].type_height, 0, 4, height);
 }
 
@@ -92,6 +93,7 @@ static inline TileType GetTileType(TileIndex tile)
 static inline void SetTileType(TileIndex tile, TileType type)
 {
 	assert(tile < MapSize());
+	NotifyTileChange(tile);
 	/* VOID tiles (and no others) are exactly allowed at the lower left and right
 	 * edges of the map. If _settings_game.construction.freeform_edges is true,
 	 * the upper edges of the map are also VOID tiles. */
@@ -161,6 +163,7 @@ static inline void SetTileOwner(TileIndex tile, Owner owner)
 	assert(IsValidTile(tile));
 	assert(!IsTileType(tile, MP_HOUSE));
 	assert(!IsTileType(tile, MP_INDUSTRY));
+	NotifyTileChange(tile);
 
 	SB(_m[tile].m1, 0, 5, owner);
 }
@@ -187,6 +190,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 {
 	assert(tile < MapSize());
 	assert(!IsTileType(tile, MP_VOID) || type == TROPICZONE_NORMAL);
+	NotifyTileChange(tile);
 	SB(_m[tile].m6, 0, 2, type);
 }
 
@@ -223,6 +227,7 @@ static inline byte GetAnimationFrame(TileIndex t)
 static inline void SetAnimationFrame(TileIndex t, byte frame)
 {
 	assert(IsTileType(t, MP_HOUSE) || IsTileType(t, MP_OBJECT) || IsTileType(t, MP_INDUSTRY) ||IsTileType(t, MP_STATION));
+	NotifyTileChange(t);
 	_me[t].m7 = frame;
 }
 
@@ -36,6 +36,7 @@ static inline TownID GetTownIndex(TileIndex t)
 static inline void SetTownIndex(TileIndex t, TownID index)
 {
 	assert(IsTileType(t, MP_HOUSE) || (IsTileType(t, MP_ROAD) && !IsRoadDepot(t)));
+	NotifyTileChange(t);
 	_m[t].m2 = index;
 }
 
@@ -72,6 +73,7 @@ static inline HouseID GetHouseType(TileIndex t)
 static inline void SetHouseType(TileIndex t, HouseID house_id)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	_m[t].m4 = GB(house_id, 0, 8);
 	SB(_m[t].m3, 6, 1, GB(house_id, 8, 1));
 }
@@ -94,6 +96,7 @@ static inline bool LiftHasDestination(TileIndex t)
  */
 static inline void SetLiftDestination(TileIndex t, byte dest)
 {
+	NotifyTileChange(t);
 	SetBit(_me[t].m7, 0);
 	SB(_me[t].m7, 1, 3, dest);
 }
@@ -116,6 +119,7 @@ static inline byte GetLiftDestination(TileIndex t)
  */
 static inline void HaltLift(TileIndex t)
 {
+	NotifyTileChange(t);
 	SB(_me[t].m7, 0, 4, 0);
 }
 
@@ -136,6 +140,7 @@ static inline byte GetLiftPosition(TileIndex t)
  */
 static inline void SetLiftPosition(TileIndex t, byte pos)
 {
+	NotifyTileChange(t);
 	SB(_m[t].m6, 2, 6, pos);
 }
 
@@ -158,6 +163,7 @@ static inline bool IsHouseCompleted(TileIndex t)
 static inline void SetHouseCompleted(TileIndex t, bool status)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	SB(_m[t].m3, 7, 1, !!status);
 }
 
@@ -210,6 +216,7 @@ static inline byte GetHouseConstructionTick(TileIndex t)
 static inline void IncHouseConstructionTick(TileIndex t)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	AB(_m[t].m5, 0, 5, 1);
 
 	if (GB(_m[t].m5, 3, 2) == TOWN_HOUSE_COMPLETED) {
@@ -228,6 +235,7 @@ static inline void IncHouseConstructionTick(TileIndex t)
 static inline void ResetHouseAge(TileIndex t)
 {
 	assert(IsTileType(t, MP_HOUSE) && IsHouseCompleted(t));
+	NotifyTileChange(t);
 	_m[t].m5 = 0;
 }
 
@@ -239,6 +247,7 @@ static inline void ResetHouseAge(TileIndex t)
 static inline void IncrementHouseAge(TileIndex t)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	if (IsHouseCompleted(t) && _m[t].m5 < 0xFF) _m[t].m5++;
 }
 
@@ -264,6 +273,7 @@ static inline Year GetHouseAge(TileIndex t)
 static inline void SetHouseRandomBits(TileIndex t, byte random)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	_m[t].m1 = random;
 }
 
@@ -290,6 +300,7 @@ static inline byte GetHouseRandomBits(TileIndex t)
 static inline void SetHouseTriggers(TileIndex t, byte triggers)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	SB(_m[t].m3, 0, 5, triggers);
 }
 
@@ -327,6 +338,7 @@ static inline byte GetHouseProcessingTime(TileIndex t)
 static inline void SetHouseProcessingTime(TileIndex t, byte time)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	SB(_m[t].m6, 2, 6, time);
 }
 
@@ -338,6 +350,7 @@ static inline void SetHouseProcessingTime(TileIndex t, byte time)
 static inline void DecHouseProcessingTime(TileIndex t)
 {
 	assert(IsTileType(t, MP_HOUSE));
+	NotifyTileChange(t);
 	_m[t].m6 -= 1 << 2;
 }
 
@@ -354,6 +367,7 @@ static inline void DecHouseProcessingTime(TileIndex t)
 static inline void MakeHouseTile(TileIndex t, TownID tid, byte counter, byte stage, HouseID type, byte random_bits)
 {
 	assert(IsTileType(t, MP_CLEAR));
+	NotifyTileChange(t);
 
 	SetTileType(t, MP_HOUSE);
 	_m[t].m1 = random_bits;
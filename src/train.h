@@ -47,6 +47,8 @@ void CheckTrainsLengths();
 
 void FreeTrainTrackReservation(const Train *v, TileIndex origin = INVALID_TILE, Trackdir orig_td = INVALID_TRACKDIR);
 bool TryPathReserve(Train *v, bool mark_as_stuck = false, bool first_tile_okay = false);
+void PrefetchTrainPaths();
+void ClearPrefetchedTrainPaths();
 
 int GetTrainStopLocation(StationID station_id, TileIndex tile, const Train *v, int *station_ahead, int *station_length);
 
@@ -84,8 +86,11 @@ struct Train FINAL : public GroundVehicle<Train, VEH_TRAIN> {
 	/** Ticks waiting in front of a signal, ticks being stuck or a counter for forced proceeding through signals. */
 	uint16 wait_counter;
 
+	TileIndex signal_block_tile;      ///< Tile the vehicle is counted on in the occupancy of the signal blocks, INVALID_TILE if none. Not saved.
+	TrackBitsByte signal_block_track; ///< Track the vehicle is counted on in the occupancy of the signal blocks. Not saved.
+
 	/** We don't want GCC to zero our struct! It already is zeroed and has an index! */
-	Train() : GroundVehicleBase() {}
+	Train() : GroundVehicleBase(), signal_block_tile(INVALID_TILE) {}
 	/** We want to 'destruct' the right class. */
 	virtual ~Train() { this->PreDestructor(); }
 
@@ -14,6 +14,7 @@
 #include "articulated_vehicles.h"
 #include "command_func.h"
 #include "pathfinder/npf/npf_func.h"
+#include "pathfinder/pf_stats.h"
 #include "pathfinder/yapf/yapf.hpp"
 #include "news_func.h"
 #include "company_func.h"
@@ -1565,6 +1566,8 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 		Swap(a->y_pos, b->y_pos);
 		Swap(a->tile,  b->tile);
 		Swap(a->z_pos, b->z_pos);
+		UpdateSignalBlockOccupancy(a);
+		UpdateSignalBlockOccupancy(b);
 
 		SwapTrainFlags(&a->gv_flags, &b->gv_flags);
 
@@ -1722,6 +1725,7 @@ static void AdvanceWagonsAfterSwap(Train *v)
 		if (d <= 0) {
 			leave->vehstatus &= ~VS_HIDDEN; // move it out of the depot
 			leave->track = TrackToTrackBits(GetRailDepotTrack(leave->tile));
+			UpdateSignalBlockOccupancy(leave);
 			for (int i = 0; i >= d; i--) TrainController(leave, NULL); // maybe move it, and maybe let another wagon leave
 		}
 	} else {
@@ -2137,6 +2141,7 @@ static bool CheckTrainStayInDepot(Train *v)
 
 	v->track = TRACK_BIT_X;
 	if (v->direction & 2) v->track = TRACK_BIT_Y;
+	UpdateSignalBlockOccupancy(v);
 
 	v->vehstatus &= ~VS_HIDDEN;
 	v->cur_speed = 0;
@@ -2274,12 +2279,16 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  */
 static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
 {
+	Track track;
 	switch (_settings_game.pf.pathfinder_for_trains) {
-		case VPF_NPF: return NPFTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
-		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
+		case VPF_NPF: track = NPFTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest); break;
+		case VPF_YAPF: track = YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest); break;
 
 		default: NOT_REACHED();
 	}
+
+	RecordPathfinderRequest(v, tile, enterdir, tracks, track);
+	return track;
 }
 
 /**
@@ -2699,6 +2708,96 @@ bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 }
 
 
+/**
+ * Find where the pathfinder will start when the train tries to reserve a path.
+ * This follows the same steps as #ExtendTrainReservation, but without reserving anything.
+ * @param v The train.
+ * @param origin [out] The end of the reservation at the moment the pathfinder is called.
+ * @return True if the pathfinder is likely to be called at all.
+ */
+static bool PredictTrainPathfinderOrigin(const Train *v, PBSTileInfo *origin)
+{
+	if (v->track == TRACK_BIT_DEPOT) return false;
+
+	*origin = FollowTrainReservation(v);
+	if (origin->okay && v->tile != origin->tile) return false;
+
+	CFollowTrackRail ft(v);
+
+	TileIndex tile = origin->tile;
+	Trackdir  cur_td = origin->trackdir;
+	while (ft.Follow(tile, cur_td)) {
+		if (KillFirstBit(ft.m_new_td_bits) == TRACKDIR_BIT_NONE) {
+			/* Possible signal tile. */
+			if (HasOnewaySignalBlockingTrackdir(ft.m_new_tile, FindFirstTrackdir(ft.m_new_td_bits))) return false;
+		}
+
+		if (_settings_game.pf.forbid_90_deg) {
+			ft.m_new_td_bits &= ~TrackdirCrossesTrackdirs(ft.m_old_td);
+			if (ft.m_new_td_bits == TRACKDIR_BIT_NONE) return false;
+		}
+
+		bool target_seen = ft.m_is_station || (IsTileType(ft.m_new_tile, MP_RAILWAY) && !IsPlainRail(ft.m_new_tile));
+		if (target_seen || KillFirstBit(ft.m_new_td_bits) != TRACKDIR_BIT_NONE) {
+			if (HasReservedTracks(ft.m_new_tile, TrackdirBitsToTrackBits(TrackdirReachesTrackdirs(ft.m_old_td)))) return false;
+
+			/* The reservation will end on the tile before the choice. */
+			*origin = PBSTileInfo(tile, cur_td, false);
+			return true;
+		}
+
+		tile = ft.m_new_tile;
+		cur_td = FindFirstTrackdir(ft.m_new_td_bits);
+
+		if (IsSafeWaitingPosition(v, tile, cur_td, true, _settings_game.pf.forbid_90_deg)) return false;
+		if (HasReservedTracks(tile, TrackToTrackBits(TrackdirToTrack(cur_td)))) return false;
+	}
+
+	return false;
+}
+
+/**
+ * Let YAPF search the paths of all stuck trains that will retry their path
+ * reservation this tick concurrently, before the vehicles are ticked. All
+ * searches see the state of the game at the start of the tick, so the result
+ * does not depend on the number of threads; only the reservations are done
+ * in the order of the vehicle ticks.
+ * @see YapfTrainPrefetchPaths
+ */
+void PrefetchTrainPaths()
+{
+	if (_settings_game.pf.pathfinder_for_trains != VPF_YAPF || !_settings_game.pf.yapf.rail_parallel_search) return;
+
+	SmallVector<const Train *, 64> trains;
+	SmallVector<PBSTileInfo, 64> origins;
+
+	const Train *t;
+	FOR_ALL_TRAINS(t) {
+		if (!t->IsFrontEngine() || !HasBit(t->flags, VRF_TRAIN_STUCK) || t->force_proceed != TFP_NONE) continue;
+		if ((t->vehstatus & VS_CRASHED) != 0 || ((t->vehstatus & VS_STOPPED) != 0 && t->cur_speed == 0)) continue;
+		if (t->current_order.IsType(OT_LOADING) || t->breakdown_ctr == 1 || t->breakdown_ctr == 2) continue;
+
+		/* Only trains that are at the end of their path backoff interval try to reserve a path. */
+		if ((t->wait_counter + 1) % _settings_game.pf.path_backoff_interval != 0) continue;
+
+		PBSTileInfo origin;
+		if (!PredictTrainPathfinderOrigin(t, &origin)) continue;
+
+		*trains.Append() = t;
+		*origins.Append() = origin;
+	}
+
+	YapfTrainPrefetchPaths(trains.Begin(), origins.Begin(), trains.Length());
+}
+
+/**
+ * Discard the searches of #PrefetchTrainPaths that were not needed after all.
+ */
+void ClearPrefetchedTrainPaths()
+{
+	YapfTrainClearPrefetchedPaths();
+}
+
 static bool CheckReverseTrain(const Train *v)
 {
 	if (_settings_game.difficulty.line_reverse_mode != 0 ||
@@ -3246,6 +3345,7 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 
 					v->track = chosen_track;
 					assert(v->track);
+					UpdateSignalBlockOccupancy(v);
 				}
 
 				/* We need to update signal status, but after the vehicle position hash
@@ -3455,7 +3555,7 @@ static void DeleteLastWagon(Train *v)
 
 	/* Update signals */
 	if (IsTileType(tile, MP_TUNNELBRIDGE) || IsRailDepotTile(tile)) {
-		UpdateSignalsOnSegment(tile, INVALID_DIAGDIR, owner);
+		UpdateSignalsOnSegmentLater(tile, INVALID_DIAGDIR, owner);
 	} else {
 		SetSignalsOnBothDir(tile, track, owner);
 	}
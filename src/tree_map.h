@@ -131,6 +131,7 @@ static inline uint GetTreeDensity(TileIndex t)
 static inline void SetTreeGroundDensity(TileIndex t, TreeGround g, uint d)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	SB(_m[t].m2, 4, 2, d);
 	SB(_m[t].m2, 6, 3, g);
 }
@@ -166,6 +167,7 @@ static inline uint GetTreeCount(TileIndex t)
 static inline void AddTreeCount(TileIndex t, int c)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m5 += c << 6;
 }
 
@@ -196,6 +198,7 @@ static inline uint GetTreeGrowth(TileIndex t)
 static inline void AddTreeGrowth(TileIndex t, int a)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m5 += a;
 }
 
@@ -212,6 +215,7 @@ static inline void AddTreeGrowth(TileIndex t, int a)
 static inline void SetTreeGrowth(TileIndex t, uint g)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	SB(_m[t].m5, 0, 3, g);
 }
 
@@ -241,6 +245,7 @@ static inline uint GetTreeCounter(TileIndex t)
 static inline void AddTreeCounter(TileIndex t, int a)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	_m[t].m2 += a;
 }
 
@@ -256,6 +261,7 @@ static inline void AddTreeCounter(TileIndex t, int a)
 static inline void SetTreeCounter(TileIndex t, uint c)
 {
 	assert(IsTileType(t, MP_TREES)); // XXX incomplete
+	NotifyTileChange(t);
 	SB(_m[t].m2, 0, 4, c);
 }
 
@@ -273,6 +279,7 @@ static inline void SetTreeCounter(TileIndex t, uint c)
  */
 static inline void MakeTree(TileIndex t, TreeType type, uint count, uint growth, TreeGround ground, uint density)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_TREES);
 	SetTileOwner(t, OWNER_NONE);
 	_m[t].m2 = ground << 6 | density << 4 | 0;
@@ -14,6 +14,7 @@
 
 #include "bridge_map.h"
 #include "tunnel_map.h"
+#include "pbs.h"
 
 
 /**
@@ -68,6 +69,7 @@ static inline bool HasTunnelBridgeSnowOrDesert(TileIndex t)
 static inline void SetTunnelBridgeSnowOrDesert(TileIndex t, bool snow_or_desert)
 {
 	assert(IsTileType(t, MP_TUNNELBRIDGE));
+	NotifyTileChange(t);
 	SB(_me[t].m7, 5, 1, snow_or_desert);
 }
 
@@ -107,7 +109,9 @@ static inline void SetTunnelBridgeReservation(TileIndex t, bool b)
 {
 	assert(IsTileType(t, MP_TUNNELBRIDGE));
 	assert(GetTunnelBridgeTransportType(t) == TRANSPORT_RAIL);
+	NotifyTileChange(t);
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	NotifyReservationChange(t);
 }
 
 /**
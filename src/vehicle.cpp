@@ -531,24 +531,42 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
 	}
 
-	if (old_hash == new_hash) return;
+	if (old_hash != new_hash) {
+		/* Remove from the old position in the hash table */
+		if (old_hash != NULL) {
+			if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
+			*v->hash_tile_prev = v->hash_tile_next;
+		}
 
-	/* Remove from the old position in the hash table */
-	if (old_hash != NULL) {
-		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
-		*v->hash_tile_prev = v->hash_tile_next;
-	}
+		/* Insert vehicle at beginning of the new position in the hash table */
+		if (new_hash != NULL) {
+			v->hash_tile_next = *new_hash;
+			if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
+			v->hash_tile_prev = new_hash;
+			*new_hash = v;
+		}
 
-	/* Insert vehicle at beginning of the new position in the hash table */
-	if (new_hash != NULL) {
-		v->hash_tile_next = *new_hash;
-		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
-		v->hash_tile_prev = new_hash;
-		*new_hash = v;
+		/* Remember current hash position */
+		v->hash_tile_current = new_hash;
 	}
 
-	/* Remember current hash position */
-	v->hash_tile_current = new_hash;
+	/* The tile may have changed even when the hash position did not. */
+	if (v->type == VEH_TRAIN) UpdateSignalBlockOccupancy(Train::From(v));
+}
+
+/**
+ * Get the tile on which the searches for vehicles on a tile find a vehicle.
+ * That is its tile, as long as the vehicle is in the tile hash of that tile.
+ * @param v The vehicle.
+ * @return The tile, or INVALID_TILE when the vehicle is not found on any tile.
+ */
+TileIndex GetVehicleTileInHash(const Vehicle *v)
+{
+	if (v->hash_tile_current == NULL) return INVALID_TILE;
+
+	int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
+	int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
+	return v->hash_tile_current == &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK] ? v->tile : INVALID_TILE;
 }
 
 static Vehicle *_vehicle_viewport_hash[0x1000];
@@ -582,7 +600,10 @@ static void UpdateVehicleViewportHash(Vehicle *v, int x, int y)
 void ResetVehicleHash()
 {
 	Vehicle *v;
-	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
+	FOR_ALL_VEHICLES(v) {
+		v->hash_tile_current = NULL;
+		if (v->type == VEH_TRAIN) UpdateSignalBlockOccupancy(Train::From(v));
+	}
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
 	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
 }
@@ -854,6 +875,8 @@ void CallVehicleTicks()
 	Station *st;
 	FOR_ALL_STATIONS(st) LoadUnloadStation(st);
 
+	PrefetchTrainPaths();
+
 	Vehicle *v;
 	FOR_ALL_VEHICLES(v) {
 		/* Vehicle could be deleted in this tick */
@@ -892,6 +915,11 @@ void CallVehicleTicks()
 		}
 	}
 
+	/* Do the signal updates that were left for after all vehicles moved. */
+	UpdateSignalsInBuffer();
+
+	ClearPrefetchedTrainPaths();
+
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
 		v = it->first;
@@ -1287,7 +1315,7 @@ void VehicleEnterDepot(Vehicle *v)
 			SetDepotReservation(t->tile, false);
 			if (_settings_client.gui.show_track_reservation) MarkTileDirtyByTile(t->tile);
 
-			UpdateSignalsOnSegment(t->tile, INVALID_DIAGDIR, t->owner);
+			UpdateSignalsOnSegmentLater(t->tile, INVALID_DIAGDIR, t->owner);
 			t->wait_counter = 0;
 			t->force_proceed = TFP_NONE;
 			ClrBit(t->flags, VRF_TOGGLE_REVERSE);
@@ -270,12 +270,15 @@ void VideoDriver_Dedicated::MainLoop()
 #endif
 
 	/* Load the dedicated server stuff */
-	_is_network_server = true;
+	_is_network_server = !_network_relay;
 	_network_dedicated = true;
 	_current_company = _local_company = COMPANY_SPECTATOR;
 
-	/* If SwitchMode is SM_LOAD_GAME, it means that the user used the '-g' options */
-	if (_switch_mode != SM_LOAD_GAME) {
+	/* The game of a relay comes from the relayed server, which it is joining already.
+	 * If SwitchMode is SM_LOAD_GAME, it means that the user used the '-g' options */
+	if (_network_relay) {
+		_switch_mode = SM_NONE;
+	} else if (_switch_mode != SM_LOAD_GAME) {
 		StartNewGameWithoutGUI(GENERATE_NEW_SEED);
 		SwitchToMode(_switch_mode);
 		_switch_mode = SM_NONE;
@@ -295,7 +298,7 @@ void VideoDriver_Dedicated::MainLoop()
 
 	/* Done loading, start game! */
 
-	if (!_networking) {
+	if (!_networking && !_network_relay) {
 		DEBUG(net, 0, "Dedicated server could not be started, aborting");
 		return;
 	}
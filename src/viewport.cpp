@@ -46,6 +46,8 @@
 #include "tilehighlight_func.h"
 #include "window_gui.h"
 #include "linkgraph_gui.h"
+#include "network/network.h"
+#include "network/network_func.h"
 
 #include "table/strings.h"
 #include "table/palettes.h"
@@ -972,6 +974,11 @@ static void DrawAutorailSelection(const TileInfo *ti, uint autorail_type)
  */
 static void DrawTileSelection(const TileInfo *ti)
 {
+#ifdef ENABLE_NETWORK
+	/* Highlight the tiles of own commands that still wait for the server. */
+	if (_networking && NetworkIsTilePredicted(ti->tile)) DrawTileSelectionRect(ti, PALETTE_SEL_TILE_BLUE);
+#endif /* ENABLE_NETWORK */
+
 	/* Draw a red error square? */
 	bool is_redsq = _thd.redsq == ti->tile;
 	if (is_redsq) DrawTileSelectionRect(ti, PALETTE_TILE_RED_PULSATING);
@@ -20,6 +20,7 @@
  */
 static inline void MakeVoid(TileIndex t)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_VOID);
 	SetTileHeight(t, 0);
 	_m[t].m1 = 0;
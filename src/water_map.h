@@ -118,6 +118,7 @@ static inline WaterClass GetWaterClass(TileIndex t)
 static inline void SetWaterClass(TileIndex t, WaterClass wc)
 {
 	assert(HasTileWaterClass(t));
+	NotifyTileChange(t);
 	SB(_m[t].m1, 5, 2, wc);
 }
 
@@ -353,6 +354,7 @@ static inline bool HasTileWaterGround(TileIndex t)
  */
 static inline void MakeShore(TileIndex t)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_WATER);
 	SetTileOwner(t, OWNER_WATER);
 	SetWaterClass(t, WATER_CLASS_SEA);
@@ -373,6 +375,7 @@ static inline void MakeShore(TileIndex t)
  */
 static inline void MakeWater(TileIndex t, Owner o, WaterClass wc, uint8 random_bits)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_WATER);
 	SetTileOwner(t, o);
 	SetWaterClass(t, wc);
@@ -426,6 +429,7 @@ static inline void MakeCanal(TileIndex t, Owner o, uint8 random_bits)
  */
 static inline void MakeShipDepot(TileIndex t, Owner o, DepotID did, DepotPart part, Axis a, WaterClass original_water_class)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_WATER);
 	SetTileOwner(t, o);
 	SetWaterClass(t, original_water_class);
@@ -448,6 +452,7 @@ static inline void MakeShipDepot(TileIndex t, Owner o, DepotID did, DepotPart pa
  */
 static inline void MakeLockTile(TileIndex t, Owner o, LockPart part, DiagDirection dir, WaterClass original_water_class)
 {
+	NotifyTileChange(t);
 	SetTileType(t, MP_WATER);
 	SetTileOwner(t, o);
 	SetWaterClass(t, original_water_class);